@@ -0,0 +1,210 @@
+/*
+ * ܲ׼ڰɵĸϣССģĺĺ
+ *     pg_run_opt        ģ paging.cҳû-û㷨û
+ *     pg_run_fifo       ģ paging.cҳû㷨ģʵ-Ƚȳû㷨û
+ *     pg_run_lru        ģ paging.cҳû㷨ģʵ֣δʹ㷨û
+ *     simulate_source   ģ scheduler.c̵ģʵ-ʱƬת㷨ȣRR ԣ
+ *     bk_is_safe        ģ banker.c
+ * ÿظУֱۼƼʱ 0.2 Ҳָÿβʱns/op
+ * λСֵλops/sԼ̵ڴֵpeak RSS
+ * ÿһ JSON CSV㱣֮ĸĶԱȣresult Уֵͬһ¸ĶǰӦͬ
+ *
+ * ÷bench [-csv] [-seed ] [-runs ] [ ...]
+ * ڴ̵ֵģģСУҪĳڴ棬ֻһ
+ *
+ * 붼ͨģͷļãLinux ±룺
+ *     gcc -O2 -I ../ģ bench.c bench_engine.c ../ģ/paging.c ../ģ/scheduler.c ../ģ/banker.c ../ģ/trace.c -pthread -o bench -lm
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+#define MIN_SECONDS 0.2
+#define MAX_RUNS    1000
+
+typedef struct {
+    const char* name;       // ⺯
+    const char* program;    // ڳ
+    const char* op;         // һβʲô
+    BenchFn fn;
+} BenchCase;
+
+static const BenchCase CASES[] = {
+    { "pg_run_opt", "ģ⣨ҳû-û㷨", "һη", bench_opt },
+    { "pg_run_fifo", "ģ⣨ҳû㷨ģʵ-Ƚȳû㷨", "һη", bench_fifo },
+    { "pg_run_lru", "ģ⣨ҳû㷨ģʵ֣δʹ㷨", "һη", bench_lru },
+    { "simulate_source", "ģ⣨̵ģʵ-ʱƬת㷨", "һ", bench_rr },
+    { "bk_is_safe", "ģ", "һΰȫԼ", bench_banker_engine },
+};
+#define CASE_COUNT ((int)(sizeof(CASES) / sizeof(CASES[0])))
+
+static const char* const SIZE_NAMES[3] = { "small", "medium", "large" };
+
+double bench_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+unsigned int bench_random(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+void bench_page_string(int* out, int count, int pages, int window, unsigned long long seed) {
+    unsigned long long rng = seed;
+    int base = 0;
+    if (window > pages) window = pages;
+    for (int i = 0; i < count; ++i) {
+        if (bench_random(&rng) % 1000 == 0) base = (int)(bench_random(&rng) % (unsigned int)pages);
+        else if (i % 64 == 0) base = (base + 1) % pages;
+        out[i] = bench_random(&rng) % 10 == 0 ? (int)(bench_random(&rng) % (unsigned int)pages)
+                                              : (base + (int)(bench_random(&rng) % (unsigned int)window)) % pages;
+    }
+}
+
+void bench_process_set(long long* arrival, long long* service, int n, unsigned long long seed) {
+    unsigned long long rng = seed;
+    long long t = 0;
+    for (int i = 0; i < n; ++i) {
+        t += bench_random(&rng) % 61;
+        arrival[i] = t;
+        service[i] = 1 + bench_random(&rng) % 50;
+    }
+}
+
+// ̵ڴֵKB
+static long long peak_rss_kb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return -1;
+    return (long long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+    return ru.ru_maxrss;    // Linux µλ KB
+#endif
+}
+
+static int compare_double(const void* x, const void* y) {
+    double a = *(const double*)x, b = *(const double*)y;
+    return a < b ? -1 : a > b;
+}
+
+/*
+ * һһģһУ 0 = ɹ
+ * ÿжͬһɸأУֵһ˵Ľд
+ */
+static int run_case(const BenchCase* c, int size, unsigned long long seed, int min_runs, int csv) {
+    static double ns[MAX_RUNS];
+    char params[64] = "";
+    BenchRun r;
+    long long ops = 0, result = 0;
+    double total = 0;
+    int runs = 0;
+
+    while (runs < MAX_RUNS && (runs < min_runs || total < MIN_SECONDS)) {
+        memset(&r, 0, sizeof(r));
+        if (c->fn(size, seed, params, &r) != 0 || r.ops <= 0) {
+            fprintf(stderr, "%s%sʧ\n", c->name, SIZE_NAMES[size]);
+            return 1;
+        }
+        if (runs > 0 && r.result != result) {
+            fprintf(stderr, "%s%sеУֵͬ%lld / %lld\n",
+                c->name, SIZE_NAMES[size], result, r.result);
+            return 1;
+        }
+        result = r.result;
+        ops = r.ops;
+        ns[runs++] = r.seconds * 1e9 / r.ops;
+        total += r.seconds;
+    }
+    qsort(ns, (size_t)runs, sizeof(double), compare_double);
+    double median = runs % 2 ? ns[runs / 2] : (ns[runs / 2 - 1] + ns[runs / 2]) / 2;
+
+    if (csv) {
+        printf("%s,%s,\"%s\",%llu,%lld,%d,%.2f,%.2f,%.0f,%lld,%lld\n",
+            c->name, SIZE_NAMES[size], params, seed, ops, runs, median, ns[0],
+            1e9 / median, peak_rss_kb(), result);
+    }
+    else {
+        printf("{\"bench\":\"%s\",\"size\":\"%s\",\"params\":\"%s\",\"seed\":%llu,\"ops\":%lld,"
+            "\"runs\":%d,\"ns_per_op\":%.2f,\"ns_per_op_min\":%.2f,\"ops_per_sec\":%.0f,"
+            "\"peak_rss_kb\":%lld,\"result\":%lld}\n",
+            c->name, SIZE_NAMES[size], params, seed, ops, runs, median, ns[0],
+            1e9 / median, peak_rss_kb(), result);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long long seed = 1;
+    int min_runs = 5, csv = 0, selected = 0;
+    int chosen[CASE_COUNT] = { 0 };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-csv") == 0) {
+            csv = 1;
+        }
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+            min_runs = atoi(argv[++i]);
+            if (min_runs < 1 || min_runs > MAX_RUNS) {
+                fprintf(stderr, "дӦ 1 ~ %d ֮\n", MAX_RUNS);
+                return 1;
+            }
+        }
+        else {
+            int k;
+            for (k = 0; k < CASE_COUNT && strcmp(argv[i], CASES[k].name) != 0; ++k) {
+            }
+            if (k == CASE_COUNT) {
+                fprintf(stderr, "÷%s [-csv] [-seed ] [-runs ] [ ...]\nõ", argv[0]);
+                for (k = 0; k < CASE_COUNT; ++k) {
+                    fprintf(stderr, "\n  %-18s%sÿβ = %s", CASES[k].name, CASES[k].program, CASES[k].op);
+                }
+                fprintf(stderr, "\n");
+                return 1;
+            }
+            chosen[k] = 1;
+            selected = 1;
+        }
+    }
+
+    if (csv) {
+        printf("bench,size,params,seed,ops,runs,ns_per_op,ns_per_op_min,ops_per_sec,peak_rss_kb,result\n");
+    }
+    for (int k = 0; k < CASE_COUNT; ++k) {
+        if (selected && !chosen[k]) continue;
+        for (int size = 0; size < 3; ++size) {
+            if (run_case(&CASES[k], size, seed, min_runs, csv) != 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
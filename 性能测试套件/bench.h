@@ -0,0 +1,44 @@
+/*
+ * ܲ׼Ĺӿ
+ * ĳģļ㣬 bench_engine.c ͨͷļã
+ * κγԴļṩĹߺ
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+// һμʱеĽ
+typedef struct {
+    long long ops;          // ʱɵĲ
+    double seconds;         // ʱĳ
+    long long result;       // Уֵȱҳתʱ֮͵ȣͬһģͬһӱͬ
+} BenchRun;
+
+/*
+ * ģ size0 = С1 = У2 = 󣩺׼أʱ
+ * Ȼʱһα롣params дģַ 64 ֽڣ
+ *  0 = ɹ1 = ڴ治Ƿ
+ */
+typedef int (*BenchFn)(int size, unsigned long long seed, char* params, BenchRun* run);
+
+int bench_opt(int size, unsigned long long seed, char* params, BenchRun* run);
+int bench_fifo(int size, unsigned long long seed, char* params, BenchRun* run);
+int bench_lru(int size, unsigned long long seed, char* params, BenchRun* run);
+int bench_rr(int size, unsigned long long seed, char* params, BenchRun* run);
+int bench_banker_engine(int size, unsigned long long seed, char* params, BenchRun* run);
+
+// ʱӣ룩
+double bench_now(void);
+
+// splitmix64
+unsigned int bench_random(unsigned long long* state);
+
+/*
+ * оֲԵķʴ󲿷ַһƶĴ window ҳ
+ * Լ 1/10 ķȫ pages ҳϣż
+ */
+void bench_page_string(int* out, int count, int pages, int window, unsigned long long seed);
+
+// ȸأ [0, 60] ڡʱ [1, 50] ھȷֲCPU Լ 85%
+void bench_process_set(long long* arrival, long long* service, int n, unsigned long long seed);
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * ģ⣺ paging.cscheduler.cbanker.c
+ * ҳûû paging.c ɣֱܷʴص
+ *     bench_opt   pg_runPG_OPTҳû-û㷨
+ *     bench_fifo  pg_runPG_FIFOҳû㷨ģʵ-Ƚȳû㷨
+ *     bench_lru   pg_runPG_LRUҳû㷨ģʵ֣δʹ㷨
+ *     bench_rr    simulate_sourcePOLICY_RRˡƿ̵ģʵ-ʱƬת㷨
+ *     bench_banker_engine  bk_is_safeȫ״̬ϵһΰȫԼ
+ * ʱ -I ָģ⣬ paging.cscheduler.cbanker.c
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "paging.h"
+#include "scheduler.h"
+#include "banker.h"
+#include "bench.h"
+
+static const int OPT_LENGTH[3] = { 2000, 10000, 50000 };
+static const int OPT_FRAMES[3] = { 8, 16, 32 };
+static const int OPT_PAGES[3] = { 64, 256, 1024 };
+
+// ԭ MAX_PAGESMAX_FRAMES ͬģֻıʴ
+#define FIFO_PAGES  20
+#define FIFO_FRAMES 10
+static const int FIFO_LENGTH[3] = { 10000, 100000, 1000000 };
+
+#define LRU_LENGTH 100000
+static const int LRU_PAGES[3] = { 64, 256, 1024 };
+static const int LRU_FRAMES[3] = { 8, 16, 32 };
+
+#define RR_QUANTUM 4
+static const int RR_PROCESSES[3] = { 1000, 10000, 100000 };
+
+static const int BANKER_N[3] = { 100, 1000, 10000 };
+static const int BANKER_M[3] = { 10, 50, 100 };
+
+// ɷʴڿ window ҳʱһ pg_runУֵȱҳ
+static int bench_paging(int policy, int len, int pages, int frames, int window,
+    unsigned long long seed, char* params, BenchRun* run) {
+    int* refs = (int*)malloc((size_t)len * sizeof(int));
+    PagingSim* pg = pg_create(policy, frames, pages, 0);
+
+    if (refs == NULL || pg == NULL) {
+        free(refs);
+        pg_destroy(pg);
+        return 1;
+    }
+    sprintf(params, "refs=%d pages=%d frames=%d", len, pages, frames);
+    bench_page_string(refs, len, pages, window, seed);
+
+    double t0 = bench_now();
+    long long faults = pg_run(pg, refs, len);
+    run->seconds = bench_now() - t0;
+    run->ops = len;
+    run->result = faults;
+    pg_destroy(pg);
+    free(refs);
+    return faults < 0;
+}
+
+int bench_opt(int size, unsigned long long seed, char* params, BenchRun* run) {
+    return bench_paging(PG_OPT, OPT_LENGTH[size], OPT_PAGES[size], OPT_FRAMES[size],
+        OPT_FRAMES[size] * 2, seed, params, run);
+}
+
+int bench_fifo(int size, unsigned long long seed, char* params, BenchRun* run) {
+    return bench_paging(PG_FIFO, FIFO_LENGTH[size], FIFO_PAGES, FIFO_FRAMES,
+        FIFO_FRAMES + 2, seed, params, run);
+}
+
+int bench_lru(int size, unsigned long long seed, char* params, BenchRun* run) {
+    return bench_paging(PG_LRU, LRU_LENGTH, LRU_PAGES[size], LRU_FRAMES[size],
+        LRU_FRAMES[size] * 2, seed, params, run);
+}
+
+// ȸصĽԴ± bench_process_set ɵĽ
+typedef struct {
+    const long long* arrival;
+    const long long* service;
+    int n, next;
+} ProcessLoad;
+
+static int load_next(ProcessSource* self, ProcessBase* out) {
+    ProcessLoad* l = (ProcessLoad*)self->state;
+    if (l->next == l->n) {
+        return 0;
+    }
+    memset(out, 0, sizeof(*out));
+    out->pid = l->next;
+    out->arrival_time = l->arrival[l->next];
+    out->service_time = l->service[l->next++];
+    return 1;
+}
+
+int bench_rr(int size, unsigned long long seed, char* params, BenchRun* run) {
+    int n = RR_PROCESSES[size];
+    long long* arrival = (long long*)malloc((size_t)n * sizeof(long long));
+    long long* service = (long long*)malloc((size_t)n * sizeof(long long));
+    ProcessLoad load = { arrival, service, n, 0 };
+    ProcessSource src = { load_next, NULL, NULL, &load };
+    SimConfig cfg;
+    SchedStats st;
+
+    if (arrival == NULL || service == NULL) {
+        free(arrival);
+        free(service);
+        return 1;
+    }
+    sprintf(params, "processes=%d quantum=%d", n, RR_QUANTUM);
+    bench_process_set(arrival, service, n, seed);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.ncpu = 1;
+
+    double t0 = bench_now();
+    int ret = simulate_source(&src, POLICY_RR, RR_QUANTUM, &cfg, &st, NULL);
+    run->seconds = bench_now() - t0;
+    run->ops = n;
+    run->result = (long long)st.sum_turnaround;
+    free(arrival);
+    free(service);
+    return ret;
+}
+
+/*
+ * ԭ randomSafeState(seed, 100, 0) ɵ״̬ͬMax  [0, 100] 
+ * Allocation  [0, Max] Available ȡһ˳Сֵ
+ */
+static int* random_safe_state(int n, int m, unsigned long long seed, int* max, int* alloc) {
+    int* perm = (int*)malloc((size_t)n * sizeof(int));
+    int* released = (int*)calloc((size_t)m, sizeof(int));
+    int* available = (int*)calloc((size_t)m, sizeof(int));
+    unsigned long long rng = seed;
+
+    if (perm == NULL || released == NULL || available == NULL) {
+        free(perm);
+        free(released);
+        free(available);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < m; j++) {
+            max[i * m + j] = (int)(bench_random(&rng) % 101u);
+            alloc[i * m + j] = (int)(bench_random(&rng) % (unsigned int)(max[i * m + j] + 1));
+        }
+        perm[i] = i;
+    }
+    for (int i = n - 1; i > 0; i--) {
+        int k = (int)(bench_random(&rng) % (unsigned int)(i + 1));
+        int t = perm[i];
+        perm[i] = perm[k];
+        perm[k] = t;
+    }
+    for (int k = 0; k < n; k++) {
+        int i = perm[k];
+        for (int j = 0; j < m; j++) {
+            int need = max[i * m + j] - alloc[i * m + j];
+            if (need - released[j] > available[j]) {
+                available[j] = need - released[j];
+            }
+            released[j] += alloc[i * m + j];
+        }
+    }
+    free(perm);
+    free(released);
+    return available;
+}
+
+int bench_banker_engine(int size, unsigned long long seed, char* params, BenchRun* run) {
+    int n = BANKER_N[size], m = BANKER_M[size];
+    int* max = (int*)malloc((size_t)n * m * sizeof(int));
+    int* alloc = (int*)malloc((size_t)n * m * sizeof(int));
+    int* seq = (int*)malloc((size_t)n * sizeof(int));
+    int* available = NULL;
+    Banker* bk = NULL;
+    int k, reps, safe = 0, ret = 1;
+
+    // ÿμʱԼ 2000 Σ, Դ
+    reps = (int)(20000000LL / ((long long)n * m));
+    if (reps < 1) reps = 1;
+    sprintf(params, "n=%d m=%d checks=%d", n, m, reps);
+    if (max == NULL || alloc == NULL || seq == NULL ||
+        (available = random_safe_state(n, m, seed, max, alloc)) == NULL ||
+        (bk = bk_create(n, m, available, max, alloc)) == NULL) {
+        goto done;
+    }
+
+    double t0 = bench_now();
+    for (k = 0; k < reps; k++) {
+        safe += bk_is_safe(bk, seq);
+    }
+    run->seconds = bench_now() - t0;
+    run->ops = reps;
+    run->result = safe == reps ? seq[0] : -1;
+    ret = 0;
+done:
+    bk_destroy(bk);
+    free(available);
+    free(seq);
+    free(alloc);
+    free(max);
+    return ret;
+}
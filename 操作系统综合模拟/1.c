@@ -0,0 +1,308 @@
+/*
+ * ϵͳۺģ⣺ʱƬת + ҳ
+ * ģĵ棨ʱƬתԣȽ̣PagingSim ȫ̹֡ȫ LRU û
+ * ÿһʱ䵥λһڴʣоͼȱҳʱҳ룬
+ * ҳɴͣһֻһŶʱҲCPU еĽ̡
+ * ϵͳ̶ֹĶ̶ȣһҵɾͷҳͬһʱ̷Žһҵ
+ * ÿ֡ɨ̶ȣCPU ʡȱҳʺʹʣ۲춶
+ * ̶ȳ֡ / ֮ȱҳѽ̶ڴϣCPU ʺһ½
+ *
+ * иļʱossim trace.jsonÿģʱд Chrome trace
+ * ÿģһ̣CPU ϵƬΡлռɵ¼
+ * ټȱҳͻ̹ҳ洫͡
+ *
+ * ʱ -I ָģ⣬Linux £
+ *     gcc -O2 -pthread -I ../ģ 1.c ../ģ/paging.c ../ģ/scheduler.c ../ģ/trace.c -o ossim -lm
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "paging.h"
+#include "scheduler.h"
+#include "trace.h"
+
+#define VPAGES      64      // ÿ̵ҳ
+#define WINDOW      12      // ֲ̾ԴڵҳԼô
+#define PHASE       200     // ÿôηʴŲһҳ
+#define QUANTUM     10
+#define SWITCH_COST 1
+#define MAX_MPL     64
+#define MAX_FRAME_COUNTS 16
+#define TRACE_RING  (1 << 16)   // ÿٻ¼
+
+// ٹˣѺ 0 ڹ 0 ϣһ
+#define TRACK_CPU   0
+#define TRACK_DISK  1
+
+typedef struct {
+    int slot;               // ռõĽ̲ۣҳ v Ӧȫҳ slot * VPAGES + v
+    int base;               // ֲԴڵ
+    int page;               // ȱҳ·ʵҳ
+    int pending;            // 1 = page ûʳɹ
+    long long refs;         // Ѿɵķʴ
+    long long service;      // ܹҪķʴ
+    unsigned long long rng;
+} Job;
+
+typedef struct {
+    PagingSim* pg;
+    Job* jobs;              // 
+    int job_count, added;
+    int* free_slots;        // ճĽ̲ۣԼճʱ
+    long long* free_at;
+    int nfree;
+    long long service_min, service_max;
+    long long latency;      // һҳ洫͵Ĵʱ
+    long long disk_free;    // ̿еʱ
+    long long disk_busy;
+    long long faults;
+    unsigned long long rng; // ҵ
+    TrRing* ring;           // Ϊ NULL ʱ
+    int trace_pid;
+    long long now;          // ڴķʷʱ
+} System;
+
+// splitmix64
+static unsigned int next_random(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+// ̵һηʣ󲿷ڴڻƶԼ 2% ķַռ
+static int next_page(Job* j) {
+    if (j->refs % PHASE == 0) {
+        j->base = (j->base + 1) % VPAGES;
+    }
+    if (next_random(&j->rng) % 50 == 0) {
+        return (int)(next_random(&j->rng) % VPAGES);
+    }
+    return (j->base + (int)(next_random(&j->rng) % WINDOW)) % VPAGES;
+}
+
+/*
+ * ԴпյĽ̲۾ڲۿճʱ̷Žһҵ
+ * ۶ռʱĳҵɣSOURCE_LATER̶ȱֲ
+ */
+static int next_job(ProcessSource* self, ProcessBase* out) {
+    System* s = (System*)self->state;
+    if (s->added == s->job_count) {
+        return 0;
+    }
+    if (s->nfree == 0) {
+        return SOURCE_LATER;
+    }
+    int idx = s->added++;
+    Job* j = &s->jobs[idx];
+    s->nfree--;
+    memset(j, 0, sizeof(Job));
+    j->slot = s->free_slots[s->nfree];
+    j->service = s->service_min +
+        next_random(&s->rng) % (unsigned int)(s->service_max - s->service_min + 1);
+    j->base = (int)(next_random(&s->rng) % VPAGES);
+    j->rng = s->rng * 31 + (unsigned long long)idx;
+    memset(out, 0, sizeof(*out));
+    out->pid = idx;
+    out->arrival_time = s->free_at[s->nfree];
+    out->service_time = j->service;
+    return 1;
+}
+
+/*
+ *  idx  now  slice ʱ䵥λÿλһηʡ
+ * ȱҳʱҳװ֡ռסλã̴ɺ·һҳ
+ * ڼһҳֱĽ̼ȥ󻹻ȱҳǶ
+ */
+static long long run_job(ProcessSource* self, long long seq, long long now, long long slice, long long* block) {
+    System* s = (System*)self->state;
+    int idx = (int)seq;
+    Job* j = &s->jobs[idx];
+    long long ran = 0;
+    while (ran < slice) {
+        if (!j->pending) {
+            j->page = next_page(j);
+            j->pending = 1;
+        }
+        s->now = now + ran;
+        if (pg_access(s->pg, j->slot * VPAGES + j->page) == 1) {
+            j->pending = 0;
+            j->refs++;
+            ran++;
+            continue;
+        }
+        long long t = now + ran;
+        long long start = s->disk_free > t ? s->disk_free : t;
+        s->disk_free = start + s->latency;
+        s->disk_busy += s->latency;
+        s->faults++;
+        *block = s->disk_free - t;
+        if (s->ring != NULL) {
+            tr_instant(s->ring, s->trace_pid, TRACK_CPU, t, "fault P", idx, "page", j->page);
+            tr_slice(s->ring, s->trace_pid, TRACK_DISK, start, s->latency, "page-in P", idx);
+        }
+        break;
+    }
+    return ran;
+}
+
+// ʱ¼Ǳȫҳ
+static void on_page(void* user, const PgEvent* ev) {
+    System* s = (System*)user;
+    if (ev->victim >= 0) {
+        tr_instant(s->ring, s->trace_pid, TRACK_CPU, s->now, "evict", -1, "page", ev->victim);
+    }
+}
+
+// ҵʱͷҳ̲һҵ
+static void finish_job(ProcessSource* self, long long seq, const ProcessBase* p, const ProcessRun* r) {
+    System* s = (System*)self->state;
+    int slot = s->jobs[seq].slot;
+    (void)p;
+    for (int v = 0; v < VPAGES; ++v) {
+        pg_release(s->pg, slot * VPAGES + v);
+    }
+    s->free_slots[s->nfree] = slot;
+    s->free_at[s->nfree++] = r->finish_time;
+}
+
+typedef struct {
+    double throughput;      // ÿ 1000 ʱ䵥λɵҵ
+    double cpu_util;
+    double fault_rate;      // ÿ 1000 ηʵȱҳ
+    double disk_util;
+    double turnaround;
+} Result;
+
+// һģ⣻ring Ϊ NULL ʱʱ߼ǵٽ trace_pid ¡ 0 = ɹ
+static int run_system(int frames, int mpl, int job_count, long long service_min, long long service_max,
+    long long latency, unsigned long long seed, TrRing* ring, int trace_pid, Result* res) {
+    System s;
+    ProcessSource src = { next_job, finish_job, run_job, &s };
+    SimConfig cfg;
+    SchedStats st;
+    int ret = 1;
+
+    memset(&s, 0, sizeof(s));
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.ncpu = 1;
+    cfg.switch_cost = SWITCH_COST;
+    cfg.trace = ring;
+    cfg.trace_pid = trace_pid;
+    s.job_count = job_count;
+    s.service_min = service_min;
+    s.service_max = service_max;
+    s.latency = latency;
+    s.rng = seed;
+    s.ring = ring;
+    s.trace_pid = trace_pid;
+    s.jobs = (Job*)malloc((size_t)job_count * sizeof(Job));
+    s.free_slots = (int*)malloc((size_t)mpl * sizeof(int));
+    s.free_at = (long long*)calloc((size_t)mpl, sizeof(long long));
+    s.pg = pg_create(PG_LRU, frames, mpl * VPAGES, 0);
+    if (s.jobs != NULL && s.free_slots != NULL && s.free_at != NULL && s.pg != NULL) {
+        if (ring != NULL) {
+            pg_set_callback(s.pg, on_page, &s);
+        }
+        // ʼʱ mpl ۶ţѹջҵ 0 ռ 0
+        for (int k = mpl - 1; k >= 0; --k) {
+            s.free_slots[s.nfree++] = k;
+        }
+        ret = simulate_source(&src, POLICY_RR, QUANTUM, &cfg, &st, NULL);
+        ret |= st.processes != job_count;
+    }
+    if (ret == 0) {
+        long long refs = 0;
+        for (int i = 0; i < job_count; ++i) {
+            refs += s.jobs[i].refs;
+        }
+        res->throughput = 1000.0 * job_count / st.makespan;
+        res->cpu_util = (double)st.busy_time / st.makespan;
+        res->fault_rate = 1000.0 * s.faults / refs;
+        res->disk_util = (double)s.disk_busy / st.makespan;
+        res->turnaround = st.sum_turnaround / job_count;
+    }
+    free(s.jobs);
+    free(s.free_slots);
+    free(s.free_at);
+    pg_destroy(s.pg);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    int job_count, max_mpl, frame_count = 0, frames[MAX_FRAME_COUNTS];
+    long long service, latency;
+    unsigned long long seed;
+    static Result res[MAX_MPL + 1];
+    Tracer* tracer = NULL;
+    TrRing* ring = NULL;
+
+    printf("=========== ϵͳۺģ⣺ҳ ===========\n");
+    printf("ÿ %d ҳֲԴ %d ҳʱƬ %dл %dȫ LRU ûҳ\n",
+        VPAGES, WINDOW, QUANTUM, SWITCH_COST);
+    printf(" ҵ ÿҵƽʴ ̴ʱ ̶(<= %d) : ", MAX_MPL);
+    if (scanf("%d %lld %lld %d %llu", &job_count, &service, &latency, &max_mpl, &seed) != 5 ||
+        job_count <= 0 || service <= 0 || latency <= 0 || max_mpl <= 0 || max_mpl > MAX_MPL) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    printf("ҪȽϵ֡ %d  0 : ", MAX_FRAME_COUNTS);
+    while (frame_count < MAX_FRAME_COUNTS && scanf("%d", &frames[frame_count]) == 1 && frames[frame_count] > 0) {
+        frame_count++;
+    }
+    if (frame_count == 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    if (argc > 1) {
+        tracer = tr_open(argv[1], TRACE_RING);
+        ring = tracer != NULL ? tr_ring(tracer) : NULL;
+        if (ring == NULL) {
+            printf("޷ļ %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    for (int k = 0; k < frame_count; ++k) {
+        int best = 1;
+        printf("\n===== ֡ = %dԼ %d =====\n", frames[k], frames[k] / WINDOW);
+        printf("̶\t(ҵ/ǧλ)\tCPU\tȱҳ/ǧη\t\tƽת\n");
+        for (int mpl = 1; mpl <= max_mpl; ++mpl) {
+            // ͬһӣÿ̶ܵͬһҵ
+            int pid = k * max_mpl + mpl;
+            if (tracer != NULL) {
+                char name[64];
+                sprintf(name, "frames=%d mpl=%d", frames[k], mpl);
+                tr_name(tracer, pid, -1, name);
+                tr_name(tracer, pid, TRACK_CPU, "CPU 0");
+                tr_name(tracer, pid, TRACK_DISK, "paging disk");
+            }
+            if (run_system(frames[k], mpl, job_count, service / 2, service * 3 / 2, latency, seed,
+                ring, pid, &res[mpl]) != 0) {
+                printf("ģʧܣڴ治㣩\n");
+                return 1;
+            }
+            if (res[mpl].throughput > res[best].throughput) {
+                best = mpl;
+            }
+        }
+        for (int mpl = 1; mpl <= max_mpl; ++mpl) {
+            const Result* r = &res[mpl];
+            printf("%d\t\t%.3f\t\t\t%6.2f%%\t\t%8.2f\t%6.2f%%\t\t%.0f%s\n", mpl, r->throughput,
+                100.0 * r->cpu_util, r->fault_rate, 100.0 * r->disk_util, r->turnaround,
+                mpl == best ? "\t " :
+                mpl > best && r->throughput < res[best].throughput / 2 ? "\t " : "");
+        }
+    }
+    if (tracer != NULL) {
+        TrStats ts;
+        if (tr_close(tracer, &ts) != 0) {
+            printf("\nдļ %s \n", argv[1]);
+            return 1;
+        }
+        printf("\nʱд %s%lld ¼ȴ %lld Σ chrome://tracing  ui.perfetto.dev 򿪣\n",
+            argv[1], ts.events, ts.stalls);
+    }
+    return 0;
+}
@@ -0,0 +1,750 @@
+/*
+ * ̵߳õľУ/ߣMPMC
+ * 1. нУVyukov Ż飬ÿ۴һţ/Ӹһ CAS
+ * 2. ޽ֶζУ fetch-and-add ȡ±꣬˹¶ΣFAA У
+ * 3. 飺ʱƬתģѭмһѻ
+ * ׼ 1~64 ߳±Ƚߵ£УûжʧظԪأ
+ * ÿ߳̽ӡӣ̷ֳٰ߳ߺ롣
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define CACHE_LINE  64
+#define MAX_THREADS 64
+
+/* ---------------- ԭӲ̵߳ƽ̨װ ---------------- */
+
+#ifdef _WIN32
+typedef volatile LONG64 atomic_ll;
+// x86/x64  MSVC  volatile дȡ/ͷ
+#define load_acquire(p)         (*(p))
+#define store_release(p, v)     (*(p) = (v))
+#define fetch_add(p, v)         InterlockedExchangeAdd64((p), (v))
+#define exchange(p, v)          InterlockedExchange64((p), (v))
+#define cas(p, expected, desired) \
+    (InterlockedCompareExchange64((p), (desired), (expected)) == (expected))
+#define cas_ptr(p, expected, desired) \
+    (InterlockedCompareExchangePointer((PVOID volatile*)(p), (desired), (expected)) == (expected))
+#define fence()                 MemoryBarrier()
+#define cpu_relax()             YieldProcessor()
+#else
+typedef volatile long long atomic_ll;
+#define load_acquire(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define fetch_add(p, v)         __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define exchange(p, v)          __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#define cas(p, expected, desired) \
+    __sync_bool_compare_and_swap((p), (expected), (desired))
+#define cas_ptr(p, expected, desired) \
+    __sync_bool_compare_and_swap((p), (expected), (desired))
+#define fence()                 __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define cpu_relax()             sched_yield()
+#endif
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+#define THREAD_RET DWORD WINAPI
+#define THREAD_RET_VALUE 0
+#define mutex_init(m)    InitializeCriticalSection(m)
+#define mutex_destroy(m) DeleteCriticalSection(m)
+#define mutex_lock(m)    EnterCriticalSection(m)
+#define mutex_unlock(m)  LeaveCriticalSection(m)
+#else
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+#define THREAD_RET void*
+#define THREAD_RET_VALUE NULL
+#define mutex_init(m)    pthread_mutex_init((m), NULL)
+#define mutex_destroy(m) pthread_mutex_destroy(m)
+#define mutex_lock(m)    pthread_mutex_lock(m)
+#define mutex_unlock(m)  pthread_mutex_unlock(m)
+#endif
+
+static int thread_start(thread_t* t, THREAD_RET (*fn)(void*), void* arg) {
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t == NULL;
+#else
+    return pthread_create(t, NULL, fn, arg) != 0;
+#endif
+}
+
+static void thread_join(thread_t t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+static double now_sec(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+static void* aligned_calloc(size_t size) {
+#ifdef _WIN32
+    void* p = _aligned_malloc(size, CACHE_LINE);
+#else
+    void* p = NULL;
+    if (posix_memalign(&p, CACHE_LINE, size) != 0) p = NULL;
+#endif
+    if (p != NULL) memset(p, 0, size);
+    return p;
+}
+
+static void aligned_free(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+/* ---------------- 1. н MPMC УVyukov ----------------
+ *  i  seq
+ *   seq == pos       ղۣȴ pos 
+ *   seq == pos + 1   д룬ȴ pos γ
+ * Ӻ seq Ϊ pos + һȦߡ
+ * /λ÷ֱڶĻϣߺ߻α
+ */
+typedef struct {
+    atomic_ll seq;
+    int value;
+} Cell;
+
+typedef struct {
+    Cell* cells;
+    long long mask;
+    char pad0[CACHE_LINE];
+    atomic_ll enqueue_pos;
+    char pad1[CACHE_LINE - sizeof(atomic_ll)];
+    atomic_ll dequeue_pos;
+    char pad2[CACHE_LINE - sizeof(atomic_ll)];
+} BoundedQueue;
+
+// capacity Ϊ 2 ݣ 0=ɹ
+int bq_init(BoundedQueue* q, long long capacity) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        return 1;
+    }
+    q->cells = (Cell*)aligned_calloc((size_t)capacity * sizeof(Cell));
+    if (q->cells == NULL) {
+        return 1;
+    }
+    for (long long i = 0; i < capacity; ++i) {
+        q->cells[i].seq = i;
+    }
+    q->mask = capacity - 1;
+    q->enqueue_pos = 0;
+    q->dequeue_pos = 0;
+    return 0;
+}
+
+void bq_free(BoundedQueue* q) {
+    aligned_free(q->cells);
+    q->cells = NULL;
+}
+
+//  0=ɹ1=
+int bq_enqueue(BoundedQueue* q, int value) {
+    long long pos = load_acquire(&q->enqueue_pos);
+    Cell* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        long long diff = load_acquire(&cell->seq) - pos;
+        if (diff == 0) {
+            if (cas(&q->enqueue_pos, pos, pos + 1)) {
+                break;
+            }
+            pos = load_acquire(&q->enqueue_pos);
+        }
+        else if (diff < 0) {
+            return 1;
+        }
+        else {
+            pos = load_acquire(&q->enqueue_pos);
+        }
+    }
+    cell->value = value;
+    store_release(&cell->seq, pos + 1);
+    return 0;
+}
+
+//  0=ɹ1=п
+int bq_dequeue(BoundedQueue* q, int* value) {
+    long long pos = load_acquire(&q->dequeue_pos);
+    Cell* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        long long diff = load_acquire(&cell->seq) - (pos + 1);
+        if (diff == 0) {
+            if (cas(&q->dequeue_pos, pos, pos + 1)) {
+                break;
+            }
+            pos = load_acquire(&q->dequeue_pos);
+        }
+        else if (diff < 0) {
+            return 1;
+        }
+        else {
+            pos = load_acquire(&q->dequeue_pos);
+        }
+    }
+    *value = cell->value;
+    store_release(&cell->seq, pos + q->mask + 1);
+    return 0;
+}
+
+/* ---------------- 2. ޽ֶ MPMC  ----------------
+ * ÿ SEGMENT_SIZE ۡ߶Զε enq_idx  fetch-and-add һ±꣬
+ *  CAS ֵдղۣͬ±꣬ýѲ۱Ϊ TAKEN ȡֵ
+ * ȰѲ۱ǵӦ CAS ʧܺ±꣬ԲᶪԪء
+ * ±͹¶Ρ
+ *
+ * Խľɶο߳ڶüԪepochգ
+ *   ÿ߳̽/ʱǼǵǰȫּԪ˳ʱ
+ *    head ߵĳ߰ѾɶιҵԼĴϣµʱȫּԪ e
+ *   ڲ̶߳ѵǼǵǰԪʱȫּԪ 1
+ *   ȫּԪ e + 2 ʱǼ e ֮ǰ̶߳˳ɶηŽ̹߳Ŀնγأ¶ʱȴӳȡ
+ * ߺ߷ֿʱժεߡҶεߣԳر빲ÿ߳һ
+ * ռõڴֻʱĳȺ߳йأۼƲ޹ء
+ * ɶժ֮ǰȱ֤ tail Խ֮½߳̾Ҳò
+ *
+ * նγһ Treiber ջӳȡε߳ѵǼǼԪαȡߺҪԪſܻص
+ * ȡε CAS ϡͬһαȡַŻء ABAҲ϶е¶߳´ãֱӷŻس
+ */
+#define SEGMENT_SIZE 1024
+#define SLOT_EMPTY   0LL
+#define SLOT_TAKEN   (-1LL)         //  value + 10  -1 
+
+typedef struct Segment {
+    atomic_ll deq_idx;
+    char pad0[CACHE_LINE - sizeof(atomic_ll)];
+    atomic_ll enq_idx;
+    char pad1[CACHE_LINE - sizeof(atomic_ll)];
+    struct Segment* volatile next;
+    struct Segment* retired_next;   //  / նγ
+    long long retired_epoch;
+    atomic_ll slots[SEGMENT_SIZE];
+} Segment;
+
+// ÿ̵߳ļԪ¼ռһУֻб߳д
+typedef struct {
+    atomic_ll epoch;                // (ǼǵļԪ << 1) | 10 = ڶв
+    Segment* limbo;                 // յĶΣµǰ
+    Segment* spare;                 // û϶е¶Σ´ιҶʱֱ
+    char pad[CACHE_LINE - sizeof(atomic_ll) - 2 * sizeof(Segment*)];
+} SqThread;
+
+typedef struct {
+    Segment* volatile head;
+    char pad0[CACHE_LINE - sizeof(Segment*)];
+    Segment* volatile tail;
+    char pad1[CACHE_LINE - sizeof(Segment*)];
+    atomic_ll epoch;                // ȫּԪ
+    char pad2[CACHE_LINE - sizeof(atomic_ll)];
+    Segment* volatile pool;         // նγأ retired_next 
+    char pad3[CACHE_LINE - sizeof(Segment*)];
+    SqThread* threads;
+    int nthreads;
+} SegmentedQueue;
+
+// ȡһĿնΣñ߳µģٴӳȡûвŷ䣻ѵǼǼԪ
+static Segment* segment_new(SegmentedQueue* q, SqThread* t) {
+    Segment* s = t->spare;
+    t->spare = NULL;
+    while (s == NULL) {
+        s = load_acquire(&q->pool);
+        if (s == NULL) {
+            return (Segment*)aligned_calloc(sizeof(Segment));
+        }
+        if (!cas_ptr(&q->pool, s, s->retired_next)) {
+            s = NULL;
+        }
+    }
+    memset(s, 0, sizeof(Segment));
+    return s;
+}
+
+static void segment_free_list(Segment* s) {
+    while (s != NULL) {
+        Segment* next = s->retired_next;
+        aligned_free(s);
+        s = next;
+    }
+}
+
+// ̺߳ 0 ~ nthreads-1 0=ɹ
+int sq_init(SegmentedQueue* q, int nthreads) {
+    q->threads = (SqThread*)aligned_calloc((size_t)nthreads * sizeof(SqThread));
+    q->nthreads = nthreads;
+    q->epoch = 0;
+    q->pool = NULL;
+    Segment* s = (Segment*)aligned_calloc(sizeof(Segment));
+    q->head = s;
+    q->tail = s;
+    if (q->threads == NULL || s == NULL) {
+        aligned_free(q->threads);
+        aligned_free(s);
+        return 1;
+    }
+    return 0;
+}
+
+void sq_free(SegmentedQueue* q) {
+    Segment* s = q->head;
+    while (s != NULL) {
+        Segment* next = s->next;
+        aligned_free(s);
+        s = next;
+    }
+    for (int i = 0; i < q->nthreads; ++i) {
+        segment_free_list(q->threads[i].limbo);
+        aligned_free(q->threads[i].spare);
+    }
+    segment_free_list(q->pool);
+    aligned_free(q->threads);
+    q->head = q->tail = NULL;
+    q->pool = NULL;
+    q->threads = NULL;
+}
+
+// ǼǵǰԪ֮Ķ˳ǰᱻ
+static void sq_enter(SegmentedQueue* q, SqThread* t) {
+    store_release(&t->epoch, (load_acquire(&q->epoch) << 1) | 1);
+    fence();                        // ǼǱ֮ head/tail
+}
+
+static void sq_exit(SqThread* t) {
+    store_release(&t->epoch, 0);
+}
+
+// ڲ̶߳Ǽǵ˵ǰԪͰȫּԪ 1
+static void sq_try_advance(SegmentedQueue* q) {
+    long long e = load_acquire(&q->epoch);
+    for (int i = 0; i < q->nthreads; ++i) {
+        long long te = load_acquire(&q->threads[i].epoch);
+        if (te != 0 && (te >> 1) != e) {
+            return;
+        }
+    }
+    cas(&q->epoch, e, e + 1);
+}
+
+// ɶѴӶժ£ҵ̵߳ĴٰѹԪĶŽնγ
+static void sq_retire(SegmentedQueue* q, SqThread* t, Segment* s) {
+    s->retired_epoch = load_acquire(&q->epoch);
+    s->retired_next = t->limbo;
+    t->limbo = s;
+    sq_try_advance(q);
+
+    // ժµȺУµǰҵһɻյĶΣĶɻ
+    long long e = load_acquire(&q->epoch);
+    Segment** link = &t->limbo;
+    while (*link != NULL && (*link)->retired_epoch + 2 > e) {
+        link = &(*link)->retired_next;
+    }
+    Segment* old = *link;
+    if (old == NULL) {
+        return;
+    }
+    *link = NULL;
+    Segment* last = old;
+    while (last->retired_next != NULL) {
+        last = last->retired_next;
+    }
+    for (;;) {
+        Segment* top = load_acquire(&q->pool);
+        last->retired_next = top;
+        if (cas_ptr(&q->pool, top, old)) {
+            break;
+        }
+    }
+}
+
+//  0=ɹ1=ڴ治
+int sq_enqueue(SegmentedQueue* q, int tid, int value) {
+    SqThread* t = &q->threads[tid];
+    long long item = (long long)value + 1;
+    int result = 0;
+    sq_enter(q, t);
+    for (;;) {
+        Segment* tail = load_acquire(&q->tail);
+        long long idx = fetch_add(&tail->enq_idx, 1);
+        if (idx < SEGMENT_SIZE) {
+            if (cas(&tail->slots[idx], SLOT_EMPTY, item)) {
+                break;
+            }
+            continue;                       // òѱ߱ϣ±
+        }
+
+        // æƽ tailһԱԪؿͷ¶
+        if (tail != load_acquire(&q->tail)) {
+            continue;
+        }
+        Segment* next = load_acquire(&tail->next);
+        if (next != NULL) {
+            cas_ptr(&q->tail, tail, next);
+            continue;
+        }
+        Segment* s = segment_new(q, t);
+        if (s == NULL) {
+            result = 1;
+            break;
+        }
+        s->enq_idx = 1;
+        s->slots[0] = item;
+        if (cas_ptr(&tail->next, NULL, s)) {
+            cas_ptr(&q->tail, tail, s);
+            break;
+        }
+        t->spare = s;                       // ûϣ߳̿´
+    }
+    sq_exit(t);
+    return result;
+}
+
+//  0=ɹ1=п
+int sq_dequeue(SegmentedQueue* q, int tid, int* value) {
+    SqThread* t = &q->threads[tid];
+    int result = 1;
+    sq_enter(q, t);
+    for (;;) {
+        Segment* head = load_acquire(&q->head);
+        if (load_acquire(&head->deq_idx) >= load_acquire(&head->enq_idx) &&
+            load_acquire(&head->next) == NULL) {
+            break;
+        }
+        long long idx = fetch_add(&head->deq_idx, 1);
+        if (idx < SEGMENT_SIZE) {
+            long long item = exchange(&head->slots[idx], SLOT_TAKEN);
+            if (item == SLOT_EMPTY) {
+                continue;                   // ߻ûд
+            }
+            *value = (int)(item - 1);
+            result = 0;
+            break;
+        }
+
+        // ȡ꣺ƵһΣtail ͣڱʱȰƽժµĶβŲٱõ
+        Segment* next = load_acquire(&head->next);
+        if (next == NULL) {
+            break;
+        }
+        if (load_acquire(&q->tail) == head) {
+            cas_ptr(&q->tail, head, next);
+            continue;
+        }
+        if (cas_ptr(&q->head, head, next)) {
+            sq_retire(q, t, head);
+        }
+    }
+    sq_exit(t);
+    return result;
+}
+
+/* ---------------- 3. 飺 + ѭ ---------------- */
+
+// ʱƬתģе Queue ͬѭ飬ʱ
+typedef struct {
+    int* data;
+    int capacity;
+    int front;
+    int count;
+    mutex_t lock;
+} LockedQueue;
+
+int lq_init(LockedQueue* q) {
+    q->capacity = 64;
+    q->data = (int*)malloc(q->capacity * sizeof(int));
+    q->front = 0;
+    q->count = 0;
+    mutex_init(&q->lock);
+    return q->data == NULL;
+}
+
+void lq_free(LockedQueue* q) {
+    free(q->data);
+    q->data = NULL;
+    mutex_destroy(&q->lock);
+}
+
+int lq_enqueue(LockedQueue* q, int value) {
+    mutex_lock(&q->lock);
+    if (q->count == q->capacity) {
+        int* d = (int*)malloc((size_t)q->capacity * 2 * sizeof(int));
+        if (d == NULL) {
+            mutex_unlock(&q->lock);
+            return 1;
+        }
+        for (int i = 0; i < q->count; ++i) {
+            d[i] = q->data[(q->front + i) % q->capacity];
+        }
+        free(q->data);
+        q->data = d;
+        q->front = 0;
+        q->capacity *= 2;
+    }
+    q->data[(q->front + q->count) % q->capacity] = value;
+    q->count++;
+    mutex_unlock(&q->lock);
+    return 0;
+}
+
+int lq_dequeue(LockedQueue* q, int* value) {
+    mutex_lock(&q->lock);
+    if (q->count == 0) {
+        mutex_unlock(&q->lock);
+        return 1;
+    }
+    *value = q->data[q->front];
+    q->front = (q->front + 1) % q->capacity;
+    q->count--;
+    mutex_unlock(&q->lock);
+    return 0;
+}
+
+/* ---------------- ׼ ---------------- */
+
+typedef enum {
+    Q_BOUNDED,
+    Q_SEGMENTED,
+    Q_LOCKED
+} QueueKind;
+
+static const char* const QUEUE_NAMES[] = { "Vyukov н", "ֶ޽", "" };
+
+typedef enum {
+    ROLE_BOTH,                      // ӡ
+    ROLE_PRODUCER,                  // ֻ
+    ROLE_CONSUMER                   // ֻ
+} Role;
+
+typedef struct {
+    QueueKind kind;
+    BoundedQueue bq;
+    SegmentedQueue sq;
+    LockedQueue lq;
+    struct Worker* workers;
+    int nthreads;
+    long long window;               // ߵԪ
+    volatile int start;             // ߳̾һʼ
+} Bench;
+
+typedef struct Worker {
+    Bench* bench;
+    int id;
+    Role role;
+    long long ops;                  // ʱΪ/ӶΪ
+    long long sum_in;               // Ԫ֮͡Ԫ֮ͣУ
+    long long sum_out;
+    long long retries;              // /ʱԴ
+    atomic_ll done;                 // ɵ߾ݴ
+} Worker;
+
+static int queue_put(Bench* b, int tid, int v) {
+    switch (b->kind) {
+    case Q_BOUNDED:   return bq_enqueue(&b->bq, v);
+    case Q_SEGMENTED: return sq_enqueue(&b->sq, tid, v);
+    default:          return lq_enqueue(&b->lq, v);
+    }
+}
+
+static int queue_get(Bench* b, int tid, int* v) {
+    switch (b->kind) {
+    case Q_BOUNDED:   return bq_dequeue(&b->bq, v);
+    case Q_SEGMENTED: return sq_dequeue(&b->sq, tid, v);
+    default:          return lq_dequeue(&b->lq, v);
+    }
+}
+
+// ߳ window Ԫؾ͵һȣ޽ԽԽ
+static void throttle(Bench* b) {
+    for (;;) {
+        long long ahead = 0;
+        for (int i = 0; i < b->nthreads; ++i) {
+            Worker* w = &b->workers[i];
+            long long done = load_acquire(&w->done);
+            ahead += w->role == ROLE_PRODUCER ? done : -done;
+        }
+        if (ahead <= b->window) {
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+/*
+ * ROLE_BOTH ߳̽ӡӣѽ̷Żؾȡһ
+ * ֻӡֻʱժκ͹Ҷεǲͬ߳
+ */
+static THREAD_RET bench_worker(void* arg) {
+    Worker* w = (Worker*)arg;
+    Bench* b = w->bench;
+    while (!load_acquire(&b->start)) {
+        cpu_relax();
+    }
+    for (long long i = 0; i < w->ops; ++i) {
+        int v = (int)((w->id * 7919LL + i) & 0x3FFFFFFF);
+        if (w->role != ROLE_CONSUMER) {
+            while (queue_put(b, w->id, v) != 0) {
+                w->retries++;
+                cpu_relax();
+            }
+            w->sum_in += v;
+        }
+        if (w->role != ROLE_PRODUCER) {
+            while (queue_get(b, w->id, &v) != 0) {
+                w->retries++;
+                cpu_relax();
+            }
+            w->sum_out += v;
+        }
+        if (w->role != ROLE_BOTH) {
+            store_release(&w->done, i + 1);
+            if (w->role == ROLE_PRODUCER && (i & 63) == 63) {
+                throttle(b);
+            }
+        }
+    }
+    return THREAD_RET_VALUE;
+}
+
+/*
+ *  nthreads ߳ total_ops /ӣÿӡӸһΣ
+ * split = 1 ʱǰһֻ߳ӡֻӣnthreads >= 2 capacity Ԫ
+ * ڴ治㡢̴߳ʧܡУ鲻ظ
+ */
+static double run_bench(QueueKind kind, int nthreads, long long total_ops, long long capacity, int split) {
+    Bench b;
+    Worker workers[MAX_THREADS];
+    thread_t threads[MAX_THREADS];
+    int producers = nthreads / 2;
+    long long produced = split ? total_ops / producers * producers : 0;
+    memset(&b, 0, sizeof(b));
+    memset(workers, 0, sizeof(workers));
+    b.kind = kind;
+    b.workers = workers;
+    b.nthreads = nthreads;
+    b.window = capacity;
+    int error = kind == Q_BOUNDED ? bq_init(&b.bq, capacity)
+        : kind == Q_SEGMENTED ? sq_init(&b.sq, nthreads) : lq_init(&b.lq);
+    if (error) {
+        return -1;
+    }
+
+    int started = 0;
+    for (int i = 0; i < nthreads; ++i) {
+        workers[i].bench = &b;
+        workers[i].id = i;
+        if (!split) {
+            workers[i].role = ROLE_BOTH;
+            workers[i].ops = total_ops / nthreads;
+        }
+        else if (i < producers) {
+            workers[i].role = ROLE_PRODUCER;
+            workers[i].ops = total_ops / producers;
+        }
+        else {
+            // ƽӵȫԪ
+            int k = i - producers, consumers = nthreads - producers;
+            workers[i].role = ROLE_CONSUMER;
+            workers[i].ops = produced / consumers + (k < produced % consumers);
+        }
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        if (thread_start(&threads[i], bench_worker, &workers[i]) != 0) {
+            error = 1;
+            break;
+        }
+        started++;
+    }
+    double t0 = now_sec();
+    store_release(&b.start, 1);
+    for (int i = 0; i < started; ++i) {
+        thread_join(threads[i]);
+    }
+    double elapsed = now_sec() - t0;
+
+    // ߳ӦΪգҳ֮͵֮
+    long long sum_in = 0, sum_out = 0, ops = 0;
+    for (int i = 0; i < started; ++i) {
+        sum_in += workers[i].sum_in;
+        sum_out += workers[i].sum_out;
+        ops += workers[i].role == ROLE_BOTH ? 2 * workers[i].ops : workers[i].ops;
+    }
+    int v;
+    if (queue_get(&b, 0, &v) == 0 || sum_in != sum_out) {
+        printf("Уʧܣ%s жʧظԪ\n", QUEUE_NAMES[kind]);
+        error = 1;
+    }
+
+    if (kind == Q_BOUNDED) bq_free(&b.bq);
+    else if (kind == Q_SEGMENTED) sq_free(&b.sq);
+    else lq_free(&b.lq);
+    return error ? -1 : ops / elapsed;
+}
+
+int main() {
+    long long total_ops, capacity;
+    int max_threads;
+
+    printf("=========== MPMC о ===========\n");
+    printf(" ܲ н(2 ) ߳(<= %d): ", MAX_THREADS);
+    if (scanf("%lld %lld %d", &total_ops, &capacity, &max_threads) != 3 ||
+        total_ops <= 0 || capacity < 2 || (capacity & (capacity - 1)) != 0 ||
+        max_threads <= 0 || max_threads > MAX_THREADS) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    if (capacity < max_threads) {
+        printf("нӦС߳\n");
+        return 1;
+    }
+
+    for (int split = 0; split <= (max_threads >= 2); ++split) {
+        if (!split) {
+            printf("\nÿ߳̽ӡ\n");
+        }
+        else {
+            printf("\nһֻ߳ӡһֻӣ %lld Ԫأ\n", capacity);
+        }
+        printf("߳\t%s(Mops/s)\t%s(Mops/s)\t%s(Mops/s)\n",
+            QUEUE_NAMES[Q_BOUNDED], QUEUE_NAMES[Q_SEGMENTED], QUEUE_NAMES[Q_LOCKED]);
+        // ߳ 124  һ max_threads ֿʱ 2 ߳
+        for (int t = split ? 2 : 1; t <= max_threads;
+            t = t < max_threads && t * 2 > max_threads ? max_threads : t * 2) {
+            printf("%d", t);
+            for (int k = Q_BOUNDED; k <= Q_LOCKED; ++k) {
+                double r = run_bench((QueueKind)k, t, total_ops, capacity, split);
+                if (r < 0) {
+                    printf("\nʧ\n");
+                    return 1;
+                }
+                printf("\t%.2f\t\t", r / 1e6);
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,422 @@
+/*
+ * ģʾһͬʱܴɵģ
+ * 棨ҳû̵ȣʱƬתԣм㷨 K ȷģ
+ * һ߳꣬ٷָ T ߳ͬʱܡÿ¼ص
+ * ۻһɢֵܳɢб˳ܳȫͬûйȫ״̬
+ * иļʱеһְҳû͵ʱд Chrome trace trace.h
+ * ÿ߳дԼĻÿһ̡
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "paging.h"
+#include "scheduler.h"
+#include "banker.h"
+#include "trace.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define MAX_THREADS 64
+
+// ģ
+#define PG_PAGES    256
+#define PG_LENGTH   20000
+#define RR_PROCS    300
+#define BK_PROCS    50
+#define BK_RES      5
+#define BK_OPS      5000
+
+static const char* const PG_NAMES[] = { "FIFO", "LRU", "OPT", "WS", "PFF" };
+
+/* ---------------- ̵߳ƽ̨װ ---------------- */
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+#define THREAD_RET DWORD WINAPI
+#define THREAD_RET_VALUE 0
+#else
+typedef pthread_t thread_t;
+#define THREAD_RET void*
+#define THREAD_RET_VALUE NULL
+#endif
+
+static int thread_start(thread_t* t, THREAD_RET (*fn)(void*), void* arg) {
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t == NULL;
+#else
+    return pthread_create(t, NULL, fn, arg) != 0;
+#endif
+}
+
+static void thread_join(thread_t t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+static double now_sec(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// splitmix64ÿһ״̬
+static unsigned int next_random(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+// FNV-1a¼ĸֶλɢ
+static void mix(unsigned long long* h, long long v) {
+    for (int k = 0; k < 8; ++k) {
+        *h ^= (unsigned long long)(v >> (8 * k)) & 0xFF;
+        *h *= 0x100000001B3ULL;
+    }
+}
+
+/* ---------------- ģ ---------------- */
+
+#define ENGINE_PAGING 0
+#define ENGINE_RR     1
+#define ENGINE_BANKER 2
+
+typedef struct {
+    int engine;
+    unsigned long long seed;
+    unsigned long long hash;    // ¼ɢ
+    double metric;              // ȱҳ / ƽתʱ / ׼
+    int error;
+} Job;
+
+typedef struct {
+    unsigned long long hash;
+    unsigned long long rng;     // RR 
+    TrRing* ring;               // Ϊ NULL ʱ
+    int pid;                    // еĽ̺ = ±
+} Sink;
+
+// ĽԴͷʱ䰴
+typedef struct {
+    Sink* sink;
+    unsigned long long rng;
+    long long arrival;
+    int made;
+} RrLoad;
+
+static void on_page(void* user, const PgEvent* ev) {
+    Sink* s = (Sink*)user;
+    mix(&s->hash, ev->time);
+    mix(&s->hash, ev->frame);
+    mix(&s->hash, ev->victim);
+    mix(&s->hash, ev->trimmed);
+    if (s->ring != NULL && ev->fault) {
+        tr_instant(s->ring, s->pid, 0, ev->time, "fault", -1, "page", ev->page);
+        if (ev->victim >= 0) {
+            tr_instant(s->ring, s->pid, 0, ev->time, "evict", -1, "page", ev->victim);
+        }
+    }
+}
+
+static int rr_next(ProcessSource* self, ProcessBase* out) {
+    RrLoad* l = (RrLoad*)self->state;
+    if (l->made == RR_PROCS) {
+        return 0;
+    }
+    l->arrival += next_random(&l->rng) % 64;
+    memset(out, 0, sizeof(*out));
+    out->pid = l->made++;
+    out->arrival_time = l->arrival;
+    out->service_time = 1 + next_random(&l->rng) % 50;
+    return 1;
+}
+
+static void rr_complete(ProcessSource* self, long long seq, const ProcessBase* p, const ProcessRun* r) {
+    Sink* s = ((RrLoad*)self->state)->sink;
+    (void)p;
+    mix(&s->hash, seq);
+    mix(&s->hash, r->finish_time);
+}
+
+static void on_banker(void* user, const BkEvent* ev) {
+    Sink* s = (Sink*)user;
+    mix(&s->hash, ev->type);
+    mix(&s->hash, ev->pid);
+    mix(&s->hash, ev->result);
+}
+
+// Լķ֮һʱƬ; I/Oֻһ־һʱ䡣ÿ CPU ɢ
+static long long rr_hook(ProcessSource* self, long long seq, long long now, long long slice, long long* block) {
+    Sink* s = ((RrLoad*)self->state)->sink;
+    long long ran = slice;
+    if (next_random(&s->rng) % 4 == 0) {
+        *block = 5 + next_random(&s->rng) % 26;
+        ran = 1 + next_random(&s->rng) % slice;
+    }
+    mix(&s->hash, now);
+    mix(&s->hash, seq);
+    mix(&s->hash, ran);
+    mix(&s->hash, *block);
+    return ran;
+}
+
+// оֲԵķʴ󲿷ַһƶСż
+static void run_paging(Job* job, int* pages, TrRing* ring, int pid) {
+    unsigned long long rng = job->seed;
+    int policy = (int)(job->seed % 5);
+    int frames = 16 + (int)(next_random(&rng) % 49);
+    int base = 0;
+    Sink sink = { 0xCBF29CE484222325ULL, 0, ring, pid };
+    for (int i = 0; i < PG_LENGTH; ++i) {
+        if (next_random(&rng) % 100 == 0) base = (int)(next_random(&rng) % PG_PAGES);
+        else if (i % 50 == 0) base = (base + 1) % PG_PAGES;
+        pages[i] = next_random(&rng) % 10 == 0 ? (int)(next_random(&rng) % PG_PAGES)
+                                               : (base + (int)(next_random(&rng) % 24)) % PG_PAGES;
+    }
+    PagingSim* pg = pg_create(policy, frames, PG_PAGES, 200);
+    if (pg == NULL) {
+        job->error = 1;
+        return;
+    }
+    pg_set_callback(pg, on_page, &sink);
+    long long faults = pg_run(pg, pages, PG_LENGTH);
+    pg_destroy(pg);
+    job->error = faults < 0;
+    job->hash = sink.hash;
+    job->metric = (double)faults / PG_LENGTH;
+}
+
+static void run_rr(Job* job, TrRing* ring, int pid) {
+    Sink sink = { 0xCBF29CE484222325ULL, job->seed * 7 + 1, NULL, 0 };
+    RrLoad load = { &sink, job->seed, 0, 0 };
+    ProcessSource src = { rr_next, rr_complete, rr_hook, &load };
+    SimConfig cfg;
+    SchedStats st;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.ncpu = 1;
+    cfg.switch_cost = 1;
+    cfg.trace = ring;       // Ƭκռɵڹ 0 
+    cfg.trace_pid = pid;
+    job->error = simulate_source(&src, POLICY_RR, 4, &cfg, &st, NULL);
+    job->hash = sink.hash;
+    job->metric = st.sum_turnaround / RR_PROCS;
+}
+
+// ȫ̴ 0 俪ʼMax ʼ״̬һȫ롢黹
+static void run_banker(Job* job) {
+    unsigned long long rng = job->seed;
+    int avail[BK_RES], max[BK_PROCS * BK_RES], vec[BK_RES];
+    Sink sink = { 0xCBF29CE484222325ULL, 0, NULL, 0 };
+    for (int j = 0; j < BK_RES; ++j) {
+        avail[j] = 100;
+    }
+    for (int k = 0; k < BK_PROCS * BK_RES; ++k) {
+        max[k] = (int)(next_random(&rng) % 21);
+    }
+    Banker* bk = bk_create(BK_PROCS, BK_RES, avail, max, NULL);
+    if (bk == NULL) {
+        job->error = 1;
+        return;
+    }
+    bk_set_callback(bk, on_banker, &sink);
+    for (int op = 0; op < BK_OPS; ++op) {
+        int p = (int)(next_random(&rng) % BK_PROCS);
+        int release = next_random(&rng) % 10 < 4;
+        for (int j = 0; j < BK_RES; ++j) {
+            int cap = release ? bk_allocation(bk, p, j) : bk_need(bk, p, j) / 2;
+            vec[j] = (int)(next_random(&rng) % (unsigned int)(cap + 1));
+        }
+        if (release) bk_release(bk, p, vec);
+        else bk_request(bk, p, vec);
+    }
+    BkStats st;
+    bk_get_stats(bk, &st);
+    job->error = !bk_is_safe(bk, NULL);
+    bk_destroy(bk);
+    job->hash = sink.hash;
+    job->metric = (double)st.granted / (st.requests ? st.requests : 1);
+}
+
+// мûʱᣬ
+static void run_job(Job* job, int* pages, TrRing* ring, int pid) {
+    switch (job->engine) {
+    case ENGINE_PAGING: run_paging(job, pages, ring, pid); break;
+    case ENGINE_RR:     run_rr(job, ring, pid); break;
+    default:            run_banker(job); break;
+    }
+}
+
+typedef struct {
+    Job* jobs;
+    int count, first, step;     // ߳ first, first + step, ...
+    Tracer* tracer;             // Ϊ NULL ʱ
+    int error;
+} Worker;
+
+static THREAD_RET worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    int* pages = (int*)malloc(PG_LENGTH * sizeof(int));
+    TrRing* ring = w->tracer != NULL ? tr_ring(w->tracer) : NULL;
+    if (pages == NULL || (w->tracer != NULL && ring == NULL)) {
+        free(pages);
+        w->error = 1;
+        return THREAD_RET_VALUE;
+    }
+    for (int i = w->first; i < w->count; i += w->step) {
+        run_job(&w->jobs[i], pages, ring, i);
+    }
+    free(pages);
+    return THREAD_RET_VALUE;
+}
+
+//  nthreads ߳ jobsnthreads = 1 ʱڵǰ߳ܣغʱ룩-1 = ʧ
+static double run_all(Job* jobs, int count, int nthreads, Tracer* tracer) {
+    static Worker workers[MAX_THREADS];
+    thread_t threads[MAX_THREADS];
+    int started = 0, error = 0;
+    double t0 = now_sec();
+    for (int t = 0; t < nthreads; ++t) {
+        workers[t].jobs = jobs;
+        workers[t].count = count;
+        workers[t].first = t;
+        workers[t].step = nthreads;
+        workers[t].tracer = tracer;
+        workers[t].error = 0;
+    }
+    if (nthreads == 1) {
+        worker_main(&workers[0]);
+    }
+    else {
+        for (int t = 0; t < nthreads; ++t) {
+            if (thread_start(&threads[t], worker_main, &workers[t]) != 0) {
+                error = 1;
+                break;
+            }
+            started++;
+        }
+        for (int t = 0; t < started; ++t) {
+            thread_join(threads[t]);
+        }
+    }
+    for (int t = 0; t < nthreads; ++t) {
+        error |= workers[t].error;
+    }
+    for (int i = 0; i < count; ++i) {
+        error |= jobs[i].error;
+    }
+    return error ? -1 : now_sec() - t0;
+}
+
+int main(int argc, char* argv[]) {
+    int per_engine, nthreads;
+    unsigned long long seed;
+    Tracer* tracer = NULL;
+
+    printf("=========== ģ⣺жģ ===========\n");
+    printf("ÿҳû %d ηʣÿ %d ̣ÿм %d /黹\n",
+        PG_LENGTH, RR_PROCS, BK_OPS);
+    printf(" ÿģ ߳(<= %d) : ", MAX_THREADS);
+    if (scanf("%d %d %llu", &per_engine, &nthreads, &seed) != 3 ||
+        per_engine <= 0 || nthreads <= 0 || nthreads > MAX_THREADS) {
+        printf("Ƿ\n");
+        return 1;
+    }
+
+    int count = per_engine * 3;
+    Job* seq = (Job*)calloc((size_t)count, sizeof(Job));
+    Job* par = (Job*)calloc((size_t)count, sizeof(Job));
+    if (seq == NULL || par == NULL) {
+        printf("ڴ治\n");
+        free(seq);
+        free(par);
+        return 1;
+    }
+    // 潻Уÿ̷ֵ߳ʹ¾
+    for (int i = 0; i < count; ++i) {
+        seq[i].engine = i % 3;
+        seq[i].seed = seed * 1000003ULL + (unsigned long long)i;
+        par[i] = seq[i];
+    }
+
+    if (argc > 1) {
+        tracer = tr_open(argv[1], 1 << 16);
+        if (tracer == NULL) {
+            printf("޷ļ %s\n", argv[1]);
+            free(seq);
+            free(par);
+            return 1;
+        }
+        for (int i = 0; i < count; ++i) {
+            char name[64];
+            if (seq[i].engine == ENGINE_BANKER) continue;
+            if (seq[i].engine == ENGINE_PAGING) sprintf(name, "job %d paging %s", i, PG_NAMES[seq[i].seed % 5]);
+            else sprintf(name, "job %d round robin", i);
+            tr_name(tracer, i, -1, name);
+            tr_name(tracer, i, 0, seq[i].engine == ENGINE_PAGING ? "memory" : "CPU 0");
+        }
+    }
+
+    double t_seq = run_all(seq, count, 1, NULL);
+    double t_par = t_seq < 0 ? -1 : run_all(par, count, nthreads, tracer);
+    TrStats ts;
+    if (tracer != NULL && tr_close(tracer, &ts) != 0) {
+        t_par = -1;
+    }
+    if (t_seq < 0 || t_par < 0) {
+        printf("ģʧ\n");
+        free(seq);
+        free(par);
+        return 1;
+    }
+
+    int mismatch = 0;
+    for (int i = 0; i < count; ++i) {
+        if (seq[i].hash != par[i].hash || seq[i].metric != par[i].metric) mismatch++;
+    }
+
+    double fault[5] = { 0 }, turnaround = 0, grant = 0;
+    int runs[5] = { 0 };
+    for (int i = 0; i < count; ++i) {
+        if (seq[i].engine == ENGINE_PAGING) {
+            fault[seq[i].seed % 5] += seq[i].metric;
+            runs[seq[i].seed % 5]++;
+        }
+        else if (seq[i].engine == ENGINE_RR) turnaround += seq[i].metric;
+        else grant += seq[i].metric;
+    }
+    printf("\nҳûƽȱҳʣ");
+    for (int k = 0; k < 5; ++k) {
+        if (runs[k] > 0) printf("%s %.2f%%  ", PG_NAMES[k], 100.0 * fault[k] / runs[k]);
+    }
+    printf("\nʱƬתƽתʱ䣺%.1f\n", turnaround / per_engine);
+    printf("м㷨׼ʣ%.1f%%\n", 100.0 * grant / per_engine);
+
+    printf("\nʽ\t߳\tʱ(s)\t\tģ/s\n");
+    printf("˳\t1\t%.3f\t\t%.0f\n", t_seq, count / t_seq);
+    printf("\t%d\t%.3f\t\t%.0f\n", nthreads, t_par, count / t_par);
+    printf("ٱ %.2f˳һµģ⣺%d / %d\n", t_seq / t_par, mismatch, count);
+    if (tracer != NULL) {
+        printf("һֵʱд %sʱ٣%lld ¼ȴ %lld \n",
+            argv[1], ts.events, ts.stalls);
+    }
+    free(seq);
+    free(par);
+    return mismatch != 0;
+}
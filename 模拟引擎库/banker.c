@@ -0,0 +1,1923 @@
+/*
+ * м㷨ʵ֣ banker.h
+ *
+ * MaxAllocationNeed һڴ棬ÿв뵽 BK_LANES ж룬벿ֺΪ 0
+ * Need[i] <= work͡work += Allocation[i]öָôβ͡
+ * ȫԼɨ SCAN_PASSES ֣ûнʱÿԴ j ά Need[.][j]
+ * еĽ order[j]ʱÿһָ룬 Need <= work[j] ĽԽ
+ * ĳȫ m ϶ԽͿִꡣÿ (, Դ) ֻԽһΣһμ O(nm)
+ * Ĵ̯ Need 仯ʱupdate_need
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include "banker.h"
+
+// x86 ṩ AVX2 / AVX-512 汾ˣʱ CPU ֧ѡ
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define HAVE_X86_SIMD 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#include <immintrin.h>
+#define TARGET_AVX2   __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#endif
+
+#define CACHE_LINE  64      // ÿаж
+#define SCAN_PASSES 4       // ȫԼɨ
+#define DETECT_PERIOD 32    // ԴͼлʱÿôһιԼؽ
+
+#define ADMIT_PENDING (-1)  // лûн
+
+typedef int (*LessEqualFn)(const int* a, const int* b, int len);
+typedef void (*AddFn)(int* dst, const int* src, int len);
+
+/* ---------------- ȴ ---------------- */
+
+/*
+ * ݻȴУڵʲôǼǵԴֿ
+ * - ԴĳЩ Request[j] > Available[j]Ǽǵ demand_heap[j] = Request[j]
+ *   missing ǻࣻԴ j ͷʱֻ <= Available[j] missing  0 ¼飻
+ * - Դ󲻰ȫǼǵ safety_heap[j] = ʱ released_total[j] + ȱڣ
+ *   Դ j ۼͷﵽֵ¼飻ֻסһ q ʱǼǵ sole_stuck[q]q ¼顣
+ * һܵǼڼѻʱ gen  1𴦵ľʱ gen Ͷ
+ * һͷֵֻԽЩȴȴеܳ޹
+ */
+typedef struct {
+    long long key;
+    int waiter;
+    int gen;
+} WaitEntry;
+
+typedef struct {
+    WaitEntry* a;
+    int size, cap;
+} WaitHeap;
+
+typedef struct {
+    int pid;
+    int* vec;           // 롢룩
+    long long seq;      // ţб
+    int gen;
+    int missing;        // ԴȴʱԴ
+    int active;         // 0 = ղ
+    int prev_of_pid, next_of_pid;   // ͬһ̵ĵȴ󴮳˫̽ʱ
+} Waiter;
+
+/* ----------------  ---------------- */
+
+typedef struct {
+    int* a;
+    int size, cap;
+} EdgeList;
+
+/*
+ * ģʽҪ MaxҲȫԼ飺Request <= Available ͷ䣬
+ * öԴͼ֣ 0 ~ n-1 ǽ̣n ~ n+m-1 Դ
+ * Ľ p Դ j ϲpending_req[p][j] > Available[j]ʱ p -> n+j
+ *  q Դ jAllocation[q][j] > 0ʱ n+j -> qԴ j ĳ߾ĳ߱
+ *  2nm֮ĵȴͼһҪÿ߸һߡ
+ * ÿһ Pearce-Kelly жǷɻɻľֻٵʱ䡣
+ * ʵԴ»ֻıҪԳɻʱһζʵԼ Request ļ㷨ȷϣ
+ * ֮߰ǰ״̬ؽлͣάÿ DETECT_PERIOD һιԼؽ
+ * ֱͼûлٻָģʽ
+ *  Allocation ȷά 0 ʱӡ 0 ʱɾAvailable[j] ֻڷʱ٣
+ * ʱ˱ò̲ p -> n+jͼʼհʵĵȴϵ©
+ * õԴĽûûгߣµķ߲ᵱɻ
+ * ֻ̱ʱɾ黹 j ֹµľֻ౨ɹԼų
+ * ؽʱ֮ j ٱòʱ edge_mark ȥأظߡ
+ * һεüģʽĺʱŷ
+ */
+typedef struct {
+    int** pending_req;      // pending_req[p] p ڵȵ󣨶롢룩
+    int* blocked;           // blocked[p] = 1 ʾ p ڵ
+    int* blocked_list;      // ̣Դʱֻ鿴
+    int* blocked_pos;       // blocked_pos[p]p  blocked_list еλ
+    int blocked_count;
+    EdgeList* out_edges;    // out_edges[v] v ĳߣ n + m 
+    EdgeList* in_edges;     // in_edges[v]ָ v Ľ
+    EdgeList* holders;      // holders[j]  out_edges[n + j]Դ j Ľ
+    int* topo_ord;          // topo_ord[v]v еλ
+    int* topo_node;         // topo_node[k]λ k ϵĽ
+    int* visit_stamp;       // DFS ʱǣֵ stamp ʾѷ
+    int stamp;
+    int* edge_mark;         // edge_mark[j]  edge_stamp ʾǰеԴ j 
+    int edge_stamp;
+    int* dfs_stack;
+    int* dfs_forward;
+    int* dfs_backward;
+    int* dfs_slots;
+    long long* sort_keys;   // 
+    int graph_cyclic;       // 1 = ͼлͣ
+    int blocks_since_reduce;
+} Detector;
+
+/*
+ * дʱƿգֻ Available  AllocationNeed ָ룬ʵʱ״̬
+ * ʵʱ״̬ĵ i ֮ǰ touch_row(i)һпܱûͷŵĿʱ
+ * Ȼһ¿ٸģաºͲٱ仯
+ * ̶߳ʱȲüҲʵʱ״̬޸
+ */
+struct BkSnapshot {
+    int epoch;              // Ŀʱı
+    int n, m, padded;
+    LessEqualFn less_equal;
+    AddFn add;
+    int* available;
+    int** allocation;       // ָ
+    int** need;
+    int* hint;              // ļ˳ĿʱİȫУΪ NULL
+    BkSnapshot* next;       // µǰ
+};
+
+// һĹÿ߳һ
+struct BkScratch {
+    int* req;               // 󿽱롢
+    int* work;
+    int* need_row;          // ̷ NeedAllocation 
+    int* alloc_row;
+    int* pending;           // ûִĽ
+};
+
+struct Banker {
+    int n, m;
+    int padded;             // m 뵽 BK_LANES 
+    int* available;
+    int** max;
+    int** alloc;
+    int** need;
+    /*
+     * ȫԼõÿԴ jorder[j]  (Need[i][j], i) ọ̈̄
+     * sorted[j] ǶӦ Need ֵţָʱ˳ʣ
+     */
+    int** order;
+    int** sorted;
+    // ȫԼĹ
+    int* work;
+    int* satisfied;         // Դ
+    int* cursor;            // Դָ
+    int* ready;             // ȫԴȴִꡱĽ
+    int* seq;               // ÷Ҫȫʱд
+    int* req;               // 롢
+    int* shortfall;         // ϴβȫȱڣcollect_shortfall
+    LessEqualFn less_equal;
+    AddFn add;
+    // дʱ
+    int snap_epoch;         // һĿյı
+    BkSnapshot* live;       // ûͷŵĿ
+    int* row_epoch;         // ʵʱ״̬ i л¿ʱ snap_epoch
+    unsigned char* row_private; //  i ǵģ new_matrix ڴ
+    int* alloc_base;        // new_matrix ڴ㣬ͷʱ
+    int* need_base;
+    int** retired_rows;     // ʵʱ״̬ĵУܻ
+    int* retired_epoch;     // ʱ snap_epochŲĿտܻ
+    int retired_count, retired_cap;
+    // ȴ
+    Waiter* waiters;
+    int waiter_count, waiter_cap;   // ò / 
+    int* free_waiters;      // ղջ
+    int free_waiter_count;
+    int pending;            // ڵȵ
+    int* waiter_head;       // waiter_head[p] p ĵһȴ-1 ʾû
+    WaitHeap* demand_heap;  // ÿԴһ Request[j] С
+    WaitHeap* safety_heap;  // ÿԴһ released_total[j] + ȱڵС
+    WaitHeap* sole_stuck;   // ÿһ
+    long long* released_total;  // ÿԴۼͷ
+    long long arrival_seq;
+    Detector* det;
+    BkStats st;
+    BkEventFn fn;
+    void* user;
+};
+
+/* ----------------  ---------------- */
+
+int bk_padded(int len) {
+    return (len + BK_LANES - 1) / BK_LANES * BK_LANES;
+}
+
+int* bk_new_vector(int len) {
+    size_t bytes = (size_t)bk_padded(len) * sizeof(int);
+    void* p;
+    if (bytes == 0) {
+        bytes = BK_LANES * sizeof(int);
+    }
+#ifdef _WIN32
+    p = _aligned_malloc(bytes, CACHE_LINE);
+#else
+    if (posix_memalign(&p, CACHE_LINE, bytes) != 0) p = NULL;
+#endif
+    if (p != NULL) {
+        memset(p, 0, bytes);
+    }
+    return (int*)p;
+}
+
+void bk_free_vector(int* v) {
+#ifdef _WIN32
+    _aligned_free(v);
+#else
+    free(v);
+#endif
+}
+
+// rowscols ľһڴ棬ÿвҲӻб߽翪ʼԪسʼΪ 0
+static int** new_matrix(int rows, int cols) {
+    int** a = (int**)malloc((size_t)rows * sizeof(int*));
+    int stride = bk_padded(cols);
+    int* data = bk_new_vector((int)((size_t)rows * stride));
+    if (a == NULL || data == NULL) {
+        free(a);
+        bk_free_vector(data);
+        return NULL;
+    }
+    for (int i = 0; i < rows; ++i) {
+        a[i] = data + (size_t)i * stride;
+    }
+    return a;
+}
+
+static void free_matrix(int** a) {
+    if (a != NULL) {
+        bk_free_vector(a[0]);
+        free(a);
+    }
+}
+
+/* ---------------- ˣ / AVX2 / AVX-512 ---------------- */
+
+// a[0..len)  <= b[0..len)len Ϊ BK_LANES 
+static int less_equal_scalar(const int* a, const int* b, int len) {
+    for (int j = 0; j < len; ++j) {
+        if (a[j] > b[j]) return 0;
+    }
+    return 1;
+}
+
+// dst[0..len) += src[0..len)
+static void add_scalar(int* dst, const int* src, int len) {
+    for (int j = 0; j < len; ++j) {
+        dst[j] += src[j];
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+TARGET_AVX2 static int less_equal_avx2(const int* a, const int* b, int len) {
+    for (int j = 0; j < len; j += 16) {
+        __m256i gt0 = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i*)(a + j)),
+            _mm256_load_si256((const __m256i*)(b + j)));
+        __m256i gt1 = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i*)(a + j + 8)),
+            _mm256_load_si256((const __m256i*)(b + j + 8)));
+        __m256i gt = _mm256_or_si256(gt0, gt1);
+        if (!_mm256_testz_si256(gt, gt)) return 0;
+    }
+    return 1;
+}
+
+TARGET_AVX2 static void add_avx2(int* dst, const int* src, int len) {
+    for (int j = 0; j < len; j += 8) {
+        __m256i d = _mm256_load_si256((const __m256i*)(dst + j));
+        __m256i s = _mm256_load_si256((const __m256i*)(src + j));
+        _mm256_store_si256((__m256i*)(dst + j), _mm256_add_epi32(d, s));
+    }
+}
+
+TARGET_AVX512 static int less_equal_avx512(const int* a, const int* b, int len) {
+    for (int j = 0; j < len; j += 16) {
+        if (_mm512_cmpgt_epi32_mask(_mm512_load_si512(a + j), _mm512_load_si512(b + j)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+TARGET_AVX512 static void add_avx512(int* dst, const int* src, int len) {
+    for (int j = 0; j < len; j += 16) {
+        _mm512_store_si512(dst + j, _mm512_add_epi32(_mm512_load_si512(dst + j),
+            _mm512_load_si512(src + j)));
+    }
+}
+
+int bk_simd_level(void) {
+#ifdef _MSC_VER
+    int info[4];
+    unsigned long long xcr0;
+    __cpuid(info, 0);
+    if (info[0] < 7) return 0;
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27))) return 0;              // OSXSAVE
+    xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) return 0;                  // ϵͳ YMM ״̬
+    __cpuidex(info, 7, 0);
+    if (!(info[1] & (1 << 5))) return 0;
+    if ((info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6) return 2;
+    return 1;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return 2;
+    if (__builtin_cpu_supports("avx2")) return 1;
+    return 0;
+#endif
+}
+#else
+int bk_simd_level(void) {
+    return 0;
+}
+#endif
+
+void bk_kernels(int level, BkKernels* k) {
+    k->less_equal = less_equal_scalar;
+    k->add = add_scalar;
+#ifdef HAVE_X86_SIMD
+    if (level > bk_simd_level()) {
+        return;
+    }
+    if (level == 1) {
+        k->less_equal = less_equal_avx2;
+        k->add = add_avx2;
+    }
+    else if (level == 2) {
+        k->less_equal = less_equal_avx512;
+        k->add = add_avx512;
+    }
+#else
+    (void)level;
+#endif
+}
+
+void bk_set_simd(Banker* bk, int level) {
+    BkKernels k;
+    bk_kernels(level, &k);
+    bk->less_equal = k.less_equal;
+    bk->add = k.add;
+}
+
+/* ---------------- дʱ ---------------- */
+
+// ʵʱ״̬ Allocation[p]  Need[p] ֮ǰãչȻ¿ 0 = ɹ
+static int touch_row(Banker* bk, int p) {
+    int* a;
+    int* b;
+    if (bk->live == NULL || bk->row_epoch[p] >= bk->live->epoch) {
+        return 0;
+    }
+    if (bk->retired_count + 2 > bk->retired_cap) {
+        int cap = bk->retired_cap ? bk->retired_cap * 2 : 64;
+        int** rows = (int**)realloc(bk->retired_rows, (size_t)cap * sizeof(int*));
+        int* epochs;
+        if (rows == NULL) return 1;
+        bk->retired_rows = rows;
+        epochs = (int*)realloc(bk->retired_epoch, (size_t)cap * sizeof(int));
+        if (epochs == NULL) return 1;
+        bk->retired_epoch = epochs;
+        bk->retired_cap = cap;
+    }
+    a = bk_new_vector(bk->m);
+    b = bk_new_vector(bk->m);
+    if (a == NULL || b == NULL) {
+        bk_free_vector(a);
+        bk_free_vector(b);
+        return 1;
+    }
+    memcpy(a, bk->alloc[p], (size_t)bk->padded * sizeof(int));
+    memcpy(b, bk->need[p], (size_t)bk->padded * sizeof(int));
+    if (bk->row_private[p]) {
+        bk->retired_rows[bk->retired_count] = bk->alloc[p];
+        bk->retired_epoch[bk->retired_count++] = bk->snap_epoch;
+        bk->retired_rows[bk->retired_count] = bk->need[p];
+        bk->retired_epoch[bk->retired_count++] = bk->snap_epoch;
+    }
+    bk->alloc[p] = a;
+    bk->need[p] = b;
+    bk->row_private[p] = 1;
+    bk->row_epoch[p] = bk->snap_epoch;
+    bk->st.cow_copies++;
+    return 0;
+}
+
+/* ----------------  ---------------- */
+
+//  a Դ j ˳Ƿ b ǰ
+static int need_before(const Banker* bk, int a, int b, int j) {
+    if (bk->need[a][j] != bk->need[b][j]) return bk->need[a][j] < bk->need[b][j];
+    return a < b;
+}
+
+static int compare_key(const void* x, const void* y) {
+    long long a = *(const long long*)x, b = *(const long long*)y;
+    return a < b ? -1 : a > b;
+}
+
+// ÿԴѼ Need2^32 + ֵ̺̺ͬţO(mnlog n) 0 = ɹ
+static int build_order(Banker* bk) {
+    int n = bk->n;
+    long long* keys = (long long*)malloc((size_t)n * sizeof(long long));
+    if (keys == NULL) {
+        return 1;
+    }
+    for (int j = 0; j < bk->m; ++j) {
+        for (int i = 0; i < n; ++i) {
+            keys[i] = (long long)bk->need[i][j] * 4294967296LL + i;
+        }
+        qsort(keys, (size_t)n, sizeof(long long), compare_key);
+        for (int k = 0; k < n; ++k) {
+            bk->order[j][k] = (int)(keys[k] & 0xFFFFFFFFLL);
+            bk->sorted[j][k] = bk->need[bk->order[j][k]][j];
+        }
+    }
+    free(keys);
+    return 0;
+}
+
+// Need[p][j] += delta p Ų order[j] еλãҵλãŲ p  touch_row
+static void update_need(Banker* bk, int p, int j, int delta) {
+    int n = bk->n;
+    int* o = bk->order[j];
+    int* v = bk->sorted[j];
+    int old = bk->need[p][j], lo = 0, hi = n - 1, k;
+    if (delta == 0) {
+        return;
+    }
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (v[mid] < old || (v[mid] == old && o[mid] < p)) lo = mid + 1;
+        else hi = mid;
+    }
+    k = lo;
+    bk->need[p][j] += delta;
+    while (k > 0 && need_before(bk, p, o[k - 1], j)) {
+        o[k] = o[k - 1];
+        v[k] = v[k - 1];
+        k--;
+    }
+    while (k < n - 1 && need_before(bk, o[k + 1], p, j)) {
+        o[k] = o[k + 1];
+        v[k] = v[k + 1];
+        k++;
+    }
+    o[k] = p;
+    v[k] = bk->need[p][j];
+}
+
+/* ----------------  ---------------- */
+
+static void free_wait_queue(Banker* bk);
+static void free_detector(Banker* bk);
+
+Banker* bk_create(int n, int m, const int* available, const int* max, const int* alloc) {
+    if (n <= 0 || m <= 0) {
+        return NULL;
+    }
+    Banker* bk = (Banker*)calloc(1, sizeof(Banker));
+    if (bk == NULL) {
+        return NULL;
+    }
+    bk->n = n;
+    bk->m = m;
+    bk->padded = bk_padded(m);
+    bk->available = bk_new_vector(m);
+    bk->max = new_matrix(n, m);
+    bk->alloc = new_matrix(n, m);
+    bk->need = new_matrix(n, m);
+    bk->order = new_matrix(m, n);
+    bk->sorted = new_matrix(m, n);
+    bk->work = bk_new_vector(m);
+    bk->satisfied = (int*)malloc((size_t)n * sizeof(int));
+    bk->cursor = (int*)malloc((size_t)m * sizeof(int));
+    bk->ready = (int*)malloc((size_t)n * sizeof(int));
+    bk->seq = (int*)malloc((size_t)n * sizeof(int));
+    bk->req = bk_new_vector(m);
+    bk->shortfall = bk_new_vector(m);
+    bk->row_epoch = (int*)calloc((size_t)n, sizeof(int));
+    bk->row_private = (unsigned char*)calloc((size_t)n, 1);
+    bk->waiter_head = (int*)malloc((size_t)n * sizeof(int));
+    bk->demand_heap = (WaitHeap*)calloc((size_t)m, sizeof(WaitHeap));
+    bk->safety_heap = (WaitHeap*)calloc((size_t)m, sizeof(WaitHeap));
+    bk->sole_stuck = (WaitHeap*)calloc((size_t)n, sizeof(WaitHeap));
+    bk->released_total = (long long*)calloc((size_t)m, sizeof(long long));
+    bk->alloc_base = bk->alloc != NULL ? bk->alloc[0] : NULL;
+    bk->need_base = bk->need != NULL ? bk->need[0] : NULL;
+    bk_set_simd(bk, bk_simd_level());
+    if (bk->available == NULL || bk->max == NULL || bk->alloc == NULL || bk->need == NULL ||
+        bk->order == NULL || bk->sorted == NULL || bk->work == NULL || bk->satisfied == NULL ||
+        bk->cursor == NULL || bk->ready == NULL || bk->seq == NULL || bk->req == NULL ||
+        bk->shortfall == NULL || bk->row_epoch == NULL || bk->row_private == NULL ||
+        bk->waiter_head == NULL || bk->demand_heap == NULL || bk->safety_heap == NULL ||
+        bk->sole_stuck == NULL || bk->released_total == NULL) {
+        bk_destroy(bk);
+        return NULL;
+    }
+    for (int i = 0; i < n; ++i) {
+        bk->waiter_head[i] = -1;
+    }
+    for (int j = 0; j < m; ++j) {
+        bk->available[j] = available[j];
+        if (available[j] < 0) {
+            bk_destroy(bk);
+            return NULL;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < m; ++j) {
+            bk->max[i][j] = max[(size_t)i * m + j];
+            bk->alloc[i][j] = alloc != NULL ? alloc[(size_t)i * m + j] : 0;
+            bk->need[i][j] = bk->max[i][j] - bk->alloc[i][j];
+            if (bk->alloc[i][j] < 0 || bk->need[i][j] < 0) {
+                bk_destroy(bk);
+                return NULL;
+            }
+        }
+    }
+    if (build_order(bk) != 0) {
+        bk_destroy(bk);
+        return NULL;
+    }
+    return bk;
+}
+
+void bk_destroy(Banker* bk) {
+    if (bk == NULL) {
+        return;
+    }
+    free_wait_queue(bk);
+    free_detector(bk);
+    for (int i = 0; bk->row_private != NULL && i < bk->n; ++i) {
+        if (bk->row_private[i]) {
+            bk_free_vector(bk->alloc[i]);
+            bk_free_vector(bk->need[i]);
+        }
+    }
+    if (bk->alloc != NULL) bk->alloc[0] = bk->alloc_base;
+    if (bk->need != NULL) bk->need[0] = bk->need_base;
+    for (int i = 0; i < bk->retired_count; ++i) {
+        bk_free_vector(bk->retired_rows[i]);
+    }
+    free(bk->retired_rows);
+    free(bk->retired_epoch);
+    free(bk->row_epoch);
+    free(bk->row_private);
+    bk_free_vector(bk->available);
+    free_matrix(bk->max);
+    free_matrix(bk->alloc);
+    free_matrix(bk->need);
+    free_matrix(bk->order);
+    free_matrix(bk->sorted);
+    bk_free_vector(bk->work);
+    free(bk->satisfied);
+    free(bk->cursor);
+    free(bk->ready);
+    free(bk->seq);
+    bk_free_vector(bk->req);
+    bk_free_vector(bk->shortfall);
+    free(bk);
+}
+
+void bk_set_callback(Banker* bk, BkEventFn fn, void* user) {
+    bk->fn = fn;
+    bk->user = user;
+}
+
+int bk_available(const Banker* bk, int j) {
+    return bk->available[j];
+}
+
+int bk_max(const Banker* bk, int p, int j) {
+    return bk->max[p][j];
+}
+
+int bk_allocation(const Banker* bk, int p, int j) {
+    return bk->alloc[p][j];
+}
+
+int bk_need(const Banker* bk, int p, int j) {
+    return bk->need[p][j];
+}
+
+void bk_get_stats(const Banker* bk, BkStats* stats) {
+    *stats = bk->st;
+}
+
+static void emit(Banker* bk, int type, int p, const int* vec, int result, long long ticket) {
+    if (bk->fn != NULL) {
+        BkEvent ev;
+        ev.type = type;
+        ev.pid = p;
+        ev.vec = vec;
+        ev.result = result;
+        ev.ticket = ticket;
+        bk->fn(bk->user, &ev);
+    }
+}
+
+//  m  int  dst Ķ벿ֱ 0и 1
+static int copy_vector(int* dst, const int* src, int m) {
+    int bad = 0;
+    for (int j = 0; j < m; ++j) {
+        dst[j] = src[j];
+        bad |= src[j] < 0;
+    }
+    return bad;
+}
+
+/* ---------------- ȫԼ ---------------- */
+
+// Դ j ָƹ Need <= work[j] Ḷ̌ȫԴ˵Ľ
+static void advance_cursor(Banker* bk, int j, int* tail) {
+    const int* o = bk->order[j];
+    const int* v = bk->sorted[j];
+    int n = bk->n, w = bk->work[j], c = bk->cursor[j];
+    while (c < n && v[c] <= w) {
+        int i = o[c++];
+        if (++bk->satisfied[i] == bk->m) {
+            bk->ready[(*tail)++] = i;
+        }
+    }
+    bk->cursor[j] = c;
+}
+
+// ȫԼ飬O(nm)
+static int is_safe_indexed(Banker* bk, int* seq) {
+    int n = bk->n, m = bk->m, head = 0, tail = 0;
+    for (int j = 0; j < m; ++j) {
+        bk->work[j] = bk->available[j];
+        bk->cursor[j] = 0;
+    }
+    memset(bk->satisfied, 0, (size_t)n * sizeof(int));
+    for (int j = 0; j < m; ++j) {
+        advance_cursor(bk, j, &tail);
+    }
+    // þĽִ겢ͷԴֻƽͷԴЩ
+    while (head < tail) {
+        int i = bk->ready[head++];
+        const int* row = bk->alloc[i];
+        seq[head - 1] = i;
+        bk->add(bk->work, row, bk->padded);
+        for (int j = 0; j < m; ++j) {
+            if (row[j] != 0) {
+                advance_cursor(bk, j, &tail);
+            }
+        }
+    }
+    return head == n;
+}
+
+/*
+ * ɨ裺ÿְ̺ɨһûɵḶ̌˱Ƚ Need[i] <= work
+ * ״̬ͨһ־꣬Ԫָöࣻ
+ * ÿֻֿһ̣ n ֣ɨ SCAN_PASSES ֣ûн۾ͷ -1
+ */
+static int is_safe_scan(Banker* bk, int* seq) {
+    int n = bk->n, count = 0;
+    memcpy(bk->work, bk->available, (size_t)bk->padded * sizeof(int));
+    memset(bk->satisfied, 0, (size_t)n * sizeof(int));
+    for (int pass = 0; pass < SCAN_PASSES; ++pass) {
+        int found = 0;
+        for (int i = 0; i < n; ++i) {
+            if (bk->satisfied[i] == 0 && bk->less_equal(bk->need[i], bk->work, bk->padded)) {
+                bk->add(bk->work, bk->alloc[i], bk->padded);
+                bk->satisfied[i] = bk->m;   // һsatisfied[i] == m ʾ
+                seq[count++] = i;
+                found = 1;
+            }
+        }
+        if (count == n) return 1;
+        if (!found) return 0;
+    }
+    return -1;
+}
+
+// ɨȫֱûб仯 O(n^2m)ڴ治㷵 0
+static int is_safe_naive(Banker* bk, int* seq) {
+    int n = bk->n, count = 0;
+    int* finish = (int*)calloc((size_t)n, sizeof(int));
+    if (finish == NULL) {
+        return 0;
+    }
+    memcpy(bk->work, bk->available, (size_t)bk->padded * sizeof(int));
+    while (count < n) {
+        int found = 0;
+        for (int i = 0; i < n; ++i) {
+            if (finish[i] == 0 && bk->less_equal(bk->need[i], bk->work, bk->padded)) {
+                bk->add(bk->work, bk->alloc[i], bk->padded);
+                finish[i] = 1;
+                seq[count++] = i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            break;
+        }
+    }
+    free(finish);
+    return count == n;
+}
+
+/*
+ * ɨ衢ûн 0ȫʱ work ɵĽ̶ͷźĹ
+ * satisfied[i] < m ĽǿסḶ̌ collect_shortfall ʹ
+ */
+static int is_safe(Banker* bk, int* seq) {
+    int r = is_safe_scan(bk, seq);
+    bk->st.safety_checks++;
+    return r >= 0 ? r : is_safe_indexed(bk, seq);
+}
+
+int bk_is_safe(Banker* bk, int* seq) {
+    return is_safe(bk, seq != NULL ? seq : bk->seq);
+}
+
+int bk_check_safe(Banker* bk, int method, int* seq) {
+    if (seq == NULL) {
+        seq = bk->seq;
+    }
+    if (method == BK_CHECK_INDEXED) {
+        bk->st.safety_checks++;
+        return is_safe_indexed(bk, seq);
+    }
+    if (method == BK_CHECK_NAIVE) {
+        bk->st.safety_checks++;
+        return is_safe_naive(bk, seq);
+    }
+    return is_safe(bk, seq);
+}
+
+/*
+ * һʧܵ is_safe ֮ãסĽ i ҪɣԴ j 
+ * Ҫͷ gap = Need[i][j] - work[j] shortfall[j] ȡЩ gap  j ϵСֵ
+ * ûн j ΪȱڵΪ 0״̬Ҫ䰲ȫĳסĽɣ
+ * һ j ۼͷﵽ shortfall[j]*stuck ΪΨһסḶ̌סʱΪ -1
+ */
+static void collect_shortfall(Banker* bk, int* shortfall, int* stuck) {
+    int n = bk->n, m = bk->m, count = 0;
+    const int* work = bk->work;
+    memset(shortfall, 0, (size_t)m * sizeof(int));
+    *stuck = -1;
+    for (int i = 0; i < n; ++i) {
+        const int* need = bk->need[i];
+        int worst = 0, gap;
+        if (bk->satisfied[i] == m) continue;
+        *stuck = count++ == 0 ? i : -1;
+        for (int j = 1; j < m; ++j) {
+            if (need[j] - work[j] > need[worst] - work[worst]) worst = j;
+        }
+        gap = need[worst] - work[worst];
+        if (shortfall[worst] == 0 || gap < shortfall[worst]) {
+            shortfall[worst] = gap;
+        }
+    }
+}
+
+/* ---------------- 볷 ---------------- */
+
+/*
+ * Է req롢룬Request <= Need  Request <= Available ʱ޸
+ * AvailableAllocationNeed  ADMIT_PENDING򷵻 BK_INVALID / BK_WAIT / BK_NOMEM״̬
+ */
+static int tentative_grant(Banker* bk, int p, const int* req) {
+    int m = bk->m;
+    for (int j = 0; j < m; ++j) {
+        if (req[j] > bk->need[p][j]) return BK_INVALID;
+    }
+    for (int j = 0; j < m; ++j) {
+        if (req[j] > bk->available[j]) return BK_WAIT;
+    }
+    if (touch_row(bk, p) != 0) {
+        return BK_NOMEM;
+    }
+    for (int j = 0; j < m; ++j) {
+        if (req[j] != 0) {
+            bk->available[j] -= req[j];
+            bk->alloc[p][j] += req[j];
+            update_need(bk, p, j, -req[j]);
+        }
+    }
+    return ADMIT_PENDING;
+}
+
+// һԷ䣨 p  touch_row ٸƣ
+static void revoke_grant(Banker* bk, int p, const int* req) {
+    for (int j = 0; j < bk->m; ++j) {
+        if (req[j] != 0) {
+            bk->available[j] += req[j];
+            bk->alloc[p][j] -= req[j];
+            update_need(bk, p, j, req[j]);
+        }
+    }
+}
+
+/*
+ * Է + ȫԼ飬ȫͳ BK_*
+ * shortfall Ϊ NULL ʱȫȱںΨһסḶ̌ collect_shortfall
+ */
+static int try_request(Banker* bk, int p, const int* req, int* shortfall, int* stuck) {
+    int r = tentative_grant(bk, p, req);
+    if (r != ADMIT_PENDING) {
+        return r;
+    }
+    if (is_safe(bk, bk->seq)) {
+        return BK_GRANTED;
+    }
+    if (shortfall != NULL) {
+        collect_shortfall(bk, shortfall, stuck);
+    }
+    revoke_grant(bk, p, req);
+    return BK_UNSAFE;
+}
+
+static void count_result(Banker* bk, int result) {
+    bk->st.requests++;
+    switch (result) {
+    case BK_GRANTED: bk->st.granted++; break;
+    case BK_WAIT:    bk->st.waits++; break;
+    case BK_UNSAFE:  bk->st.unsafe++; break;
+    case BK_INVALID: bk->st.invalid++; break;
+    default:         break;
+    }
+}
+
+int bk_request(Banker* bk, int p, const int* req) {
+    int result = BK_INVALID;
+    if (p >= 0 && p < bk->n && copy_vector(bk->req, req, bk->m) == 0) {
+        result = try_request(bk, p, bk->req, NULL, NULL);
+    }
+    count_result(bk, result);
+    emit(bk, BK_EV_REQUEST, p, req, result, -1);
+    return result;
+}
+
+/* ---------------- ȴ ---------------- */
+
+static void free_wait_queue(Banker* bk) {
+    for (int i = 0; i < bk->waiter_count; ++i) {
+        if (bk->waiters[i].active) bk_free_vector(bk->waiters[i].vec);
+    }
+    for (int j = 0; bk->demand_heap != NULL && bk->safety_heap != NULL && j < bk->m; ++j) {
+        free(bk->demand_heap[j].a);
+        free(bk->safety_heap[j].a);
+    }
+    for (int i = 0; bk->sole_stuck != NULL && i < bk->n; ++i) {
+        free(bk->sole_stuck[i].a);
+    }
+    free(bk->waiters);
+    free(bk->free_waiters);
+    free(bk->waiter_head);
+    free(bk->demand_heap);
+    free(bk->safety_heap);
+    free(bk->sole_stuck);
+    free(bk->released_total);
+}
+
+// ׷ӵĩβsift = 1 ʱ key ϸάС
+static void heap_push(Banker* bk, WaitHeap* h, long long key, int w, int sift) {
+    WaitEntry e;
+    int k;
+    if (h->size == h->cap) {
+        int cap = h->cap ? h->cap * 2 : 4;
+        WaitEntry* a = (WaitEntry*)realloc(h->a, (size_t)cap * sizeof(WaitEntry));
+        if (a == NULL) return;
+        h->a = a;
+        h->cap = cap;
+    }
+    e.key = key;
+    e.waiter = w;
+    e.gen = bk->waiters[w].gen;
+    k = h->size++;
+    while (sift && k > 0 && h->a[(k - 1) / 2].key > key) {
+        h->a[k] = h->a[(k - 1) / 2];
+        k = (k - 1) / 2;
+    }
+    h->a[k] = e;
+}
+
+static WaitEntry heap_pop(WaitHeap* h) {
+    WaitEntry top = h->a[0], last = h->a[--h->size];
+    int k = 0, c;
+    while ((c = 2 * k + 1) < h->size) {
+        if (c + 1 < h->size && h->a[c + 1].key < h->a[c].key) c++;
+        if (h->a[c].key >= last.key) break;
+        h->a[k] = h->a[c];
+        k = c;
+    }
+    if (h->size > 0) h->a[k] = last;
+    return top;
+}
+
+static int entry_valid(const Banker* bk, const WaitEntry* e) {
+    return bk->waiters[e->waiter].active && bk->waiters[e->waiter].gen == e->gen;
+}
+
+// 롢룩Žһղۣزۺţ-1 = ڴ治
+static int alloc_waiter(Banker* bk, int p, const int* vec) {
+    int w;
+    Waiter* x;
+    if (bk->free_waiter_count > 0) {
+        w = bk->free_waiters[--bk->free_waiter_count];
+    }
+    else {
+        if (bk->waiter_count == bk->waiter_cap) {
+            int cap = bk->waiter_cap ? bk->waiter_cap * 2 : 16;
+            Waiter* a = (Waiter*)realloc(bk->waiters, (size_t)cap * sizeof(Waiter));
+            int* f;
+            if (a == NULL) return -1;
+            bk->waiters = a;
+            f = (int*)realloc(bk->free_waiters, (size_t)cap * sizeof(int));
+            if (f == NULL) return -1;
+            bk->free_waiters = f;
+            bk->waiter_cap = cap;
+        }
+        w = bk->waiter_count++;
+        bk->waiters[w].gen = 0;
+    }
+    x = &bk->waiters[w];
+    x->vec = bk_new_vector(bk->m);
+    if (x->vec == NULL) {
+        x->active = 0;
+        bk->free_waiters[bk->free_waiter_count++] = w;
+        return -1;
+    }
+    memcpy(x->vec, vec, (size_t)bk->padded * sizeof(int));
+    x->pid = p;
+    x->seq = ++bk->arrival_seq;
+    x->active = 1;
+    x->missing = 0;
+    x->prev_of_pid = -1;
+    x->next_of_pid = bk->waiter_head[p];
+    if (bk->waiter_head[p] >= 0) bk->waiters[bk->waiter_head[p]].prev_of_pid = w;
+    bk->waiter_head[p] = w;
+    bk->pending++;
+    return w;
+}
+
+// 뿪ȴУѷľ gen 
+static void release_waiter(Banker* bk, int w) {
+    Waiter* x = &bk->waiters[w];
+    if (x->prev_of_pid >= 0) bk->waiters[x->prev_of_pid].next_of_pid = x->next_of_pid;
+    else bk->waiter_head[x->pid] = x->next_of_pid;
+    if (x->next_of_pid >= 0) bk->waiters[x->next_of_pid].prev_of_pid = x->prev_of_pid;
+    bk_free_vector(x->vec);
+    x->active = 0;
+    x->gen++;
+    bk->free_waiters[bk->free_waiter_count++] = w;
+    bk->pending--;
+}
+
+/*
+ * ǰ״̬Ǽǵȴԭ򣨼ڿͷ
+ * Դʱ shortfallstuck һβȫµģcollect_shortfall
+ */
+static void register_waiter(Banker* bk, int w, const int* shortfall, int stuck) {
+    Waiter* x = &bk->waiters[w];
+    x->gen++;
+    x->missing = 0;
+    for (int j = 0; j < bk->m; ++j) {
+        if (x->vec[j] > bk->available[j]) {
+            x->missing++;
+            heap_push(bk, &bk->demand_heap[j], x->vec[j], w, 1);
+        }
+    }
+    if (x->missing > 0) {
+        return;
+    }
+    for (int j = 0; j < bk->m && shortfall != NULL; ++j) {
+        if (shortfall[j] > 0) {
+            heap_push(bk, &bk->safety_heap[j], bk->released_total[j] + shortfall[j], w, 1);
+        }
+    }
+    if (stuck >= 0) {
+        heap_push(bk, &bk->sole_stuck[stuck], 0, w, 0);
+    }
+}
+
+/*
+ *  p  vec롢룩ʱ㣬ŽȴУضбţ-1 = ڴ治㡣
+ * 򲻰ȫݻʱǴμ shortfall / stuckԴݻʱ shortfall  NULL
+ */
+static long long defer_request(Banker* bk, int p, const int* vec, const int* shortfall, int stuck) {
+    int w = alloc_waiter(bk, p, vec);
+    if (w < 0) {
+        return -1;
+    }
+    register_waiter(bk, w, shortfall, stuck);
+    return bk->waiters[w].seq;
+}
+
+int bk_submit(Banker* bk, int p, const int* req, long long* ticket) {
+    int result = BK_INVALID, stuck = -1;
+    long long t = -1;
+    if (p >= 0 && p < bk->n && copy_vector(bk->req, req, bk->m) == 0) {
+        result = try_request(bk, p, bk->req, bk->shortfall, &stuck);
+        if (result == BK_WAIT) {
+            t = defer_request(bk, p, bk->req, NULL, -1);
+        }
+        else if (result == BK_UNSAFE) {
+            t = defer_request(bk, p, bk->req, bk->shortfall, stuck);
+        }
+    }
+    if (ticket != NULL) {
+        *ticket = t;
+    }
+    count_result(bk, result);
+    emit(bk, BK_EV_REQUEST, p, req, result, t);
+    return result;
+}
+
+int bk_pending(const Banker* bk) {
+    return bk->pending;
+}
+
+int bk_waiting(const Banker* bk, int p) {
+    return bk->waiter_head[p] >= 0 || (bk->det != NULL && bk->det->blocked[p]);
+}
+
+int bk_waiters(const Banker* bk, BkWaiter* out, int max) {
+    int count = 0;
+    for (int w = 0; w < bk->waiter_count && count < max; ++w) {
+        const Waiter* x = &bk->waiters[w];
+        if (!x->active) continue;
+        out[count].ticket = x->seq;
+        out[count].pid = x->pid;
+        out[count].vec = x->vec;
+        out[count].missing = x->missing;
+        count++;
+    }
+    return count;
+}
+
+/* ----------------  ---------------- */
+
+typedef struct {
+    int pid;
+    const int* vec;     // 롢
+    int status;         // ADMIT_PENDING  BK_*
+    int* shortfall;     //  NULL ʱ򲻰ȫݻ¸Դȱ
+    int stuck;          // ͬϣȫΨһסḶ̌סʱΪ -1
+} BatchRequest;
+
+/*
+ * һΰȫԼõİȫ sгֵÿ p 
+ * slack[row[p]][j] = min(Available[j], min{ work_k[j] - Need[s_k][j] : s_k  p ǰ })
+ *  work_k ߵ k ʱĹ
+ *  p ֮Ľ̶Դ p ֮ǰÿһ work ۵
+ * ֻҪ׼ +  <= slack[p]ԭȫߵͨ顣 0 = ɹ
+ */
+static int compute_slack(Banker* bk, const int* seq, const int* row, int** slack) {
+    int* min_slack = bk_new_vector(bk->m);
+    if (min_slack == NULL) {
+        return 1;
+    }
+    memcpy(bk->work, bk->available, (size_t)bk->padded * sizeof(int));
+    memcpy(min_slack, bk->available, (size_t)bk->padded * sizeof(int));
+    for (int k = 0; k < bk->n; ++k) {
+        int p = seq[k];
+        if (row[p] >= 0) {
+            memcpy(slack[row[p]], min_slack, (size_t)bk->padded * sizeof(int));
+        }
+        for (int j = 0; j < bk->m; ++j) {
+            if (bk->work[j] - bk->need[p][j] < min_slack[j]) {
+                min_slack[j] = bk->work[j] - bk->need[p][j];
+            }
+        }
+        bk->add(bk->work, bk->alloc[p], bk->padded);
+    }
+    bk_free_vector(min_slack);
+    return 0;
+}
+
+/*
+ *  status Ϊ ADMIT_PENDING ̰ĵ׼󣬰Сͬ˳ǣ
+ * ȶԵǰ״̬һΰȫԼ飬İȫcompute_slack
+ * ֮ڵֱ׼ֻ O(m)ĲԷ䲢İȫԼ飬
+ * ͨμõ°ȫá
+ * һֻӷ䡢ͷţĳ˿̲ȫ֮Ҳ䰲ȫݻ󲻱ԡ
+ * ׼ĸ*checks ذȫԼڴ治ʱȫ BK_NOMEM
+ */
+static int admit_batch(Banker* bk, BatchRequest* reqs, int count, int* checks) {
+    int n = bk->n, m = bk->m;
+    long long* keys = (long long*)malloc((size_t)(count > 0 ? count : 1) * sizeof(long long));
+    int* seq = (int*)malloc((size_t)n * sizeof(int));
+    int* row = (int*)malloc((size_t)n * sizeof(int));
+    int* admitted = bk_new_vector(m);    // ϴԺֱ׼
+    int** slack = NULL;
+    int i, p, rows = 0, live = 0, granted = 0;
+
+    *checks = 0;
+    if (keys == NULL || seq == NULL || row == NULL || admitted == NULL) {
+        for (i = 0; i < count; ++i) {
+            if (reqs[i].status == ADMIT_PENDING) reqs[i].status = BK_NOMEM;
+        }
+        free(keys);
+        free(seq);
+        free(row);
+        bk_free_vector(admitted);
+        return 0;
+    }
+    for (i = 0; i < count; ++i) {
+        long long total = 0;
+        if (reqs[i].status != ADMIT_PENDING) continue;
+        for (int j = 0; j < m; ++j) {
+            total += reqs[i].vec[j];
+        }
+        keys[live++] = total * 4294967296LL + i;
+    }
+    qsort(keys, (size_t)live, sizeof(long long), compare_key);
+
+    for (p = 0; p < n; ++p) {
+        row[p] = -1;
+    }
+    for (i = 0; i < count; ++i) {
+        if (reqs[i].status == ADMIT_PENDING && row[reqs[i].pid] < 0) row[reqs[i].pid] = rows++;
+    }
+    if (live > 0) {
+        (*checks)++;
+        if (is_safe(bk, seq)) {
+            slack = new_matrix(rows, m);
+            if (slack != NULL && compute_slack(bk, seq, row, slack) != 0) {
+                free_matrix(slack);
+                slack = NULL;
+            }
+        }
+    }
+
+    for (i = 0; i < live; ++i) {
+        BatchRequest* r = &reqs[(int)(keys[i] & 0xFFFFFFFFLL)];
+        int fits = slack != NULL;
+        for (int j = 0; j < m && fits; ++j) {
+            fits = admitted[j] + r->vec[j] <= slack[row[r->pid]][j];
+        }
+        r->status = tentative_grant(bk, r->pid, r->vec);
+        if (r->status != ADMIT_PENDING) {
+            continue;
+        }
+        if (fits) {
+            bk->add(admitted, r->vec, bk->padded);
+        }
+        else {
+            (*checks)++;
+            if (!is_safe(bk, seq)) {
+                if (r->shortfall != NULL) {
+                    collect_shortfall(bk, r->shortfall, &r->stuck);
+                }
+                revoke_grant(bk, r->pid, r->vec);
+                r->status = BK_UNSAFE;
+                continue;
+            }
+            if (slack != NULL) {
+                memset(admitted, 0, (size_t)bk->padded * sizeof(int));
+                compute_slack(bk, seq, row, slack);
+            }
+        }
+        r->status = BK_GRANTED;
+        granted++;
+    }
+
+    free_matrix(slack);
+    free(keys);
+    free(seq);
+    free(row);
+    bk_free_vector(admitted);
+    return granted;
+}
+
+int bk_admit_batch(Banker* bk, BkBatchItem* items, int count, int defer, int* checks) {
+    BatchRequest* reqs = (BatchRequest*)malloc((size_t)(count > 0 ? count : 1) * sizeof(BatchRequest));
+    int** vecs = count > 0 ? new_matrix(count, bk->m) : NULL;
+    int** shortfall = defer && count > 0 ? new_matrix(count, bk->m) : NULL;
+    int granted = 0, dummy;
+
+    if (checks == NULL) {
+        checks = &dummy;
+    }
+    *checks = 0;
+    if (reqs == NULL || (count > 0 && vecs == NULL) || (defer && count > 0 && shortfall == NULL)) {
+        for (int i = 0; i < count; ++i) {
+            items[i].result = BK_NOMEM;
+            items[i].ticket = -1;
+        }
+        free(reqs);
+        free_matrix(vecs);
+        free_matrix(shortfall);
+        return 0;
+    }
+    for (int i = 0; i < count; ++i) {
+        int p = items[i].pid;
+        reqs[i].pid = p;
+        reqs[i].vec = vecs[i];
+        reqs[i].shortfall = shortfall != NULL ? shortfall[i] : NULL;
+        reqs[i].stuck = -1;
+        reqs[i].status = p >= 0 && p < bk->n && copy_vector(vecs[i], items[i].vec, bk->m) == 0
+            ? ADMIT_PENDING : BK_INVALID;
+    }
+    granted = admit_batch(bk, reqs, count, checks);
+    for (int i = 0; i < count; ++i) {
+        BatchRequest* r = &reqs[i];
+        items[i].result = r->status;
+        items[i].ticket = -1;
+        if (defer && r->status == BK_WAIT) {
+            items[i].ticket = defer_request(bk, r->pid, r->vec, NULL, -1);
+        }
+        else if (defer && r->status == BK_UNSAFE) {
+            items[i].ticket = defer_request(bk, r->pid, r->vec, r->shortfall, r->stuck);
+        }
+        count_result(bk, r->status);
+        emit(bk, BK_EV_REQUEST, r->pid, items[i].vec, r->status, items[i].ticket);
+    }
+    free(reqs);
+    free_matrix(vecs);
+    free_matrix(shortfall);
+    return granted;
+}
+
+/*
+ * ѱѵĵȴ ids[0..count) һ admit_batch
+ * ׼ĺѳ Need 뿪У BK_EV_WAKEȻݻİµԭµǼ
+ */
+static void admit_waiters(Banker* bk, const int* ids, int count) {
+    BatchRequest* reqs;
+    int** shortfall;
+    int checks, granted = 0;
+
+    if (count == 0) {
+        return;
+    }
+    reqs = (BatchRequest*)malloc((size_t)count * sizeof(BatchRequest));
+    shortfall = new_matrix(count, bk->m);
+    if (reqs == NULL || shortfall == NULL) {
+        // ڴ治㣺ڶֻԴµǼ
+        for (int i = 0; i < count; ++i) {
+            register_waiter(bk, ids[i], NULL, -1);
+        }
+        free(reqs);
+        free_matrix(shortfall);
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        reqs[i].pid = bk->waiters[ids[i]].pid;
+        reqs[i].vec = bk->waiters[ids[i]].vec;
+        reqs[i].status = ADMIT_PENDING;
+        reqs[i].shortfall = shortfall[i];
+        reqs[i].stuck = -1;
+    }
+    admit_batch(bk, reqs, count, &checks);
+    bk->st.wake_checks += count;
+    for (int i = 0; i < count; ++i) {
+        Waiter* x = &bk->waiters[ids[i]];
+        int status = reqs[i].status;
+        if (status == BK_WAIT || status == BK_UNSAFE || status == BK_NOMEM) {
+            register_waiter(bk, ids[i], status == BK_UNSAFE ? reqs[i].shortfall : NULL, reqs[i].stuck);
+            continue;
+        }
+        granted += status == BK_GRANTED;
+        emit(bk, BK_EV_WAKE, x->pid, x->vec, status, x->seq);
+        release_waiter(bk, ids[i]);
+    }
+    bk->st.wake_granted += granted;
+    free(reqs);
+    free_matrix(shortfall);
+}
+
+// ռѡѶѶֵ <= limit Ч
+static void pop_woken(Banker* bk, WaitHeap* h, long long limit, int demand, int** ids, int* count, int* cap) {
+    while (h->size > 0 && h->a[0].key <= limit) {
+        WaitEntry e = heap_pop(h);
+        if (!entry_valid(bk, &e)) continue;
+        if (demand && --bk->waiters[e.waiter].missing > 0) continue;
+        bk->waiters[e.waiter].gen++;      // ѳΪѡ𴦵ľ
+        if (*count == *cap) {
+            int c = *cap ? *cap * 2 : 16;
+            int* a = (int*)realloc(*ids, (size_t)c * sizeof(int));
+            if (a == NULL) continue;
+            *ids = a;
+            *cap = c;
+        }
+        (*ids)[(*count)++] = e.waiter;
+    }
+}
+
+// Դ j  q 󣬻Ӱĵȴ¼飻q < 0 ʾûн̽
+static void wake_waiters(Banker* bk, const int* released, int q) {
+    int* ids = NULL;
+    int count = 0, cap = 0;
+    if (bk->pending == 0) {
+        return;
+    }
+    for (int j = 0; j < bk->m; ++j) {
+        if (released[j] > 0) {
+            pop_woken(bk, &bk->demand_heap[j], bk->available[j], 1, &ids, &count, &cap);
+            pop_woken(bk, &bk->safety_heap[j], bk->released_total[j], 0, &ids, &count, &cap);
+        }
+    }
+    if (q >= 0) {
+        pop_woken(bk, &bk->sole_stuck[q], 0, 0, &ids, &count, &cap);
+    }
+    admit_waiters(bk, ids, count);
+    free(ids);
+}
+
+int bk_release(Banker* bk, int p, const int* vec) {
+    int result = 0;
+    if (p < 0 || p >= bk->n) {
+        result = -1;
+    }
+    for (int j = 0; j < bk->m && result == 0; ++j) {
+        if (vec[j] < 0 || vec[j] > bk->alloc[p][j]) result = -1;
+    }
+    if (result == 0 && touch_row(bk, p) != 0) {
+        result = -1;
+    }
+    if (result == 0) {
+        for (int j = 0; j < bk->m; ++j) {
+            if (vec[j] != 0) {
+                bk->available[j] += vec[j];
+                bk->alloc[p][j] -= vec[j];
+                bk->released_total[j] += vec[j];
+                update_need(bk, p, j, vec[j]);
+            }
+        }
+        bk->st.releases++;
+    }
+    emit(bk, BK_EV_RELEASE, p, vec, result, -1);
+    if (result == 0) {
+        wake_waiters(bk, vec, -1);
+    }
+    return result;
+}
+
+int bk_exit(Banker* bk, int p) {
+    int* released;
+    if (p < 0 || p >= bk->n || touch_row(bk, p) != 0 || (released = bk_new_vector(bk->m)) == NULL) {
+        return -1;
+    }
+    while (bk->waiter_head[p] >= 0) {
+        release_waiter(bk, bk->waiter_head[p]);
+    }
+    memcpy(released, bk->alloc[p], (size_t)bk->padded * sizeof(int));
+    for (int j = 0; j < bk->m; ++j) {
+        bk->available[j] += released[j];
+        bk->released_total[j] += released[j];
+        bk->alloc[p][j] = 0;
+        bk->max[p][j] = 0;
+        update_need(bk, p, j, -bk->need[p][j]);
+    }
+    bk->st.exits++;
+    emit(bk, BK_EV_EXIT, p, released, 0, -1);
+    wake_waiters(bk, released, p);
+    bk_free_vector(released);
+    return 0;
+}
+
+/* ---------------- 벢 ---------------- */
+
+BkSnapshot* bk_snapshot(Banker* bk) {
+    int n = bk->n;
+    BkSnapshot* s = (BkSnapshot*)calloc(1, sizeof(BkSnapshot));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->available = bk_new_vector(bk->m);
+    s->allocation = (int**)malloc((size_t)n * sizeof(int*));
+    s->need = (int**)malloc((size_t)n * sizeof(int*));
+    s->hint = (int*)malloc((size_t)n * sizeof(int));
+    if (s->available == NULL || s->allocation == NULL || s->need == NULL || s->hint == NULL) {
+        bk_free_vector(s->available);
+        free(s->allocation);
+        free(s->need);
+        free(s->hint);
+        free(s);
+        return NULL;
+    }
+    // ǰ״̬ȫʱİȫΪļ˳
+    if (!is_safe(bk, s->hint)) {
+        free(s->hint);
+        s->hint = NULL;
+    }
+    s->n = n;
+    s->m = bk->m;
+    s->padded = bk->padded;
+    s->less_equal = bk->less_equal;
+    s->add = bk->add;
+    memcpy(s->available, bk->available, (size_t)bk->padded * sizeof(int));
+    memcpy(s->allocation, bk->alloc, (size_t)n * sizeof(int*));
+    memcpy(s->need, bk->need, (size_t)n * sizeof(int*));
+    s->epoch = ++bk->snap_epoch;
+    s->next = bk->live;
+    bk->live = s;
+    return s;
+}
+
+void bk_drop_snapshot(Banker* bk, BkSnapshot* s) {
+    BkSnapshot** link = &bk->live;
+    int oldest = INT_MAX, k = 0;
+    while (*link != s) {
+        link = &(*link)->next;
+    }
+    *link = s->next;
+    bk_free_vector(s->available);
+    free(s->allocation);
+    free(s->need);
+    free(s->hint);
+    free(s);
+    // ղٱκοõľ
+    for (BkSnapshot* x = bk->live; x != NULL; x = x->next) {
+        if (x->epoch < oldest) oldest = x->epoch;
+    }
+    for (int i = 0; i < bk->retired_count; ++i) {
+        if (bk->retired_epoch[i] < oldest) {
+            bk_free_vector(bk->retired_rows[i]);
+        }
+        else {
+            bk->retired_rows[k] = bk->retired_rows[i];
+            bk->retired_epoch[k++] = bk->retired_epoch[i];
+        }
+    }
+    bk->retired_count = k;
+}
+
+BkScratch* bk_scratch_create(const Banker* bk) {
+    BkScratch* sc = (BkScratch*)calloc(1, sizeof(BkScratch));
+    if (sc == NULL) {
+        return NULL;
+    }
+    sc->req = bk_new_vector(bk->m);
+    sc->work = bk_new_vector(bk->m);
+    sc->need_row = bk_new_vector(bk->m);
+    sc->alloc_row = bk_new_vector(bk->m);
+    sc->pending = (int*)malloc((size_t)bk->n * sizeof(int));
+    if (sc->req == NULL || sc->work == NULL || sc->need_row == NULL || sc->alloc_row == NULL ||
+        sc->pending == NULL) {
+        bk_scratch_destroy(sc);
+        return NULL;
+    }
+    return sc;
+}
+
+void bk_scratch_destroy(BkScratch* sc) {
+    if (sc == NULL) {
+        return;
+    }
+    bk_free_vector(sc->req);
+    bk_free_vector(sc->work);
+    bk_free_vector(sc->need_row);
+    bk_free_vector(sc->alloc_row);
+    free(sc->pending);
+    free(sc);
+}
+
+/*
+ * ֻաֻд scڶ߳ͬʱá
+ * ȫԼ鰴յĽ˳ɨ裺ִͷԴִвһ֣
+ * ֱȫִ꣨ȫһûнչȫ˳İȫʱһһ־͹ O(n^2m)
+ */
+int bk_evaluate(const BkSnapshot* s, int p, const int* req, BkScratch* sc) {
+    int n = s->n, padded = s->padded, count = n, progress;
+    if (p < 0 || p >= n || copy_vector(sc->req, req, s->m) != 0 ||
+        !s->less_equal(sc->req, s->need[p], padded)) {
+        return BK_INVALID;
+    }
+    if (!s->less_equal(sc->req, s->available, padded)) {
+        return BK_WAIT;
+    }
+    for (int j = 0; j < padded; ++j) {
+        sc->work[j] = s->available[j] - sc->req[j];
+        sc->need_row[j] = s->need[p][j] - sc->req[j];
+        sc->alloc_row[j] = s->allocation[p][j] + sc->req[j];
+    }
+    for (int i = 0; i < n; ++i) {
+        sc->pending[i] = s->hint != NULL ? s->hint[i] : i;
+    }
+    do {
+        int k = 0;
+        progress = 0;
+        for (int i = 0; i < count; ++i) {
+            int q = sc->pending[i];
+            if (s->less_equal(q == p ? sc->need_row : s->need[q], sc->work, padded)) {
+                s->add(sc->work, q == p ? sc->alloc_row : s->allocation[q], padded);
+                progress = 1;
+            }
+            else {
+                sc->pending[k++] = q;
+            }
+        }
+        count = k;
+    } while (count > 0 && progress);
+    return count == 0 ? BK_GRANTED : BK_UNSAFE;
+}
+
+/* ---------------- ⣺Դͼ +  ---------------- */
+
+static void free_detector(Banker* bk) {
+    Detector* d = bk->det;
+    if (d == NULL) {
+        return;
+    }
+    for (int v = 0; d->out_edges != NULL && d->in_edges != NULL && v < bk->n + bk->m; ++v) {
+        free(d->out_edges[v].a);
+        free(d->in_edges[v].a);
+    }
+    free_matrix(d->pending_req);
+    free(d->blocked);
+    free(d->blocked_list);
+    free(d->blocked_pos);
+    free(d->out_edges);
+    free(d->in_edges);
+    free(d->topo_ord);
+    free(d->topo_node);
+    free(d->visit_stamp);
+    free(d->edge_mark);
+    free(d->dfs_stack);
+    free(d->dfs_forward);
+    free(d->dfs_backward);
+    free(d->dfs_slots);
+    free(d->sort_keys);
+    free(d);
+    bk->det = NULL;
+}
+
+static void edge_add(EdgeList* l, int v) {
+    if (l->size == l->cap) {
+        int cap = l->cap ? l->cap * 2 : 4;
+        int* a = (int*)realloc(l->a, (size_t)cap * sizeof(int));
+        if (a == NULL) return;
+        l->a = a;
+        l->cap = cap;
+    }
+    l->a[l->size++] = v;
+}
+
+static void edge_remove(EdgeList* l, int v) {
+    for (int k = 0; k < l->size; ++k) {
+        if (l->a[k] == v) {
+            l->a[k] = l->a[--l->size];
+            return;
+        }
+    }
+}
+
+/*
+ * һüģʽʱ䣬ǰ Allocation ó߱ 0 = ɹ
+ * ʼʱֻзߣԴнǰһ
+ */
+static int init_detector(Banker* bk) {
+    int n = bk->n, m = bk->m, nodes = n + m;
+    Detector* d;
+    if (bk->det != NULL) {
+        return 0;
+    }
+    d = bk->det = (Detector*)calloc(1, sizeof(Detector));
+    if (d == NULL) {
+        return 1;
+    }
+    d->pending_req = new_matrix(n, m);
+    d->blocked = (int*)calloc((size_t)n, sizeof(int));
+    d->blocked_list = (int*)malloc((size_t)n * sizeof(int));
+    d->blocked_pos = (int*)malloc((size_t)n * sizeof(int));
+    d->out_edges = (EdgeList*)calloc((size_t)nodes, sizeof(EdgeList));
+    d->in_edges = (EdgeList*)calloc((size_t)nodes, sizeof(EdgeList));
+    d->topo_ord = (int*)malloc((size_t)nodes * sizeof(int));
+    d->topo_node = (int*)malloc((size_t)nodes * sizeof(int));
+    d->visit_stamp = (int*)calloc((size_t)nodes, sizeof(int));
+    d->edge_mark = (int*)calloc((size_t)m, sizeof(int));
+    d->dfs_stack = (int*)malloc((size_t)nodes * sizeof(int));
+    d->dfs_forward = (int*)malloc((size_t)nodes * sizeof(int));
+    d->dfs_backward = (int*)malloc((size_t)nodes * sizeof(int));
+    d->dfs_slots = (int*)malloc((size_t)nodes * 2 * sizeof(int));
+    d->sort_keys = (long long*)malloc((size_t)nodes * sizeof(long long));
+    if (d->pending_req == NULL || d->blocked == NULL || d->blocked_list == NULL || d->blocked_pos == NULL ||
+        d->out_edges == NULL || d->in_edges == NULL || d->topo_ord == NULL || d->topo_node == NULL ||
+        d->visit_stamp == NULL || d->edge_mark == NULL || d->dfs_stack == NULL ||
+        d->dfs_forward == NULL || d->dfs_backward == NULL || d->dfs_slots == NULL || d->sort_keys == NULL) {
+        free_detector(bk);
+        return 1;
+    }
+    d->holders = d->out_edges + n;
+    for (int j = 0; j < m; ++j) {
+        d->topo_ord[n + j] = j;
+        d->topo_node[j] = n + j;
+    }
+    for (int i = 0; i < n; ++i) {
+        d->topo_ord[i] = m + i;
+        d->topo_node[m + i] = i;
+        for (int j = 0; j < m; ++j) {
+            if (bk->alloc[i][j] == 0) continue;
+            edge_add(&d->holders[j], i);
+            edge_add(&d->in_edges[i], n + j);
+        }
+    }
+    return 0;
+}
+
+static int compare_int(const void* x, const void* y) {
+    int a = *(const int*)x, b = *(const int*)y;
+    return a < b ? -1 : a > b;
+}
+
+// λ a[0..count) = λá2^32 + 
+static void sort_by_ord(Detector* d, int* a, int count) {
+    for (int k = 0; k < count; ++k) {
+        d->sort_keys[k] = (long long)d->topo_ord[a[k]] * 4294967296LL + a[k];
+    }
+    qsort(d->sort_keys, (size_t)count, sizeof(long long), compare_key);
+    for (int k = 0; k < count; ++k) {
+        a[k] = (int)(d->sort_keys[k] & 0xFFFFFFFFLL);
+    }
+}
+
+/*
+ *  start  edges  DFSֻλ [lo, hi] ڵĵ㣬ʵĵ out
+ *  target  1ɻ
+ */
+static int bounded_dfs(Detector* d, int start, const EdgeList* edges, int lo, int hi, int target, int* out, int* count) {
+    int top = 0;
+    d->dfs_stack[top++] = start;
+    d->visit_stamp[start] = d->stamp;
+    while (top > 0) {
+        int v = d->dfs_stack[--top];
+        out[(*count)++] = v;
+        for (int k = 0; k < edges[v].size; ++k) {
+            int w = edges[v].a[k];
+            if (w == target) return 1;
+            if (d->visit_stamp[w] != d->stamp && d->topo_ord[w] >= lo && d->topo_ord[w] <= hi) {
+                d->visit_stamp[w] = d->stamp;
+                d->dfs_stack[top++] = w;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Pearce-Kelly x -> y άord[x] < ord[y] ʱʲô
+ * ֻ [ord[y], ord[x]] һҳ y ǰܵĵ F ʹ x ܵĵ B
+ * Щռλ·ɡB ǰF ں󡱡 1 = ӱߺɻ򲻱䣩
+ */
+static int pk_insert(Detector* d, int x, int y) {
+    int lo = d->topo_ord[y], hi = d->topo_ord[x], nf = 0, nb = 0;
+    if (lo > hi) {
+        return 0;
+    }
+    d->stamp++;
+    if (bounded_dfs(d, y, d->out_edges, lo, hi, x, d->dfs_forward, &nf)) {
+        return 1;
+    }
+    bounded_dfs(d, x, d->in_edges, lo, hi, -1, d->dfs_backward, &nb);
+    sort_by_ord(d, d->dfs_forward, nf);
+    sort_by_ord(d, d->dfs_backward, nb);
+    for (int k = 0; k < nb; ++k) d->dfs_slots[k] = d->topo_ord[d->dfs_backward[k]];
+    for (int k = 0; k < nf; ++k) d->dfs_slots[nb + k] = d->topo_ord[d->dfs_forward[k]];
+    qsort(d->dfs_slots, (size_t)(nb + nf), sizeof(int), compare_int);
+    for (int k = 0; k < nb; ++k) {
+        d->topo_ord[d->dfs_backward[k]] = d->dfs_slots[k];
+        d->topo_node[d->dfs_slots[k]] = d->dfs_backward[k];
+    }
+    for (int k = 0; k < nf; ++k) {
+        d->topo_ord[d->dfs_forward[k]] = d->dfs_slots[nb + k];
+        d->topo_node[d->dfs_slots[nb + k]] = d->dfs_forward[k];
+    }
+    return 0;
+}
+
+// һ x -> y÷ȥأлʱֻǱߣά
+static void insert_edge(Banker* bk, int x, int y) {
+    Detector* d = bk->det;
+    edge_add(&d->out_edges[x], y);
+    edge_add(&d->in_edges[y], x);
+    bk->st.edge_inserts++;
+    if (!d->graph_cyclic && pk_insert(d, x, y)) {
+        d->graph_cyclic = 1;
+        bk->st.cycle_hits++;
+    }
+}
+
+//  p ÿԴһߣp ʱûгߣȥأ
+static void add_wait_edges(Banker* bk, int p) {
+    Detector* d = bk->det;
+    for (int j = 0; j < bk->m; ++j) {
+        if (d->pending_req[p][j] > bk->available[j]) insert_edge(bk, p, bk->n + j);
+    }
+}
+
+/*
+ * հ vec ȥAvailable ѿ۳ÿ p  vec 漰ÿԴ j
+ * η p  j ϲ p -> n+j
+ * p ܻŵ j ľߣȰ p еĳ edge_mark ϱֵĴ
+ * лʱάߣؽ
+ */
+static void add_grant_edges(Banker* bk, int q, const int* vec) {
+    Detector* d = bk->det;
+    if (d->graph_cyclic) {
+        return;
+    }
+    for (int b = 0; b < d->blocked_count; ++b) {
+        int p = d->blocked_list[b], marked = 0;
+        if (p == q) continue;
+        for (int j = 0; j < bk->m; ++j) {
+            if (vec[j] == 0 || d->pending_req[p][j] <= bk->available[j] ||
+                d->pending_req[p][j] > bk->available[j] + vec[j]) {
+                continue;       // Ȼ֮ǰͲڣ
+            }
+            if (!marked) {
+                const EdgeList* out = &d->out_edges[p];
+                d->edge_stamp++;
+                for (int k = 0; k < out->size; ++k) d->edge_mark[out->a[k] - bk->n] = d->edge_stamp;
+                marked = 1;
+            }
+            if (d->edge_mark[j] != d->edge_stamp) {
+                d->edge_mark[j] = d->edge_stamp;
+                insert_edge(bk, p, bk->n + j);
+            }
+        }
+    }
+}
+
+//  vec  qAllocation  0 Դӷߣٸ˲̲
+static void detect_grant(Banker* bk, int q, const int* vec) {
+    for (int j = 0; j < bk->m; ++j) {
+        if (vec[j] == 0) continue;
+        if (bk->alloc[q][j] == 0) insert_edge(bk, bk->n + j, q);
+        bk->available[j] -= vec[j];
+        bk->alloc[q][j] += vec[j];
+    }
+    add_grant_edges(bk, q, vec);
+}
+
+static void remove_wait_edges(Banker* bk, int p) {
+    Detector* d = bk->det;
+    for (int k = 0; k < d->out_edges[p].size; ++k) {
+        edge_remove(&d->in_edges[d->out_edges[p].a[k]], p);
+    }
+    d->out_edges[p].size = 0;
+}
+
+/*
+ * ǰ״̬ؽߣһֱ׼ȷģ Kahn 㷨
+ * ޻ָģʽgraph_cyclic = 0л graph_cyclic = 1
+ */
+static void rebuild_wait_graph(Banker* bk) {
+    Detector* d = bk->det;
+    int n = bk->n, nodes = n + bk->m, head = 0, tail = 0;
+    int* indeg = d->dfs_slots;
+    for (int v = 0; v < n; ++v) {
+        d->out_edges[v].size = 0;
+    }
+    for (int v = n; v < nodes; ++v) {
+        d->in_edges[v].size = 0;
+    }
+    d->graph_cyclic = 1;            // ؽʱά
+    for (int v = 0; v < n; ++v) {
+        if (d->blocked[v]) add_wait_edges(bk, v);
+    }
+    for (int v = 0; v < nodes; ++v) {
+        indeg[v] = d->in_edges[v].size;
+        if (indeg[v] == 0) d->dfs_stack[tail++] = v;
+    }
+    while (head < tail) {
+        int v = d->dfs_stack[head];
+        d->topo_ord[v] = head;
+        d->topo_node[head++] = v;
+        for (int k = 0; k < d->out_edges[v].size; ++k) {
+            if (--indeg[d->out_edges[v].a[k]] == 0) d->dfs_stack[tail++] = d->out_edges[v].a[k];
+        }
+    }
+    d->graph_cyclic = tail < nodes;
+    if (d->graph_cyclic) {
+        // лʱʹãָһϷм
+        for (int v = 0; v < nodes; ++v) d->topo_ord[v] = d->topo_node[v] = v;
+    }
+}
+
+/*
+ * ʵ⣨ԼûĽɲ黹Դ
+ * ٷ pending_req <= work ̹ԼԼḷ̌д dead[]ظ
+ */
+static int reduce_deadlock(Banker* bk, int* dead) {
+    Detector* d = bk->det;
+    int* waiting = d->dfs_forward;
+    int count = 0, progress = 1;
+    bk->st.reductions++;
+    memcpy(bk->work, bk->available, (size_t)bk->padded * sizeof(int));
+    for (int i = 0; i < bk->n; ++i) {
+        if (d->blocked[i]) waiting[count++] = i;
+        else bk->add(bk->work, bk->alloc[i], bk->padded);
+    }
+    while (progress) {
+        progress = 0;
+        for (int k = 0; k < count; ++k) {
+            if (bk->less_equal(d->pending_req[waiting[k]], bk->work, bk->padded)) {
+                bk->add(bk->work, bk->alloc[waiting[k]], bk->padded);
+                waiting[k--] = waiting[--count];
+                progress = 1;
+            }
+        }
+    }
+    memcpy(dead, waiting, (size_t)count * sizeof(int));
+    return count;
+}
+
+int bk_detect_reduce(Banker* bk, int* dead, int rebuild) {
+    int count;
+    if (init_detector(bk) != 0) {
+        return 0;
+    }
+    count = reduce_deadlock(bk, dead);
+    if (rebuild) {
+        rebuild_wait_graph(bk);
+        bk->det->blocks_since_reduce = 0;
+    }
+    return count;
+}
+
+int bk_detect_request(Banker* bk, int p, const int* req, int* dead, int* dead_count) {
+    Detector* d;
+    int j;
+    *dead_count = 0;
+    if (init_detector(bk) != 0 || touch_row(bk, p) != 0) {
+        return -1;
+    }
+    d = bk->det;
+    for (j = 0; j < bk->m; ++j) {
+        if (req[j] > bk->available[j]) break;
+    }
+    if (j == bk->m) {
+        detect_grant(bk, p, req);
+        return 1;
+    }
+    memcpy(d->pending_req[p], req, (size_t)bk->m * sizeof(int));
+    d->blocked[p] = 1;
+    d->blocked_pos[p] = d->blocked_count;
+    d->blocked_list[d->blocked_count++] = p;
+    if (!d->graph_cyclic) {
+        add_wait_edges(bk, p);
+        if (d->graph_cyclic) {
+            // ճɻԼȷϣؽ
+            *dead_count = bk_detect_reduce(bk, dead, 1);
+        }
+    }
+    else if (++d->blocks_since_reduce >= DETECT_PERIOD) {
+        *dead_count = bk_detect_reduce(bk, dead, 1);
+    }
+    return 0;
+}
+
+// Ľ p õ򱻳ɾ
+static void unblock(Banker* bk, int p) {
+    Detector* d = bk->det;
+    int last;
+    if (!d->blocked[p]) {
+        return;
+    }
+    last = d->blocked_list[--d->blocked_count];
+    d->blocked_list[d->blocked_pos[p]] = last;
+    d->blocked_pos[last] = d->blocked_pos[p];
+    d->blocked[p] = 0;
+    if (!d->graph_cyclic) remove_wait_edges(bk, p);
+}
+
+int bk_detect_release(Banker* bk, int p, const int* vec) {
+    Detector* d;
+    int granted = 0;
+    if (init_detector(bk) != 0 || touch_row(bk, p) != 0) {
+        return 0;
+    }
+    d = bk->det;
+    for (int j = 0; j < bk->m; ++j) {
+        bk->available[j] += vec[j];
+        bk->alloc[p][j] -= vec[j];
+        if (vec[j] != 0 && bk->alloc[p][j] == 0) {
+            // ٳ jɾߣɾ߲ƻ
+            edge_remove(&d->holders[j], p);
+            edge_remove(&d->in_edges[p], bk->n + j);
+        }
+    }
+    for (int i = 0; i < bk->n; ++i) {
+        int j;
+        if (!d->blocked[i]) continue;
+        for (j = 0; j < bk->m && d->pending_req[i][j] <= bk->available[j]; ++j) {
+        }
+        if (j < bk->m || touch_row(bk, i) != 0) continue;
+        unblock(bk, i);
+        detect_grant(bk, i, d->pending_req[i]);
+        granted++;
+    }
+    return granted;
+}
+
+int bk_detect_abort(Banker* bk, int p) {
+    int* held;
+    int granted;
+    if (init_detector(bk) != 0 || (held = bk_new_vector(bk->m)) == NULL) {
+        return 0;
+    }
+    memcpy(held, bk->alloc[p], (size_t)bk->m * sizeof(int));
+    unblock(bk, p);
+    granted = bk_detect_release(bk, p, held);
+    bk_free_vector(held);
+    return granted;
+}
@@ -0,0 +1,196 @@
+/*
+ * м㷨
+ * AvailableMaxAllocationNeedȴСԴͼͿն Banker 
+ * κҲͬһ Banker ֻһ߳ʹãͬ Banker ɣ
+ * Ψһǿգºڱ߳ bk_evaluate £
+ * м㷨ȫĽǰˣܲ׼ģʾҲ
+ * Ҫ̹߳һԴʱáԴ-м㷨
+ *
+ * ȫԼˣ / AVX2 / AVX-512 CPU ѡɨ༸֣ûнʱ
+ * ÿԴ Need Ľ O(nm)
+ * ӿͨ m  intڲٿж롢
+ */
+#ifndef BANKER_H
+#define BANKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ľbk_requestbk_submitbk_admit_batchbk_evaluate
+#define BK_GRANTED 0    // ѷ
+#define BK_WAIT    1    // Դ״̬
+#define BK_UNSAFE  2    // 󲻰ȫ״̬
+#define BK_INVALID 3    // ̺ŷǷָ򳬹ʣ Need״̬
+#define BK_NOMEM   4    // ڴ治㣬״̬
+
+// ¼
+#define BK_EV_REQUEST 0 // 루bk_requestbk_submit
+#define BK_EV_RELEASE 1 // 黹bk_release
+#define BK_EV_EXIT    2 // ̽bk_exitvec Ϊ黹Դ
+#define BK_EV_WAKE    3 // ȴ󱻻Ѻ뿪Уresult Ϊ BK_GRANTED  BK_INVALIDѳ Need
+
+// ȫԼķbk_check_safe
+#define BK_CHECK_AUTO    0  // ɨ༸֣ûнbk_is_safe 
+#define BK_CHECK_INDEXED 1  // ֻO(nm)
+#define BK_CHECK_NAIVE   2  // ɨֱûб仯 O(n^2m)ֻ
+
+typedef struct Banker Banker;
+typedef struct BkSnapshot BkSnapshot;
+typedef struct BkScratch BkScratch;
+
+typedef struct {
+    int type;
+    int pid;
+    const int* vec;     // 黹ֻڻصڼЧ
+    int result;         // 롢ѣBK_*黹0 = ɹ-1 = Ƿ0
+    long long ticket;   // ڵȴıţ漰ȴʱΪ -1
+} BkEvent;
+
+typedef void (*BkEventFn)(void* user, const BkEvent* ev);
+
+typedef struct {
+    long long requests;
+    long long granted;
+    long long waits;
+    long long unsafe;
+    long long invalid;
+    long long releases;
+    long long exits;
+    long long safety_checks;
+    long long wake_checks;      // Ѻ¼ĵȴ
+    long long wake_granted;     // Ѻ׼ĵȴ
+    long long cow_copies;       // Ϊ˲Ķնƹ
+    long long edge_inserts;     // ⣺Դͼӱߴ
+    long long cycle_hits;       // ⣺ӱߺɻĴ
+    long long reductions;       // ⣺ʵԼ
+} BkStats;
+
+// ȴһbk_waiters
+typedef struct {
+    long long ticket;
+    int pid;
+    const int* vec;     // һ޸״̬֮ǰЧ
+    int missing;        // Դ0 ʾԴˣڵ״̬䰲ȫ
+} BkWaiter;
+
+// еһbk_admit_batch
+typedef struct {
+    int pid;
+    const int* vec;
+    int result;         // BK_*
+    long long ticket;   // defer ʱݻڵȴıţΪ -1
+} BkBatchItem;
+
+/*
+ * n ̡m Դavailable[m]max  alloc Ϊ n  m дţalloc Ϊ NULL ʾȫ 0
+ *  NULL ʾǷAllocation  Maxָڴ治㣻Ҫʼ״̬ȫ
+ */
+Banker* bk_create(int n, int m, const int* available, const int* max, const int* alloc);
+// ĿҪȫͷ
+void bk_destroy(Banker* bk);
+
+void bk_set_callback(Banker* bk, BkEventFn fn, void* user);
+
+// CPU ϵͳֵ֧0 = 1 = AVX22 = AVX-512
+int bk_simd_level(void);
+//  Banker һˣ bk_simd_level() İbk_create ʱȡ߼
+void bk_set_simd(Banker* bk, int level);
+
+//  p  req[m]Էȫ䣬״̬䣻 BK_*
+int bk_request(Banker* bk, int p, const int* req);
+
+/*
+ * ͬ bk_request BK_WAITBK_UNSAFE ȴУԴ黹ʱԶ¼
+ * ͨ BK_EV_WAKE ¼ticket Ϊ NULL ʱдбţûд -1
+ */
+int bk_submit(Banker* bk, int p, const int* req, long long* ticket);
+
+/*
+ *  count 룬̰ĵ׼С󣩣д items[k].result
+ * ϴΰȫС֮ڵȫԼ顣defer = 1 ʱݻȴС
+ * ׼ĸchecks Ϊ NULL ʱд밲ȫԼ
+ */
+int bk_admit_batch(Banker* bk, BkBatchItem* items, int count, int defer, int* checks);
+
+//  p 黹 vec[m]Max 䣩Ȼѵȴ󣻷 0 = ɹ-1 = ̺ŷǷ򳬹ѷ״̬
+int bk_release(Banker* bk, int p, const int* vec);
+
+//  p ĵȴ󣬹黹ȫԴMax 㣬Ȼѵȴ󣻷 0 = ɹ-1 = ̺ŷǷ
+int bk_exit(Banker* bk, int p);
+
+// ǰ״̬Ƿȫseq Ϊ NULL ҰȫʱдһȫУn ̺ţ
+int bk_is_safe(Banker* bk, int* seq);
+// ͬ bk_is_safeָ鷽 BK_CHECK_*BK_CHECK_NAIVE ڴ治ʱȫ
+int bk_check_safe(Banker* bk, int method, int* seq);
+
+int bk_available(const Banker* bk, int j);
+int bk_max(const Banker* bk, int p, int j);
+int bk_allocation(const Banker* bk, int p, int j);
+int bk_need(const Banker* bk, int p, int j);
+
+// ȴ
+int bk_pending(const Banker* bk);
+//  p Ƿڵȣȴ󣬻ģʽ
+int bk_waiting(const Banker* bk, int p);
+// λ˳д max ȴ󣬷дĸ
+int bk_waiters(const Banker* bk, BkWaiter* out, int max);
+
+void bk_get_stats(const Banker* bk, BkStats* stats);
+
+/*
+ * дʱƿգʱֻ Available ָ루O(n + m)֮ʵʱ״̬һвŸһС
+ * Ŀաͷſնʹ Banker ߳ºٱ仯
+ * ߳ͬʱ bk_evaluate ÿ߳һ BkScratchͬʱʵʱ״̬ճ޸ġ
+ *  NULL ʾڴ治
+ */
+BkSnapshot* bk_snapshot(Banker* bk);
+void bk_drop_snapshot(Banker* bk, BkSnapshot* s);
+
+// õĹ bk Ĺģ䣻 NULL ʾڴ治
+BkScratch* bk_scratch_create(const Banker* bk);
+void bk_scratch_destroy(BkScratch* sc);
+
+/*
+ * ڿ s жϽ p  req ڷ޸κ״̬
+ *  BK_GRANTEDȫ׼BK_WAITBK_UNSAFEBK_INVALID
+ */
+int bk_evaluate(const BkSnapshot* s, int p, const int* req, BkScratch* sc);
+
+/*
+ * ģʽ MaxȫԼ飬빻ͷ䣬Դͼ
+ * ͬһ Banker ϲҪıģʽ롢黹ȴУãģʽά Need
+ *
+ * bk_detect_requestͷ䷵ 1 0ڴ治㷵 -1
+ *     ҪȷԴͼճɻɻɴΣд dead[n]д *dead_count
+ * bk_detect_release黹 vecٰ̺Űڹõĸ
+ * bk_detect_abort pȡ󡢹黹ȫԴĸ
+ * bk_detect_reduceʵԼд dead[n]ظrebuild = 1 ʱٰǰ״̬ؽԴͼ
+ */
+int bk_detect_request(Banker* bk, int p, const int* req, int* dead, int* dead_count);
+int bk_detect_release(Banker* bk, int p, const int* vec);
+int bk_detect_abort(Banker* bk, int p);
+int bk_detect_reduce(Banker* bk, int* dead, int rebuild);
+
+/*
+ * ˣȽ a <= b ۼ dst += srclen Ϊ LANES ж루bk_new_vector
+ * ֻܲԱȽϸ
+ */
+#define BK_LANES 16
+typedef struct {
+    int (*less_equal)(const int* a, const int* b, int len);
+    void (*add)(int* dst, const int* src, int len);
+} BkKernels;
+
+void bk_kernels(int level, BkKernels* k);
+// len 뵽 BK_LANES 
+int bk_padded(int len);
+// ж䲹 len  intȫ 0 NULL ʾڴ治
+int* bk_new_vector(int len);
+void bk_free_vector(int* v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
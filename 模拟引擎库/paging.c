@@ -0,0 +1,248 @@
+/*
+ * ҳûģʵ֣ paging.h
+ *
+ * ҳûһ£֡֡ŴСʹã
+ * FIFO װҳLRU ҳ֡ɨ裨֡ͨС
+ * OPT  pg_run ͷɨһʴÿη֮ͬһҳһγֵλã
+ * ÿ֡ҳġ´ʹʱ̡ѡҳֻɨ֡ÿʴ
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdlib.h>
+#include <string.h>
+#include "paging.h"
+
+struct PagingSim {
+    int policy, frames, max_pages, param;
+    int* frame_of;              // ҳ -> ֡-1 = ڴ
+    long long* last_used;       // ҳһηʵʱ
+    int* page_in;               // ֡ -> ҳ-1 = 
+    long long* loaded_at;       // ֡еҳװʱ䣨FIFO
+    long long* next_use;        // ֡еҳһαʵλãOPT
+    int* next_pos;              // pg_run У i ηʵҳһγֵλãOPT
+    int next_cap;
+    long long time;
+    long long last_fault;       // PFFһȱҳʱ
+    int resident;
+    PgStats st;
+    PgEventFn fn;
+    void* user;
+};
+
+PagingSim* pg_create(int policy, int frames, int max_pages, int param) {
+    if (policy < PG_FIFO || policy > PG_PFF || frames <= 0 || max_pages <= 0 ||
+        ((policy == PG_WS || policy == PG_PFF) && param <= 0)) {
+        return NULL;
+    }
+    PagingSim* pg = (PagingSim*)calloc(1, sizeof(PagingSim));
+    if (pg == NULL) {
+        return NULL;
+    }
+    pg->policy = policy;
+    pg->frames = frames;
+    pg->max_pages = max_pages;
+    pg->param = param;
+    pg->frame_of = (int*)malloc((size_t)max_pages * sizeof(int));
+    pg->last_used = (long long*)malloc((size_t)max_pages * sizeof(long long));
+    pg->page_in = (int*)malloc((size_t)frames * sizeof(int));
+    pg->loaded_at = (long long*)malloc((size_t)frames * sizeof(long long));
+    pg->next_use = (long long*)malloc((size_t)frames * sizeof(long long));
+    if (pg->frame_of == NULL || pg->last_used == NULL || pg->page_in == NULL ||
+        pg->loaded_at == NULL || pg->next_use == NULL) {
+        pg_destroy(pg);
+        return NULL;
+    }
+    pg_reset(pg);
+    return pg;
+}
+
+void pg_destroy(PagingSim* pg) {
+    if (pg == NULL) {
+        return;
+    }
+    free(pg->frame_of);
+    free(pg->last_used);
+    free(pg->page_in);
+    free(pg->loaded_at);
+    free(pg->next_use);
+    free(pg->next_pos);
+    free(pg);
+}
+
+void pg_reset(PagingSim* pg) {
+    for (int p = 0; p < pg->max_pages; ++p) {
+        pg->frame_of[p] = -1;
+        pg->last_used[p] = 0;
+    }
+    for (int f = 0; f < pg->frames; ++f) {
+        pg->page_in[f] = -1;
+        pg->loaded_at[f] = 0;
+        pg->next_use[f] = 0;
+    }
+    pg->time = 0;
+    pg->last_fault = 0;
+    pg->resident = 0;
+    memset(&pg->st, 0, sizeof(pg->st));
+}
+
+void pg_set_callback(PagingSim* pg, PgEventFn fn, void* user) {
+    pg->fn = fn;
+    pg->user = user;
+}
+
+int pg_frame_of(const PagingSim* pg, int page) {
+    return page >= 0 && page < pg->max_pages ? pg->frame_of[page] : -1;
+}
+
+void pg_get_stats(const PagingSim* pg, PgStats* stats) {
+    *stats = pg->st;
+}
+
+static void evict(PagingSim* pg, int f) {
+    pg->frame_of[pg->page_in[f]] = -1;
+    pg->page_in[f] = -1;
+    pg->resident--;
+}
+
+// Ƴʱ <= before פҳWS/PFF פƳҳ
+static int trim(PagingSim* pg, long long before) {
+    int n = 0;
+    for (int f = 0; f < pg->frames; ++f) {
+        int p = pg->page_in[f];
+        if (p != -1 && pg->last_used[p] <= before) {
+            evict(pg, f);
+            n++;
+        }
+    }
+    return n;
+}
+
+// ֡ʱѡ֡
+static int victim_frame(const PagingSim* pg) {
+    int v = 0;
+    for (int f = 1; f < pg->frames; ++f) {
+        switch (pg->policy) {
+        case PG_FIFO:
+            if (pg->loaded_at[f] < pg->loaded_at[v]) v = f;
+            break;
+        case PG_OPT:
+            if (pg->next_use[f] > pg->next_use[v]) v = f;
+            break;
+        default:
+            if (pg->last_used[pg->page_in[f]] < pg->last_used[pg->page_in[v]]) v = f;
+            break;
+        }
+    }
+    return v;
+}
+
+// һηʣnext һҳһαʵλãֻ OPT ã
+static int access_page(PagingSim* pg, int page, long long next) {
+    PgEvent ev;
+    int f = pg->frame_of[page];
+
+    ev.time = ++pg->time;
+    ev.page = page;
+    ev.victim = -1;
+    ev.trimmed = 0;
+    ev.fault = f == -1;
+    pg->st.accesses++;
+    if (f == -1) {
+        pg->st.faults++;
+        if (pg->policy == PG_PFF) {
+            // ϴȱҳļֵ˵ֲȶפ
+            if (pg->time - pg->last_fault > pg->param) {
+                ev.trimmed = trim(pg, pg->last_fault);
+            }
+            pg->last_fault = pg->time;
+        }
+        for (f = 0; f < pg->frames && pg->page_in[f] != -1; ++f) {
+        }
+        if (f == pg->frames) {
+            f = victim_frame(pg);
+            ev.victim = pg->page_in[f];
+            evict(pg, f);
+            pg->st.evictions++;
+        }
+        pg->page_in[f] = page;
+        pg->frame_of[page] = f;
+        pg->loaded_at[f] = pg->time;
+        pg->resident++;
+    }
+    pg->last_used[page] = pg->time;
+    pg->next_use[f] = next;
+    if (pg->policy == PG_WS) {
+        //  (t - , t] ֮ҳƳפշʵҳڴ
+        ev.trimmed += trim(pg, pg->time - pg->param);
+    }
+    pg->st.trims += ev.trimmed;
+    pg->st.resident_sum += pg->resident;
+    if (pg->resident > pg->st.resident_peak) {
+        pg->st.resident_peak = pg->resident;
+    }
+    if (pg->fn != NULL) {
+        ev.frame = f;
+        ev.resident = pg->resident;
+        pg->fn(pg->user, &ev);
+    }
+    return !ev.fault;
+}
+
+int pg_release(PagingSim* pg, int page) {
+    if (page < 0 || page >= pg->max_pages || pg->frame_of[page] == -1) {
+        return 0;
+    }
+    evict(pg, pg->frame_of[page]);
+    return 1;
+}
+
+int pg_access(PagingSim* pg, int page) {
+    if (page < 0 || page >= pg->max_pages || pg->policy == PG_OPT) {
+        return -1;
+    }
+    return access_page(pg, page, 0);
+}
+
+long long pg_run(PagingSim* pg, const int* pages, int count) {
+    long long faults = pg->st.faults;
+    for (int i = 0; i < count; ++i) {
+        if (pages[i] < 0 || pages[i] >= pg->max_pages) return -1;
+    }
+    if (pg->policy == PG_OPT) {
+        if (count > pg->next_cap) {
+            int* p = (int*)realloc(pg->next_pos, (size_t)count * sizeof(int));
+            if (p == NULL) return -1;
+            pg->next_pos = p;
+            pg->next_cap = count;
+        }
+        //  last_used ݴÿҳһγֵλãɨ裩ָΪ 0OPT  last_used
+        for (int i = 0; i < count; ++i) {
+            pg->last_used[pages[i]] = count;
+        }
+        for (int f = 0; f < pg->frames; ++f) {
+            if (pg->page_in[f] != -1) pg->last_used[pg->page_in[f]] = count;
+        }
+        for (int i = count - 1; i >= 0; --i) {
+            pg->next_pos[i] = (int)pg->last_used[pages[i]];
+            pg->last_used[pages[i]] = i;
+        }
+        // ֮ǰڴҳ´ʹþʴһγֵλ
+        for (int f = 0; f < pg->frames; ++f) {
+            if (pg->page_in[f] != -1) {
+                pg->next_use[f] = pg->last_used[pg->page_in[f]];
+                pg->last_used[pg->page_in[f]] = 0;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            pg->last_used[pages[i]] = 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            access_page(pg, pages[i], pg->next_pos[i]);
+        }
+    }
+    else {
+        for (int i = 0; i < count; ++i) {
+            access_page(pg, pages[i], 0);
+        }
+    }
+    return pg->st.faults - faults;
+}
@@ -0,0 +1,77 @@
+/*
+ * ҳûģ
+ * ֡ҳûԺͳƶ PagingSim ȫֱҲκ
+ * ͬ PagingSim ɣڲͬ߳ͬʱУͬһֻһ߳ʹã
+ * ÿηʵĽͨصȡãصʱֻۼͳơ
+ * ҳûûȽȳδʹãûֻʾ
+ */
+#ifndef PAGING_H
+#define PAGING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// û / פ
+#define PG_FIFO 0       // Ƚȳ
+#define PG_LRU  1       // δʹ
+#define PG_OPT  2       // ûҪԤ֪ʴֻ pg_run
+#define PG_WS   3       //  param η֮ҳƳפ֡פޣ˰ LRU û
+#define PG_PFF  4       // ȱҳƵʣȱҳ param ʱƳϴȱҳûʹҳ˰ LRU û
+
+typedef struct PagingSim PagingSim;
+
+// һηʵĽ
+typedef struct {
+    long long time;     // ڼηʣ 1 ʼ
+    int page;
+    int frame;          // ʺҳڵ֡
+    int fault;          // 1 = ȱҳ
+    int victim;         // ûȥҳ-1 ʾл˿֡
+    int trimmed;        // ηפƳҳWS/PFF
+    int resident;       // ʺפС
+} PgEvent;
+
+typedef void (*PgEventFn)(void* user, const PgEvent* ev);
+
+typedef struct {
+    long long accesses;
+    long long faults;
+    long long evictions;        // ֡ʱûĴ
+    long long trims;            // פƳҳ
+    long long resident_sum;     // ÿηʺפС֮ͣ accesses ƽפ
+    int resident_peak;
+} PgStats;
+
+/*
+ * frames֡WS/PFF Ϊפޣҳ [0, max_pages) 
+ * paramWS Ĵڻ PFF ȱҳֵԺ
+ *  NULL ʾǷڴ治
+ */
+PagingSim* pg_create(int policy, int frames, int max_pages, int param);
+void pg_destroy(PagingSim* pg);
+
+// ڴ桢ʱͳƣص
+void pg_reset(PagingSim* pg);
+
+void pg_set_callback(PagingSim* pg, PgEventFn fn, void* user);
+
+// һҳ 1 = У0 = ȱҳ-1 = ҳԽΪ PG_OPT
+int pg_access(PagingSim* pg, int page);
+
+// ηʴPG_OPT ֻãرεȱҳ-1 = ҳԽڴ治
+long long pg_run(PagingSim* pg, const int* pages, int count);
+
+// ҳ page Ƴڴ棨˳ʱͷҳͳƣ 1 = ԭڴ
+int pg_release(PagingSim* pg, int page);
+
+// ҳ page ǰڵ֡-1 ʾڴ棻ַ = ֡  ҳС + ҳƫ
+int pg_frame_of(const PagingSim* pg, int page);
+
+void pg_get_stats(const PagingSim* pg, PgStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1890 @@
+/*
+ * ̵ʵ֣ scheduler.h
+ * ¼ֻƽʱ䡢ʱƬI/O ɺ͸ؾ⣬
+ * ˭һ CPUܶáǷռ SchedOps Ĳԡ
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include "scheduler.h"
+
+//  k ͻĳȣûͻʱʱǵ 0 
+static long long burst_length(const ProcessBase* p, int k) {
+    return p->burst_count > 0 ? p->bursts[k].length : p->service_time;
+}
+
+
+
+// Уѭʵ֣ʱ
+typedef struct {
+    int* data;
+    int capacity;
+    int front;
+    int rear;
+    int count;
+} Queue;
+
+static int init_queue(Queue* q) {
+    q->capacity = 64;
+    q->data = (int*)malloc(q->capacity * sizeof(int));
+    q->front = 0;
+    q->rear = 0;
+    q->count = 0;
+    return q->data == NULL;
+}
+
+static void free_queue(Queue* q) {
+    free(q->data);
+    q->data = NULL;
+}
+
+static int is_empty(Queue* q) {
+    return q->count == 0;
+}
+
+// ֵ0=ɹ1=ʧ
+static int enqueue(Queue* q, int x) {
+    if (q->count == q->capacity) {
+        int new_cap = q->capacity * 2;
+        int* d = (int*)malloc((size_t)new_cap * sizeof(int));
+        if (d == NULL) {
+            return 1;
+        }
+        // ѻϵԪذ˳ᵽ鿪ͷ
+        for (int i = 0; i < q->count; ++i) {
+            d[i] = q->data[(q->front + i) % q->capacity];
+        }
+        free(q->data);
+        q->data = d;
+        q->capacity = new_cap;
+        q->front = 0;
+        q->rear = q->count;
+    }
+    q->data[q->rear] = x;
+    q->rear = (q->rear + 1) % q->capacity;
+    q->count++;
+    return 0;
+}
+
+static int dequeue(Queue* q) {
+    if (is_empty(q)) {
+        return -1;
+    }
+    int x = q->data[q->front];
+    q->front = (q->front + 1) % q->capacity;
+    q->count--;
+    return x;
+}
+
+/*
+ * ɢ¼УСѣ
+ *  (ʱ, ¼, ) ͬһʱȴٴʱƬؾ⣬
+ * ռĽͬʱ̵½֮ԭȵƽʽһ¡
+ */
+typedef enum {
+    EV_ARRIVAL = 0,         // ̵
+    EV_SLICE_END = 1,       // CPU ϵʱƬ
+    EV_REBALANCE = 2,       // Ըؾ
+    EV_IO_DONE = 3,         // 豸һ I/O̱
+    EV_WAKE = 4             // run Ҫ̱
+} EventType;
+
+typedef struct {
+    long long time;
+    int type;
+    int idx;                // ؽ±
+    int cpu;                // ʱƬ¼ڵĺˣI/O ¼豸
+    long long aux;          // ʱƬ¼ɱţռ¼
+    long long seq;          // ţ֤ͬ¼Ƚȳ
+} Event;
+
+typedef struct {
+    Event* data;
+    int size;
+    int capacity;
+    long long next_seq;
+} EventHeap;
+
+static int heap_init(EventHeap* h) {
+    h->capacity = 16;
+    h->size = 0;
+    h->next_seq = 0;
+    h->data = (Event*)malloc(h->capacity * sizeof(Event));
+    return h->data == NULL;
+}
+
+static void heap_free(EventHeap* h) {
+    free(h->data);
+    h->data = NULL;
+}
+
+static int event_less(const Event* a, const Event* b) {
+    if (a->time != b->time) return a->time < b->time;
+    if (a->type != b->type) return a->type < b->type;
+    return a->seq < b->seq;
+}
+
+static int heap_push(EventHeap* h, long long time, int type, int idx, int cpu, long long aux) {
+    if (h->size == h->capacity) {
+        Event* d = (Event*)realloc(h->data, (size_t)h->capacity * 2 * sizeof(Event));
+        if (d == NULL) {
+            return 1;
+        }
+        h->data = d;
+        h->capacity *= 2;
+    }
+    Event e;
+    e.time = time;
+    e.type = type;
+    e.idx = idx;
+    e.cpu = cpu;
+    e.aux = aux;
+    e.seq = h->next_seq++;
+
+    // ϸ
+    int i = h->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!event_less(&e, &h->data[parent])) break;
+        h->data[i] = h->data[parent];
+        i = parent;
+    }
+    h->data[i] = e;
+    return 0;
+}
+
+static Event heap_pop(EventHeap* h) {
+    Event top = h->data[0];
+    Event last = h->data[--h->size];
+
+    // ³
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && event_less(&h->data[child + 1], &h->data[child])) {
+            child++;
+        }
+        if (!event_less(&h->data[child], &last)) break;
+        h->data[i] = h->data[child];
+        i = child;
+    }
+    if (h->size > 0) {
+        h->data[i] = last;
+    }
+    return top;
+}
+
+/*
+ * ֵСѣ (key, ) 򣬼ͬʱȽȳ
+ * SRTFʣʱ䣩̬ȼEEVDFֹʱ䣩
+ */
+typedef struct {
+    long long key;
+    long long seq;
+    int idx;
+} KeyItem;
+
+typedef struct {
+    KeyItem* data;
+    int size;
+    int capacity;
+    long long next_seq;
+} KeyHeap;
+
+static int keyheap_init(KeyHeap* h) {
+    h->capacity = 64;
+    h->size = 0;
+    h->next_seq = 0;
+    h->data = (KeyItem*)malloc(h->capacity * sizeof(KeyItem));
+    return h->data == NULL;
+}
+
+static void keyheap_free(KeyHeap* h) {
+    free(h->data);
+    h->data = NULL;
+}
+
+static int keyitem_less(const KeyItem* a, const KeyItem* b) {
+    if (a->key != b->key) return a->key < b->key;
+    return a->seq < b->seq;
+}
+
+static int keyheap_push(KeyHeap* h, long long key, int idx) {
+    if (h->size == h->capacity) {
+        KeyItem* d = (KeyItem*)realloc(h->data, (size_t)h->capacity * 2 * sizeof(KeyItem));
+        if (d == NULL) {
+            return 1;
+        }
+        h->data = d;
+        h->capacity *= 2;
+    }
+    KeyItem e;
+    e.key = key;
+    e.seq = h->next_seq++;
+    e.idx = idx;
+
+    int i = h->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!keyitem_less(&e, &h->data[parent])) break;
+        h->data[i] = h->data[parent];
+        i = parent;
+    }
+    h->data[i] = e;
+    return 0;
+}
+
+static KeyItem keyheap_pop(KeyHeap* h) {
+    KeyItem top = h->data[0];
+    KeyItem last = h->data[--h->size];
+
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && keyitem_less(&h->data[child + 1], &h->data[child])) {
+            child++;
+        }
+        if (!keyitem_less(&h->data[child], &last)) break;
+        h->data[i] = h->data[child];
+        i = child;
+    }
+    if (h->size > 0) {
+        h->data[i] = last;
+    }
+    return top;
+}
+
+/*
+ * ȲԹڽϵֶΣ Linux  sched_entity
+ * ڽ϶ǲʵʱÿһʵں֮ǨҲðݡ
+ * RR ҪЩֶΣ䡣
+ */
+typedef struct {
+    long long vruntime;     // CFSʱ䣬ͬʱǺļ
+    long long ve;           // EEVDFϸʱ
+    long long vd;           // EEVDFֹʱ
+    long long used;         // MLFQڵǰõ
+    long long epoch;        // MLFQ¼ʱ
+    int level;              // MLFQڼ
+    int on_rq;              // CFS/EEVDFȨѼĳ
+    int migrated;           // CFS/EEVDFǨƣʱݴΪԴ˵ֵ
+    int left;               // CFS
+    int right;
+    int parent;
+    char red;
+    long long seq;          // ţͬʱȺ
+} SchedEntity;
+
+/*
+ * CFS  vruntime ľ
+ * ڵǽ̲λ±꣬Ӻͼֵ SchedEntity ɾٷڴ档
+ * ± nil õڱɫд롶㷨ۡһ¡
+ * λϵͳеĽݣָĵַ
+ */
+typedef struct {
+    SchedEntity* const* se;
+    int root;
+    int nil;
+} RBTree;
+
+static void rb_init(RBTree* t, SchedEntity* const* se, int nil) {
+    t->se = se;
+    t->nil = nil;
+    t->root = nil;
+    (*se)[nil].left = (*se)[nil].right = (*se)[nil].parent = nil;
+    (*se)[nil].red = 0;
+}
+
+// ͬʱ򣬱֤ȫ
+static int rb_less(const RBTree* t, int a, int b) {
+    const SchedEntity* se = *t->se;
+    if (se[a].vruntime != se[b].vruntime) return se[a].vruntime < se[b].vruntime;
+    return se[a].seq < se[b].seq;
+}
+
+static void rb_rotate_left(RBTree* t, int x) {
+    SchedEntity* se = *t->se;
+    int y = se[x].right;
+    se[x].right = se[y].left;
+    if (se[y].left != t->nil) se[se[y].left].parent = x;
+    se[y].parent = se[x].parent;
+    if (se[x].parent == t->nil) t->root = y;
+    else if (x == se[se[x].parent].left) se[se[x].parent].left = y;
+    else se[se[x].parent].right = y;
+    se[y].left = x;
+    se[x].parent = y;
+}
+
+static void rb_rotate_right(RBTree* t, int x) {
+    SchedEntity* se = *t->se;
+    int y = se[x].left;
+    se[x].left = se[y].right;
+    if (se[y].right != t->nil) se[se[y].right].parent = x;
+    se[y].parent = se[x].parent;
+    if (se[x].parent == t->nil) t->root = y;
+    else if (x == se[se[x].parent].right) se[se[x].parent].right = y;
+    else se[se[x].parent].left = y;
+    se[y].right = x;
+    se[x].parent = y;
+}
+
+//  se[z].vruntime Ϊ z
+static void rb_insert(RBTree* t, int z) {
+    SchedEntity* se = *t->se;
+    int y = t->nil;
+    int x = t->root;
+    while (x != t->nil) {
+        y = x;
+        x = rb_less(t, z, x) ? se[x].left : se[x].right;
+    }
+    se[z].parent = y;
+    if (y == t->nil) t->root = z;
+    else if (rb_less(t, z, y)) se[y].left = z;
+    else se[y].right = z;
+    se[z].left = se[z].right = t->nil;
+    se[z].red = 1;
+
+    // 
+    while (se[se[z].parent].red) {
+        int p = se[z].parent;
+        int g = se[p].parent;
+        if (p == se[g].left) {
+            int u = se[g].right;
+            if (se[u].red) {
+                se[p].red = se[u].red = 0;
+                se[g].red = 1;
+                z = g;
+            }
+            else {
+                if (z == se[p].right) {
+                    z = p;
+                    rb_rotate_left(t, z);
+                    p = se[z].parent;
+                }
+                se[p].red = 0;
+                se[g].red = 1;
+                rb_rotate_right(t, g);
+            }
+        }
+        else {
+            int u = se[g].left;
+            if (se[u].red) {
+                se[p].red = se[u].red = 0;
+                se[g].red = 1;
+                z = g;
+            }
+            else {
+                if (z == se[p].left) {
+                    z = p;
+                    rb_rotate_right(t, z);
+                    p = se[z].parent;
+                }
+                se[p].red = 0;
+                se[g].red = 1;
+                rb_rotate_left(t, g);
+            }
+        }
+    }
+    se[t->root].red = 0;
+}
+
+static void rb_transplant(RBTree* t, int u, int v) {
+    SchedEntity* se = *t->se;
+    if (se[u].parent == t->nil) t->root = v;
+    else if (u == se[se[u].parent].left) se[se[u].parent].left = v;
+    else se[se[u].parent].right = v;
+    se[v].parent = se[u].parent;
+}
+
+static int rb_subtree_min(const RBTree* t, int x) {
+    while ((*t->se)[x].left != t->nil) x = (*t->se)[x].left;
+    return x;
+}
+
+// ڵ㣨С -1
+static int rb_min(const RBTree* t) {
+    return t->root == t->nil ? -1 : rb_subtree_min(t, t->root);
+}
+
+static void rb_delete(RBTree* t, int z) {
+    SchedEntity* se = *t->se;
+    int y = z;
+    int y_red = se[y].red;
+    int x;
+    if (se[z].left == t->nil) {
+        x = se[z].right;
+        rb_transplant(t, z, se[z].right);
+    }
+    else if (se[z].right == t->nil) {
+        x = se[z].left;
+        rb_transplant(t, z, se[z].left);
+    }
+    else {
+        y = rb_subtree_min(t, se[z].right);
+        y_red = se[y].red;
+        x = se[y].right;
+        if (se[y].parent == z) {
+            se[x].parent = y;
+        }
+        else {
+            rb_transplant(t, y, se[y].right);
+            se[y].right = se[z].right;
+            se[se[y].right].parent = y;
+        }
+        rb_transplant(t, z, y);
+        se[y].left = se[z].left;
+        se[se[y].left].parent = y;
+        se[y].red = se[z].red;
+    }
+    if (y_red) {
+        return;
+    }
+
+    // ɾ
+    while (x != t->root && !se[x].red) {
+        int p = se[x].parent;
+        if (x == se[p].left) {
+            int w = se[p].right;
+            if (se[w].red) {
+                se[w].red = 0;
+                se[p].red = 1;
+                rb_rotate_left(t, p);
+                w = se[p].right;
+            }
+            if (!se[se[w].left].red && !se[se[w].right].red) {
+                se[w].red = 1;
+                x = p;
+            }
+            else {
+                if (!se[se[w].right].red) {
+                    se[se[w].left].red = 0;
+                    se[w].red = 1;
+                    rb_rotate_right(t, w);
+                    w = se[p].right;
+                }
+                se[w].red = se[p].red;
+                se[p].red = 0;
+                se[se[w].right].red = 0;
+                rb_rotate_left(t, p);
+                x = t->root;
+            }
+        }
+        else {
+            int w = se[p].left;
+            if (se[w].red) {
+                se[w].red = 0;
+                se[p].red = 1;
+                rb_rotate_right(t, p);
+                w = se[p].left;
+            }
+            if (!se[se[w].left].red && !se[se[w].right].red) {
+                se[w].red = 1;
+                x = p;
+            }
+            else {
+                if (!se[se[w].left].red) {
+                    se[se[w].right].red = 0;
+                    se[w].red = 1;
+                    rb_rotate_left(t, w);
+                    w = se[p].left;
+                }
+                se[w].red = se[p].red;
+                se[p].red = 0;
+                se[se[w].left].red = 0;
+                rb_rotate_right(t, p);
+                x = t->root;
+            }
+        }
+    }
+    se[x].red = 0;
+}
+
+/*
+ * ȲԽӿ
+ * ¼ֻƽʱ䡢ʱƬ˭һ CPUܶá
+ * Ƿռǰ̡ȫԻصвԹͬһ¼ĺͳƿھ
+ * ʱȫֶֻһʵÿ˶ÿһʵ
+ */
+#define SLOT_NIL 0          // λ 0 Ẓ̌ڱ
+
+typedef struct {
+    const ProcessBase* base; // λ±ϵͳеḶ̌ɺλ
+    ProcessRun* proc;       // ڵ charge ֮ǰѸ remaining_time
+    SchedEntity* se;        // λһһӦRR ʱΪ NULL
+    long long quantum;      // ʱƬRR/MLFQ ʱƬCFS СȡEEVDF 󳤶
+} SchedEnv;
+
+typedef struct SchedPolicy SchedPolicy;
+
+typedef struct {
+    const char* name;
+    int need_entity;        // ǷҪ SchedEntity 
+    int (*init)(SchedPolicy* self);
+    void (*destroy)(SchedPolicy* self);
+    // ̱ΪµδɡӱĺǨ룩 0=ɹ
+    int (*enqueue)(SchedPolicy* self, int idx, long long now);
+    // ȡһҪеḶ̌ûо̷ -1
+    int (*pick_next)(SchedPolicy* self, long long now);
+    // ηжãʣʱȡСֵ
+    long long (*time_slice)(SchedPolicy* self, int idx, long long now);
+    // һнʱƬꡢɻռran Ϊʵʱ
+    void (*charge)(SchedPolicy* self, int idx, long long ran, long long now);
+    // ½̾Ƿռе running ranNULL ʾռ
+    int (*should_preempt)(SchedPolicy* self, int running, long long ran, long long now);
+    // ȡһǨĺˣȡ/ؾ⣩ûз -1
+    int (*steal)(SchedPolicy* self, long long now);
+} SchedOps;
+
+struct SchedPolicy {
+    const SchedOps* ops;
+    const SchedEnv* env;
+    void* state;
+};
+
+// nice ֵ -20~19 ӦȨأ Linux sched_prio_to_weight ͬnice 0 = 1024
+static const int NICE_TO_WEIGHT[40] = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906,
+    3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423,
+    335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45,
+    36, 29, 23, 18, 15
+};
+
+#define NICE_0_WEIGHT 1024
+#define VTIME_SHIFT   20      // ʱ䶨СλȨؽ̵ 0
+
+static int weight_of(const SchedEnv* env, int idx) {
+    int nice = env->base[idx].priority;
+    if (nice < -20) nice = -20;
+    if (nice > 19) nice = 19;
+    return NICE_TO_WEIGHT[nice + 20];
+}
+
+// ʵ ran Ȩ weight µʱ
+static long long vtime_delta(long long ran, long long weight) {
+    return (ran << VTIME_SHIFT) / weight;
+}
+
+/* ---------- RRȷѭ + ̶ʱƬ ---------- */
+
+static int rr_init(SchedPolicy* self) {
+    Queue* q = (Queue*)malloc(sizeof(Queue));
+    if (q == NULL || init_queue(q)) {
+        free(q);
+        return 1;
+    }
+    self->state = q;
+    return 0;
+}
+
+static void rr_destroy(SchedPolicy* self) {
+    if (self->state == NULL) {
+        return;
+    }
+    free_queue((Queue*)self->state);
+    free(self->state);
+}
+
+static int rr_enqueue(SchedPolicy* self, int idx, long long now) {
+    (void)now;
+    return enqueue((Queue*)self->state, idx);
+}
+
+static int rr_pick_next(SchedPolicy* self, long long now) {
+    Queue* q = (Queue*)self->state;
+    (void)now;
+    return is_empty(q) ? -1 : dequeue(q);
+}
+
+static long long rr_time_slice(SchedPolicy* self, int idx, long long now) {
+    (void)idx;
+    (void)now;
+    return self->env->quantum;
+}
+
+static void rr_charge(SchedPolicy* self, int idx, long long ran, long long now) {
+    (void)self;
+    (void)idx;
+    (void)ran;
+    (void)now;
+}
+
+static const SchedOps RR_OPS = {
+    "RR", 0, rr_init, rr_destroy, rr_enqueue, rr_pick_next, rr_time_slice, rr_charge,
+    NULL, rr_pick_next
+};
+
+/*
+ * ---------- MLFQ༶ ----------
+ *  k ʱƬΪ quantum * 2^kĳһͽһ
+ * ÿ MLFQ_BOOST_PERIOD ʱƬн߼ֹ
+ * ڰʱ仮֣һ£ǶԵģֻ˾У
+ * ´ʹʱԼ epoch ٹ㡣
+ */
+#define MLFQ_LEVELS        3
+#define MLFQ_BOOST_PERIOD  20
+
+typedef struct {
+    Queue q[MLFQ_LEVELS];
+    long long cur_epoch;    // ʵѴ
+    long long boost_period;
+} MlfqState;
+
+static int mlfq_init(SchedPolicy* self) {
+    MlfqState* s = (MlfqState*)calloc(1, sizeof(MlfqState));
+    if (s == NULL) {
+        return 1;
+    }
+    self->state = s;
+    s->boost_period = self->env->quantum * MLFQ_BOOST_PERIOD;
+    for (int l = 0; l < MLFQ_LEVELS; ++l) {
+        if (init_queue(&s->q[l])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void mlfq_destroy(SchedPolicy* self) {
+    MlfqState* s = (MlfqState*)self->state;
+    if (s == NULL) {
+        return;
+    }
+    for (int l = 0; l < MLFQ_LEVELS; ++l) {
+        free_queue(&s->q[l]);
+    }
+    free(s);
+}
+
+// ϴ֮û¹Ḷ̌Ϊ
+static void mlfq_sync(SchedPolicy* self, int idx, long long now) {
+    MlfqState* s = (MlfqState*)self->state;
+    SchedEntity* e = &self->env->se[idx];
+    long long epoch = now / s->boost_period;
+    if (e->epoch != epoch) {
+        e->epoch = epoch;
+        e->level = 0;
+        e->used = 0;
+    }
+}
+
+static int mlfq_maybe_boost(MlfqState* s, long long now) {
+    long long epoch = now / s->boost_period;
+    if (epoch == s->cur_epoch) {
+        return 0;
+    }
+    s->cur_epoch = epoch;
+    for (int l = 1; l < MLFQ_LEVELS; ++l) {
+        while (!is_empty(&s->q[l])) {
+            if (enqueue(&s->q[0], dequeue(&s->q[l]))) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int mlfq_enqueue(SchedPolicy* self, int idx, long long now) {
+    MlfqState* s = (MlfqState*)self->state;
+    if (mlfq_maybe_boost(s, now)) {
+        return 1;
+    }
+    mlfq_sync(self, idx, now);
+    return enqueue(&s->q[self->env->se[idx].level], idx);
+}
+
+static int mlfq_pick_next(SchedPolicy* self, long long now) {
+    MlfqState* s = (MlfqState*)self->state;
+    mlfq_maybe_boost(s, now);
+    for (int l = 0; l < MLFQ_LEVELS; ++l) {
+        if (!is_empty(&s->q[l])) {
+            return dequeue(&s->q[l]);
+        }
+    }
+    return -1;
+}
+
+static long long mlfq_time_slice(SchedPolicy* self, int idx, long long now) {
+    SchedEntity* e = &self->env->se[idx];
+    mlfq_sync(self, idx, now);
+    return (self->env->quantum << e->level) - e->used;
+}
+
+static void mlfq_charge(SchedPolicy* self, int idx, long long ran, long long now) {
+    SchedEntity* e = &self->env->se[idx];
+    mlfq_sync(self, idx, now);
+    e->used += ran;
+    if (e->used >= (self->env->quantum << e->level)) {
+        if (e->level < MLFQ_LEVELS - 1) {
+            e->level++;
+        }
+        e->used = 0;
+    }
+}
+
+// һн̾ռ
+static int mlfq_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    MlfqState* s = (MlfqState*)self->state;
+    SchedEntity* e = &self->env->se[running];
+    (void)ran;
+    mlfq_maybe_boost(s, now);
+    int lvl = e->epoch == now / s->boost_period ? e->level : 0;
+    for (int l = 0; l < lvl; ++l) {
+        if (!is_empty(&s->q[l])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static const SchedOps MLFQ_OPS = {
+    "MLFQ", 1, mlfq_init, mlfq_destroy, mlfq_enqueue, mlfq_pick_next,
+    mlfq_time_slice, mlfq_charge, mlfq_should_preempt, mlfq_pick_next
+};
+
+/*
+ * ---------- CFSȫƽ ----------
+ * ̷ڰ vruntime ĺÿѡڵ㣻
+ *  = max(CFS_LATENCY_FACTOR * quantum, nr_running * quantum)Ȩطָ̡
+ * ½̵ vruntime  min_vruntime 𲽣½̱ȵǰ󳬹һСʱռ
+ * Ǩʱ vruntime ȼȥԴ min_vruntimeʱټĿ˵ģλá
+ */
+#define CFS_LATENCY_FACTOR 8
+
+typedef struct {
+    RBTree tree;
+    long long min_vruntime;
+    long long total_weight; // ʵлԾ̣ + УȨغ
+    int nr_running;
+} CfsState;
+
+static int cfs_init(SchedPolicy* self) {
+    CfsState* s = (CfsState*)calloc(1, sizeof(CfsState));
+    if (s == NULL) {
+        return 1;
+    }
+    self->state = s;
+    rb_init(&s->tree, &self->env->se, SLOT_NIL);
+    return 0;
+}
+
+static void cfs_destroy(SchedPolicy* self) {
+    free(self->state);
+}
+
+static int cfs_enqueue(SchedPolicy* self, int idx, long long now) {
+    CfsState* s = (CfsState*)self->state;
+    SchedEntity* e = &self->env->se[idx];
+    (void)now;
+    if (!e->on_rq) {
+        e->on_rq = 1;
+        s->total_weight += weight_of(self->env, idx);
+        s->nr_running++;
+        if (e->migrated) {
+            e->vruntime += s->min_vruntime;
+            e->migrated = 0;
+        }
+        else if (e->vruntime < s->min_vruntime) {
+            e->vruntime = s->min_vruntime;
+        }
+    }
+    rb_insert(&s->tree, idx);
+    return 0;
+}
+
+static int cfs_pick_next(SchedPolicy* self, long long now) {
+    CfsState* s = (CfsState*)self->state;
+    (void)now;
+    int idx = rb_min(&s->tree);
+    if (idx != -1) {
+        rb_delete(&s->tree, idx);
+    }
+    return idx;
+}
+
+static long long cfs_time_slice(SchedPolicy* self, int idx, long long now) {
+    CfsState* s = (CfsState*)self->state;
+    long long min_gran = self->env->quantum;
+    long long period = min_gran * CFS_LATENCY_FACTOR;
+    (void)now;
+    if (s->nr_running > CFS_LATENCY_FACTOR) {
+        period = min_gran * s->nr_running;
+    }
+    long long slice = period * weight_of(self->env, idx) / s->total_weight;
+    return slice > 0 ? slice : 1;
+}
+
+static void cfs_charge(SchedPolicy* self, int idx, long long ran, long long now) {
+    CfsState* s = (CfsState*)self->state;
+    SchedEntity* e = &self->env->se[idx];
+    int w = weight_of(self->env, idx);
+    (void)now;
+    e->vruntime += vtime_delta(ran, w);
+
+    // min_vruntime ȡǰڵнС
+    long long candidate = e->vruntime;
+    int left = rb_min(&s->tree);
+    if (left != -1 && self->env->se[left].vruntime < candidate) {
+        candidate = self->env->se[left].vruntime;
+    }
+    if (candidate > s->min_vruntime) {
+        s->min_vruntime = candidate;
+    }
+
+    if (self->env->proc[idx].remaining_time == 0) {
+        e->on_rq = 0;
+        s->total_weight -= w;
+        s->nr_running--;
+    }
+}
+
+static int cfs_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    CfsState* s = (CfsState*)self->state;
+    (void)now;
+    int left = rb_min(&s->tree);
+    if (left == -1) {
+        return 0;
+    }
+    long long curr = self->env->se[running].vruntime +
+        vtime_delta(ran, weight_of(self->env, running));
+    long long gran = vtime_delta(self->env->quantum, NICE_0_WEIGHT);
+    return self->env->se[left].vruntime + gran < curr;
+}
+
+static int cfs_steal(SchedPolicy* self, long long now) {
+    CfsState* s = (CfsState*)self->state;
+    int idx = cfs_pick_next(self, now);
+    if (idx != -1) {
+        SchedEntity* e = &self->env->se[idx];
+        e->vruntime -= s->min_vruntime;
+        e->migrated = 1;
+        e->on_rq = 0;
+        s->total_weight -= weight_of(self->env, idx);
+        s->nr_running--;
+    }
+    return idx;
+}
+
+static const SchedOps CFS_OPS = {
+    "CFS", 1, cfs_init, cfs_destroy, cfs_enqueue, cfs_pick_next,
+    cfs_time_slice, cfs_charge, cfs_should_preempt, cfs_steal
+};
+
+/*
+ * ---------- EEVDFϸֹʱ ----------
+ * ϵͳʱ V  1/Ȩ ̵ĺϸʱ ve <= V ʱſɱѡ
+ * ںϸѡֹʱ vd = ve + 󳤶/Ȩ ġ
+ * δϸ̰ ve  pending ѣϸ̰ vd  eligible ѡ
+ * 򻯣뿪ʱͺ VǨʱ ve/vd  V ƽơ
+ */
+typedef struct {
+    KeyHeap pending;        // key = ve
+    KeyHeap eligible;       // key = vd
+    long long vtime;        // ϵͳʱ V
+    long long total_weight;
+} EevdfState;
+
+static int eevdf_init(SchedPolicy* self) {
+    EevdfState* s = (EevdfState*)calloc(1, sizeof(EevdfState));
+    if (s == NULL) {
+        return 1;
+    }
+    self->state = s;
+    return keyheap_init(&s->pending) || keyheap_init(&s->eligible);
+}
+
+static void eevdf_destroy(SchedPolicy* self) {
+    EevdfState* s = (EevdfState*)self->state;
+    if (s == NULL) {
+        return;
+    }
+    keyheap_free(&s->pending);
+    keyheap_free(&s->eligible);
+    free(s);
+}
+
+//  ve <= vtime Ľ̴ pending Ƶ eligible
+static int eevdf_promote(SchedPolicy* self, long long vtime) {
+    EevdfState* s = (EevdfState*)self->state;
+    while (s->pending.size > 0 && s->pending.data[0].key <= vtime) {
+        KeyItem it = keyheap_pop(&s->pending);
+        if (keyheap_push(&s->eligible, self->env->se[it.idx].vd, it.idx)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int eevdf_enqueue(SchedPolicy* self, int idx, long long now) {
+    EevdfState* s = (EevdfState*)self->state;
+    SchedEntity* e = &self->env->se[idx];
+    (void)now;
+    if (!e->on_rq) {
+        int w = weight_of(self->env, idx);
+        e->on_rq = 1;
+        s->total_weight += w;
+        if (e->migrated) {
+            e->ve += s->vtime;
+            e->vd += s->vtime;
+            e->migrated = 0;
+        }
+        else {
+            // ¼ĽͺΪ 0ve = V
+            e->ve = s->vtime;
+            e->vd = s->vtime + vtime_delta(self->env->quantum, w);
+        }
+    }
+    if (e->ve <= s->vtime) {
+        return keyheap_push(&s->eligible, e->vd, idx);
+    }
+    return keyheap_push(&s->pending, e->ve, idx);
+}
+
+static int eevdf_pick_next(SchedPolicy* self, long long now) {
+    EevdfState* s = (EevdfState*)self->state;
+    (void)now;
+    eevdf_promote(self, s->vtime);
+    if (s->eligible.size > 0) {
+        return keyheap_pop(&s->eligible).idx;
+    }
+    if (s->pending.size > 0) {
+        // ûкϸ̣V 뿪󣩣ֱƽ V  ve
+        KeyItem it = keyheap_pop(&s->pending);
+        s->vtime = it.key;
+        return it.idx;
+    }
+    return -1;
+}
+
+static long long eevdf_time_slice(SchedPolicy* self, int idx, long long now) {
+    (void)idx;
+    (void)now;
+    return self->env->quantum;
+}
+
+static void eevdf_charge(SchedPolicy* self, int idx, long long ran, long long now) {
+    EevdfState* s = (EevdfState*)self->state;
+    SchedEntity* e = &self->env->se[idx];
+    int w = weight_of(self->env, idx);
+    (void)now;
+    s->vtime += vtime_delta(ran, s->total_weight);
+    e->ve += vtime_delta(ran, w);
+    if (e->ve >= e->vd) {
+        // ꣬һ
+        e->vd = e->ve + vtime_delta(self->env->quantum, w);
+    }
+    if (self->env->proc[idx].remaining_time == 0) {
+        e->on_rq = 0;
+        s->total_weight -= w;
+    }
+}
+
+// кϸ̵ֹʱڵǰ̾ռ
+static int eevdf_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    EevdfState* s = (EevdfState*)self->state;
+    (void)now;
+    eevdf_promote(self, s->vtime + vtime_delta(ran, s->total_weight));
+    return s->eligible.size > 0 && s->eligible.data[0].key < self->env->se[running].vd;
+}
+
+static int eevdf_steal(SchedPolicy* self, long long now) {
+    EevdfState* s = (EevdfState*)self->state;
+    int idx = eevdf_pick_next(self, now);
+    if (idx != -1) {
+        SchedEntity* e = &self->env->se[idx];
+        e->ve -= s->vtime;
+        e->vd -= s->vtime;
+        e->migrated = 1;
+        e->on_rq = 0;
+        s->total_weight -= weight_of(self->env, idx);
+    }
+    return idx;
+}
+
+static const SchedOps EEVDF_OPS = {
+    "EEVDF", 1, eevdf_init, eevdf_destroy, eevdf_enqueue, eevdf_pick_next,
+    eevdf_time_slice, eevdf_charge, eevdf_should_preempt, eevdf_steal
+};
+
+/* ---------- SRTFʣʱȣʣʱСѣ ---------- */
+
+static int heap_policy_init(SchedPolicy* self) {
+    KeyHeap* h = (KeyHeap*)malloc(sizeof(KeyHeap));
+    if (h == NULL || keyheap_init(h)) {
+        free(h);
+        return 1;
+    }
+    self->state = h;
+    return 0;
+}
+
+static void heap_policy_destroy(SchedPolicy* self) {
+    if (self->state == NULL) {
+        return;
+    }
+    keyheap_free((KeyHeap*)self->state);
+    free(self->state);
+}
+
+static int heap_policy_pick_next(SchedPolicy* self, long long now) {
+    KeyHeap* h = (KeyHeap*)self->state;
+    (void)now;
+    return h->size > 0 ? keyheap_pop(h).idx : -1;
+}
+
+// һֱеɣǱռ
+static long long run_to_completion(SchedPolicy* self, int idx, long long now) {
+    (void)now;
+    return self->env->proc[idx].remaining_time;
+}
+
+static int srtf_enqueue(SchedPolicy* self, int idx, long long now) {
+    (void)now;
+    return keyheap_push((KeyHeap*)self->state, self->env->proc[idx].remaining_time, idx);
+}
+
+static int srtf_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    KeyHeap* h = (KeyHeap*)self->state;
+    (void)now;
+    return h->size > 0 &&
+        h->data[0].key < self->env->proc[running].remaining_time - ran;
+}
+
+static const SchedOps SRTF_OPS = {
+    "SRTF", 0, heap_policy_init, heap_policy_destroy, srtf_enqueue, heap_policy_pick_next,
+    run_to_completion, rr_charge, srtf_should_preempt, heap_policy_pick_next
+};
+
+/* ---------- ̬ȼռȼֵԽСԽȣͬȷ ---------- */
+
+static int prio_enqueue(SchedPolicy* self, int idx, long long now) {
+    (void)now;
+    return keyheap_push((KeyHeap*)self->state, self->env->base[idx].priority, idx);
+}
+
+static int prio_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    KeyHeap* h = (KeyHeap*)self->state;
+    (void)ran;
+    (void)now;
+    return h->size > 0 && h->data[0].key < self->env->base[running].priority;
+}
+
+static const SchedOps PRIO_OPS = {
+    "PRIO", 0, heap_policy_init, heap_policy_destroy, prio_enqueue, heap_policy_pick_next,
+    run_to_completion, rr_charge, prio_should_preempt, heap_policy_pick_next
+};
+
+/* ---------- ʵʱԣEDFֹȣ RMSʣԽԽȣ ---------- */
+
+// ûнֹ/ڵͨʵʱҵ֮󣬱˴ȷ
+static long long deadline_key(const ProcessBase* b) {
+    return b->deadline > 0 ? b->deadline : LLONG_MAX;
+}
+
+static long long period_key(const ProcessBase* b) {
+    return b->period > 0 ? b->period : LLONG_MAX;
+}
+
+static int edf_enqueue(SchedPolicy* self, int idx, long long now) {
+    (void)now;
+    return keyheap_push((KeyHeap*)self->state, deadline_key(&self->env->base[idx]), idx);
+}
+
+static int edf_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    KeyHeap* h = (KeyHeap*)self->state;
+    (void)ran;
+    (void)now;
+    return h->size > 0 && h->data[0].key < deadline_key(&self->env->base[running]);
+}
+
+static const SchedOps EDF_OPS = {
+    "EDF", 0, heap_policy_init, heap_policy_destroy, edf_enqueue, heap_policy_pick_next,
+    run_to_completion, rr_charge, edf_should_preempt, heap_policy_pick_next
+};
+
+static int rms_enqueue(SchedPolicy* self, int idx, long long now) {
+    (void)now;
+    return keyheap_push((KeyHeap*)self->state, period_key(&self->env->base[idx]), idx);
+}
+
+static int rms_should_preempt(SchedPolicy* self, int running, long long ran, long long now) {
+    KeyHeap* h = (KeyHeap*)self->state;
+    (void)ran;
+    (void)now;
+    return h->size > 0 && h->data[0].key < period_key(&self->env->base[running]);
+}
+
+static const SchedOps RMS_OPS = {
+    "RMS", 0, heap_policy_init, heap_policy_destroy, rms_enqueue, heap_policy_pick_next,
+    run_to_completion, rr_charge, rms_should_preempt, heap_policy_pick_next
+};
+
+//  scheduler.h ĲԱ
+static const SchedOps* const POLICY_TABLE[POLICY_COUNT] = {
+    &RR_OPS, &MLFQ_OPS, &CFS_OPS, &EEVDF_OPS, &SRTF_OPS, &PRIO_OPS, &EDF_OPS, &RMS_OPS
+};
+
+const char* policy_name(int policy_id) {
+    return POLICY_TABLE[policy_id]->name;
+}
+
+// ÿ˵״̬
+typedef struct {
+    int running;                // ǰ±꣬-1 ʾ
+    long long dispatched_at;    // ηʱ
+    long long run_start;        // ꡢʼƽ̵ʱ
+    long long dispatch_id;      // ÿηɼһʶռϵʱƬ¼
+    long long last_seq;         // һеḶ̌ţ-1 ʾûй
+    long long busy_time;        // Чʱ
+    long long overhead_time;    // л + Ǩ + 濪
+    long long queued;           // ˾гȣÿ˶ʱ
+    long long dispatches;
+    long long block;            // run Ҫ֮ʱ
+} CpuState;
+
+/*
+ * ʽλͼڴ̶޹
+ * С SKETCH_EXACT ֵֵλǾȷģ
+ * ֵͰͰ SKETCH_ALPHA ֣ DDSketch ͬ
+ * ֵʵλ SKETCH_ALPHA
+ */
+#define SKETCH_EXACT   2048
+#define SKETCH_BUCKETS 4096     // ǵ SKETCH_EXACT * gamma^4096Զ long long Χ
+#define SKETCH_ALPHA   0.005
+
+typedef struct {
+    long long exact[SKETCH_EXACT];
+    long long log_count[SKETCH_BUCKETS];
+    long long count;
+    long long max;
+} Sketch;
+
+static const double SKETCH_GAMMA = (1 + SKETCH_ALPHA) / (1 - SKETCH_ALPHA);
+
+static void sketch_add(Sketch* sk, long long v) {
+    if (v < 0) v = 0;
+    sk->count++;
+    if (v > sk->max) sk->max = v;
+    if (v < SKETCH_EXACT) {
+        sk->exact[v]++;
+        return;
+    }
+    int i = (int)ceil(log((double)v / SKETCH_EXACT) / log(SKETCH_GAMMA));
+    if (i >= SKETCH_BUCKETS) i = SKETCH_BUCKETS - 1;
+    sk->log_count[i]++;
+}
+
+//  k Сk = q*(count-1) 룬ȡ±Ŀھһ£
+static long long sketch_quantile(const Sketch* sk, double q) {
+    if (sk->count == 0) {
+        return 0;
+    }
+    long long k = (long long)(q * (sk->count - 1) + 0.5);
+    long long seen = 0;
+    for (int v = 0; v < SKETCH_EXACT; ++v) {
+        seen += sk->exact[v];
+        if (seen > k) return v;
+    }
+    for (int i = 0; i < SKETCH_BUCKETS; ++i) {
+        seen += sk->log_count[i];
+        if (seen > k) {
+            // Ͱ i  (E*gamma^(i-1), E*gamma^i]ȡʹСĴֵ
+            double upper = SKETCH_EXACT * pow(SKETCH_GAMMA, i);
+            long long est = (long long)(2 * upper / (SKETCH_GAMMA + 1) + 0.5);
+            return est < sk->max ? est : sk->max;
+        }
+    }
+    return sk->max;
+}
+
+static void sketch_summary(const Sketch* sk, Quantiles* out) {
+    out->p50 = sketch_quantile(sk, 0.50);
+    out->p95 = sketch_quantile(sk, 0.95);
+    out->p99 = sketch_quantile(sk, 0.99);
+    out->p999 = sketch_quantile(sk, 0.999);
+    out->max = sk->max;
+}
+
+/*
+ * 豸У I/O ʱ뿪 CPU ŵ豸һηһ
+ * ݵȣLOOKѣsweep[1] ͷǰ⣩󣬼Ϊŵ
+ * sweep[0] ڷ󣬼ΪŵǰĶѿ˾͵ͷ
+ */
+typedef struct {
+    int busy;               // ڷḶ̌-1 ʾ
+    int up;                 // ݷ1=ŵ 0=С
+    long long head;         // ͷλ
+    long long served_at;    // ǰʼʱ
+    Queue fifo;             // ȷĵȴ
+    KeyHeap sweep[2];       // ݵȵĵȴ
+} Device;
+
+#define WATERMARK_IDX (-2)  // ˮλ¼Ľ±
+
+// һģȫ״̬ڲֳɼС
+typedef struct {
+    const SimConfig* cfg;
+    ProcessSource* src;
+    SchedEnv* env;
+    // 鰴λ±ֻ꣬ѵδɵḶ̌ɺλ
+    ProcessBase* base;
+    ProcessRun* proc;
+    int* last_cpu;          // ϴеĺˣ-1 ʾûй
+    long long* last_ran;    // ϴ뿪 CPU ʱ
+    long long* seq;         // ̵ĵ
+    int* free_slots;        // вλջ
+    int nfree;
+    int capacity;
+    ProcessBase pending;    // ѴԴȡûһ
+    long long last_arrival; // һȡĵʱˮλ˳
+    int source_done;        // Դȡ
+    int source_later;       // ԴҪһɺȡ
+    long long arrived;
+    long long completed;
+    long long first_arrival;
+    Sketch* sketch;         // תӦȴʱķλͼ 4 
+    double sum_rate;        // Jain ָãƽ֮͡ƽ
+    double sum_rate_sq;
+    long long cur_window;   // ڣǰڱе
+    long long window_done;
+    SchedPolicy* rq;        // Уȫģʽ 1 ÿģʽ ncpu 
+    CpuState* cpu;
+    EventHeap events;
+    SchedStats* st;
+    int woken;              // ʱǷн̽УҪҪռ飩
+    int error;
+    Device dev[MAX_DEVICES];
+    int devs_busy;          // ڷ豸
+    int cpus_busy;          // һʱ̽ʱн̵ĺ
+    long long last_time;    // һ¼ʱ̣ۼصʱ
+} SimState;
+
+static SchedPolicy* rq_of(SimState* s, int c) {
+    return s->cfg->per_cpu_queues ? &s->rq[c] : &s->rq[0];
+}
+
+static int queued_index(SimState* s, int c) {
+    return s->cfg->per_cpu_queues ? c : 0;
+}
+
+static void rq_enqueue(SimState* s, int c, int idx, long long now) {
+    SchedPolicy* rq = rq_of(s, c);
+    s->error |= rq->ops->enqueue(rq, idx, now);
+    s->cpu[queued_index(s, c)].queued++;
+    s->woken = 1;
+}
+
+// µ̷ŵĺϣ + ǷУ
+static int place_arrival(SimState* s) {
+    int best = 0;
+    long long best_load = -1;
+    if (!s->cfg->per_cpu_queues) {
+        return 0;
+    }
+    for (int c = 0; c < s->cfg->ncpu; ++c) {
+        long long load = s->cpu[c].queued + (s->cpu[c].running != -1);
+        if (best_load < 0 || load < best_load) {
+            best = c;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+// 豸еȴʱȡһʼ񣨺Ѱʱ䣩
+static void device_start(SimState* s, int d, long long now) {
+    Device* dev = &s->dev[d];
+    int idx;
+    if (dev->busy != -1) {
+        return;
+    }
+    if (s->cfg->dev_sched[d] == DEV_ELEVATOR) {
+        if (dev->sweep[dev->up].size == 0) {
+            dev->up = !dev->up;
+        }
+        if (dev->sweep[dev->up].size == 0) {
+            return;
+        }
+        idx = keyheap_pop(&dev->sweep[dev->up]).idx;
+    }
+    else {
+        if (is_empty(&dev->fifo)) {
+            return;
+        }
+        idx = dequeue(&dev->fifo);
+    }
+
+    const Burst* b = &s->base[idx].bursts[s->proc[idx].burst];
+    long long seek = b->track > dev->head ? b->track - dev->head : dev->head - b->track;
+    dev->head = b->track;
+    dev->busy = idx;
+    dev->served_at = now;
+    s->devs_busy++;
+    s->st->io_wait += now - s->last_ran[idx];
+    s->error |= heap_push(&s->events, now + seek * s->cfg->seek_cost + b->length,
+        EV_IO_DONE, idx, d, 0);
+}
+
+//  idx ǰͻӦ I/O 󣬽豸
+static void device_submit(SimState* s, int idx, long long now) {
+    const Burst* b = &s->base[idx].bursts[s->proc[idx].burst];
+    Device* dev = &s->dev[b->device];
+    if (s->cfg->dev_sched[b->device] == DEV_ELEVATOR) {
+        int up = b->track == dev->head ? dev->up : b->track > dev->head;
+        s->error |= keyheap_push(&dev->sweep[up], up ? b->track : -b->track, idx);
+    }
+    else {
+        s->error |= enqueue(&dev->fifo, idx);
+    }
+    device_start(s, b->device, now);
+}
+
+// I/O ɣ豸תȥһ󣬽̴һ CPU ͻص
+static void device_complete(SimState* s, int d, long long now) {
+    Device* dev = &s->dev[d];
+    int idx = dev->busy;
+    ProcessRun* p = &s->proc[idx];
+    s->st->io_busy[d] += now - dev->served_at;
+    s->st->io_requests[d]++;
+    dev->busy = -1;
+    s->devs_busy--;
+    device_start(s, d, now);
+
+    p->blocked_time += now - s->last_ran[idx];
+    p->burst++;
+    p->remaining_time = s->base[idx].bursts[p->burst].length;
+    // ÿ˶ʱصϴеĺˣܻȣȫֶʱ c 
+    rq_enqueue(s, s->last_cpu[idx], idx, now);
+}
+
+//  count Ϊ done Ĵ
+static void close_windows(SchedStats* st, long long done, long long count) {
+    if (count <= 0) {
+        return;
+    }
+    if (st->windows == 0 || done < st->min_window) st->min_window = done;
+    if (done > st->max_window) st->max_window = done;
+    st->windows += count;
+}
+
+// رѽڣֱ now ڵĴڣмûɵĴڼ 0
+static void advance_window(SimState* s, long long now) {
+    SchedStats* st = s->st;
+    long long w = (now - s->first_arrival) / s->cfg->window;
+    if (w == s->cur_window) {
+        return;
+    }
+    close_windows(st, s->window_done, 1);
+    close_windows(st, 0, w - s->cur_window - 1);
+    s->cur_window = w;
+    s->window_done = 0;
+}
+
+static void fetch_next(SimState* s);
+
+// ɣתӦȴʱȼͳ
+static void record_completion(SimState* s, int idx, long long now) {
+    SchedStats* st = s->st;
+    const ProcessBase* b = &s->base[idx];
+    const ProcessRun* p = &s->proc[idx];
+    long long t = now - b->arrival_time;
+    long long response = p->start_time - b->arrival_time;
+    long long waiting = t - b->service_time - p->blocked_time;
+    double rate = (double)b->service_time / t;
+
+    s->completed++;
+    st->sum_turnaround += (double)t;
+    st->sum_weighted_turnaround += (double)t / b->service_time;
+    st->sum_response += (double)response;
+    st->sum_waiting += (double)waiting;
+    sketch_add(&s->sketch[0], t);
+    sketch_add(&s->sketch[1], response);
+    sketch_add(&s->sketch[2], waiting);
+    if (b->deadline > 0) {
+        long long lateness = now - b->deadline;
+        if (st->deadline_jobs == 0 || lateness > st->max_lateness) st->max_lateness = lateness;
+        st->deadline_jobs++;
+        st->deadline_misses += lateness > 0;
+        st->sum_lateness += (double)lateness;
+        sketch_add(&s->sketch[3], lateness > 0 ? lateness : 0);
+    }
+    s->sum_rate += rate;
+    s->sum_rate_sq += rate * rate;
+    if (s->cfg->window > 0) {
+        advance_window(s, now);
+        s->window_done++;
+    }
+    st->makespan = now;
+
+    if (s->src->complete != NULL) {
+        s->src->complete(s->src, s->seq[idx], b, p);
+    }
+    s->free_slots[s->nfree++] = idx;
+    if (s->source_later) {
+        s->source_later = 0;
+        fetch_next(s);
+    }
+}
+
+//  c ϵһнʱ䣬¼ָ꣬Ż c ľ
+static void stop_running(SimState* s, int c, long long now, int requeue) {
+    CpuState* cpu = &s->cpu[c];
+    int idx = cpu->running;
+    ProcessRun* p = &s->proc[idx];
+    SchedPolicy* rq = rq_of(s, c);
+    long long ran = now > cpu->run_start ? now - cpu->run_start : 0;
+    long long overhead = (now < cpu->run_start ? now : cpu->run_start) - cpu->dispatched_at;
+    long long block = cpu->block;
+
+    cpu->busy_time += ran;
+    cpu->overhead_time += overhead;
+    if (s->cfg->trace != NULL) {
+        if (overhead > 0) {
+            tr_slice(s->cfg->trace, s->cfg->trace_pid, c, cpu->dispatched_at, overhead, "overhead", -1);
+        }
+        if (ran > 0) {
+            tr_slice(s->cfg->trace, s->cfg->trace_pid, c, cpu->run_start, ran, "P", (int)s->seq[idx]);
+        }
+    }
+    cpu->running = -1;
+    cpu->block = 0;
+    p->remaining_time -= ran;
+    s->last_cpu[idx] = c;
+    s->last_ran[idx] = now;
+    rq->ops->charge(rq, idx, ran, now);
+
+    if (p->remaining_time == 0 && p->burst + 1 < s->base[idx].burst_count) {
+        //  CPU ͻһ I/O 豸
+        p->burst++;
+        device_submit(s, idx, now);
+    }
+    else if (p->remaining_time == 0) {
+        // ý
+        p->finish_time = now;
+        record_completion(s, idx, now);
+    }
+    else if (block > 0) {
+        // run Ҫȱҳʱٻص
+        s->error |= heap_push(&s->events, now + block, EV_WAKE, idx, c, 0);
+    }
+    else if (requeue) {
+        // ûɣӣͬһʱµĽ֮
+        if (s->cfg->trace != NULL) {
+            tr_instant(s->cfg->trace, s->cfg->trace_pid, c, now, "preempt P", (int)s->seq[idx], NULL, 0);
+        }
+        rq_enqueue(s, c, idx, now);
+    }
+}
+
+// ÿģʽ£Ӿ͵һ
+static int steal_for(SimState* s, int c, long long now) {
+    int victim = -1;
+    for (int v = 0; v < s->cfg->ncpu; ++v) {
+        if (v != c && s->cpu[v].queued > 0 &&
+            (victim == -1 || s->cpu[v].queued > s->cpu[victim].queued)) {
+            victim = v;
+        }
+    }
+    if (victim == -1) {
+        return -1;
+    }
+    int idx = s->rq[victim].ops->steal(&s->rq[victim], now);
+    if (idx != -1) {
+        s->cpu[victim].queued--;
+        s->st->steals++;
+    }
+    return idx;
+}
+
+//  c ʱȡһ CPUȿԼĶУȡ
+static void dispatch(SimState* s, int c, long long now) {
+    SchedPolicy* rq = rq_of(s, c);
+    CpuState* cpu = &s->cpu[c];
+    int idx = rq->ops->pick_next(rq, now);
+    if (idx != -1) {
+        s->cpu[queued_index(s, c)].queued--;
+    }
+    else if (s->cfg->per_cpu_queues) {
+        idx = steal_for(s, c, now);
+        if (idx == -1) {
+            return;
+        }
+        // ͵Ľȹҵ˶ϣٰ˲ȡ
+        s->error |= rq->ops->enqueue(rq, idx, now);
+        idx = rq->ops->pick_next(rq, now);
+    }
+    else {
+        return;
+    }
+
+    ProcessRun* p = &s->proc[idx];
+    const SimConfig* cfg = s->cfg;
+
+    // һִʱ¼ʼʱ
+    if (p->start_time == -1) {
+        p->start_time = now;
+    }
+
+    // ̸л˸Ǩƿ˻뿪̫򻺴
+    long long overhead = 0;
+    if (cpu->last_seq != s->seq[idx]) {
+        overhead += cfg->switch_cost;
+        s->st->context_switches++;
+        cpu->last_seq = s->seq[idx];
+    }
+    if (s->last_cpu[idx] != -1) {
+        if (s->last_cpu[idx] != c) {
+            overhead += cfg->migration_cost + cfg->cache_penalty;
+            s->st->migrations++;
+            if (cfg->trace != NULL) {
+                tr_instant(cfg->trace, cfg->trace_pid, c, now, "migrate P", (int)s->seq[idx],
+                    "from", s->last_cpu[idx]);
+            }
+        }
+        else if (now - s->last_ran[idx] > cfg->cache_hot_window) {
+            overhead += cfg->cache_penalty;
+        }
+    }
+
+    // ʵִʱ䣻 run ʱܶá֮Ƿ
+    long long slice = rq->ops->time_slice(rq, idx, now);
+    if (slice > p->remaining_time) {
+        slice = p->remaining_time;
+    }
+    cpu->block = 0;
+    if (s->src->run != NULL) {
+        long long ran = s->src->run(s->src, s->seq[idx], now + overhead, slice, &cpu->block);
+        if (ran < 0) ran = 0;
+        if (ran > slice) ran = slice;
+        if (ran < slice && cpu->block <= 0) {
+            cpu->block = 0;
+            s->error |= ran == 0;   // ȲҲԶûнչ
+        }
+        slice = ran;
+    }
+    cpu->running = idx;
+    cpu->dispatched_at = now;
+    cpu->run_start = now + overhead;
+    cpu->dispatch_id++;
+    cpu->dispatches++;
+    s->st->dispatches++;
+    s->error |= heap_push(&s->events, now + overhead + slice, EV_SLICE_END,
+        idx, c, cpu->dispatch_id);
+}
+
+// Ըؾ⣺æĺеĺ˰ᣬֱ 1
+static void rebalance(SimState* s, long long now) {
+    for (;;) {
+        int hi = 0, lo = 0;
+        for (int c = 1; c < s->cfg->ncpu; ++c) {
+            if (s->cpu[c].queued > s->cpu[hi].queued) hi = c;
+            if (s->cpu[c].queued < s->cpu[lo].queued) lo = c;
+        }
+        if (s->cpu[hi].queued - s->cpu[lo].queued <= 1) {
+            return;
+        }
+        int idx = s->rq[hi].ops->steal(&s->rq[hi], now);
+        if (idx == -1) {
+            return;
+        }
+        s->cpu[hi].queued--;
+        rq_enqueue(s, lo, idx, now);
+        s->st->rebalance_moves++;
+    }
+}
+
+// λʱаλ±һ²Կָ
+static int grow_slots(SimState* s) {
+    int cap = s->capacity * 2;
+    void* p;
+    if ((p = realloc(s->base, (size_t)cap * sizeof(ProcessBase))) == NULL) return 1;
+    s->base = (ProcessBase*)p;
+    if ((p = realloc(s->proc, (size_t)cap * sizeof(ProcessRun))) == NULL) return 1;
+    s->proc = (ProcessRun*)p;
+    if ((p = realloc(s->last_cpu, (size_t)cap * sizeof(int))) == NULL) return 1;
+    s->last_cpu = (int*)p;
+    if ((p = realloc(s->last_ran, (size_t)cap * sizeof(long long))) == NULL) return 1;
+    s->last_ran = (long long*)p;
+    if ((p = realloc(s->seq, (size_t)cap * sizeof(long long))) == NULL) return 1;
+    s->seq = (long long*)p;
+    if ((p = realloc(s->free_slots, (size_t)cap * sizeof(int))) == NULL) return 1;
+    s->free_slots = (int*)p;
+    if (s->env->se != NULL) {
+        if ((p = realloc(s->env->se, (size_t)cap * sizeof(SchedEntity))) == NULL) return 1;
+        s->env->se = (SchedEntity*)p;
+    }
+    // ѹջȷС±
+    for (int i = cap - 1; i >= s->capacity; --i) {
+        s->free_slots[s->nfree++] = i;
+    }
+    s->capacity = cap;
+    s->env->base = s->base;
+    s->env->proc = s->proc;
+    return 0;
+}
+
+// Դȡһ̣ĵ¼ֻһ̣
+static void fetch_next(SimState* s) {
+    ProcessBase p;
+    int r = s->src->next(s->src, &p);
+    if (r == 0) {
+        s->source_done = 1;
+        return;
+    }
+    if (r < 0) {
+        s->error = 1;
+        return;
+    }
+    if (r == SOURCE_LATER) {
+        s->source_later = 1;
+        return;
+    }
+    if (p.arrival_time < s->last_arrival) {
+        s->error = 1;           // Դ밴ʱ
+        return;
+    }
+    s->last_arrival = p.arrival_time;
+    if (r == SOURCE_WATERMARK) {
+        // ˮλ̣һʱΪֹ¼ȴٽŶ
+        s->error |= heap_push(&s->events, p.arrival_time, EV_ARRIVAL, WATERMARK_IDX, 0, 0);
+        return;
+    }
+    if (s->arrived == 0) {
+        s->first_arrival = p.arrival_time;
+    }
+    s->pending = p;
+    s->error |= heap_push(&s->events, p.arrival_time, EV_ARRIVAL, -1, 0, 0);
+}
+
+// ̽ϵͳλʼʱݣزλ±꣬ʧܷ -1
+static int admit(SimState* s) {
+    if (s->nfree == 0 && grow_slots(s)) {
+        s->error = 1;
+        return -1;
+    }
+    int idx = s->free_slots[--s->nfree];
+    s->base[idx] = s->pending;
+    s->seq[idx] = s->arrived++;
+    s->proc[idx].remaining_time = burst_length(&s->pending, 0);
+    s->proc[idx].start_time = -1;
+    s->proc[idx].finish_time = -1;
+    s->proc[idx].burst = 0;
+    s->proc[idx].blocked_time = 0;
+    s->last_cpu[idx] = -1;
+    s->last_ran[idx] = 0;
+    if (s->env->se != NULL) {
+        memset(&s->env->se[idx], 0, sizeof(SchedEntity));
+        s->env->se[idx].seq = s->seq[idx];
+    }
+    return idx;
+}
+
+// ģڴֻͬʱϵͳеĽйأܽ޹
+int simulate_source(ProcessSource* src, int policy_id, int time_quantum,
+    const SimConfig* cfg, SchedStats* st, CpuStats* per_cpu) {
+    const SchedOps* ops = POLICY_TABLE[policy_id];
+    int nrq = cfg->per_cpu_queues ? cfg->ncpu : 1;
+    SimState s;
+    SchedEnv env;
+    memset(&s, 0, sizeof(s));
+    memset(&env, 0, sizeof(env));
+    memset(st, 0, sizeof(*st));
+    s.cfg = cfg;
+    s.src = src;
+    s.env = &env;
+    s.st = st;
+    s.last_arrival = LLONG_MIN;
+
+    // λ 0 ڱ 1 ʼ
+    s.capacity = 64;
+    s.base = (ProcessBase*)malloc((size_t)s.capacity * sizeof(ProcessBase));
+    s.proc = (ProcessRun*)malloc((size_t)s.capacity * sizeof(ProcessRun));
+    s.last_cpu = (int*)malloc((size_t)s.capacity * sizeof(int));
+    s.last_ran = (long long*)malloc((size_t)s.capacity * sizeof(long long));
+    s.seq = (long long*)malloc((size_t)s.capacity * sizeof(long long));
+    s.free_slots = (int*)malloc((size_t)s.capacity * sizeof(int));
+    s.sketch = (Sketch*)calloc(4, sizeof(Sketch));
+    s.rq = (SchedPolicy*)calloc((size_t)nrq, sizeof(SchedPolicy));
+    s.cpu = (CpuState*)calloc((size_t)cfg->ncpu, sizeof(CpuState));
+
+    env.base = s.base;
+    env.proc = s.proc;
+    env.se = ops->need_entity
+        ? (SchedEntity*)calloc((size_t)s.capacity, sizeof(SchedEntity))
+        : NULL;
+    env.quantum = time_quantum;
+
+    s.error = s.base == NULL || s.proc == NULL || s.last_cpu == NULL ||
+        s.last_ran == NULL || s.seq == NULL || s.free_slots == NULL ||
+        s.sketch == NULL || s.rq == NULL || s.cpu == NULL ||
+        (ops->need_entity && env.se == NULL);
+    s.error |= heap_init(&s.events);
+    if (!s.error) {
+        for (int i = s.capacity - 1; i > SLOT_NIL; --i) {
+            s.free_slots[s.nfree++] = i;
+        }
+        for (int c = 0; c < cfg->ncpu; ++c) {
+            s.cpu[c].running = -1;
+            s.cpu[c].last_seq = -1;
+        }
+        for (int r = 0; r < nrq; ++r) {
+            s.rq[r].ops = ops;
+            s.rq[r].env = &env;
+            s.error |= ops->init(&s.rq[r]);
+        }
+        for (int d = 0; d < MAX_DEVICES; ++d) {
+            s.dev[d].busy = -1;
+            s.dev[d].up = 1;
+            s.error |= init_queue(&s.dev[d].fifo);
+            s.error |= keyheap_init(&s.dev[d].sweep[0]);
+            s.error |= keyheap_init(&s.dev[d].sweep[1]);
+        }
+    }
+
+    if (!s.error) {
+        fetch_next(&s);
+        if (!s.source_done && !s.error && cfg->per_cpu_queues && cfg->rebalance_period > 0) {
+            s.error |= heap_push(&s.events, s.first_arrival + cfg->rebalance_period,
+                EV_REBALANCE, -1, 0, 0);
+        }
+    }
+
+    while (s.events.size > 0 && !s.error) {
+        long long current_time = s.events.data[0].time;
+
+        // һʱ̵ڣCPU 豸ͬʱæʱ
+        if (s.cpus_busy > 0 && s.devs_busy > 0) {
+            st->overlap_time += current_time - s.last_time;
+        }
+        s.last_time = current_time;
+
+        // ͬһʱ̵ȫ¼پ˭ CPU
+        s.woken = 0;
+        while (s.events.size > 0 && s.events.data[0].time == current_time && !s.error) {
+            Event ev = heap_pop(&s.events);
+
+            if (ev.type == EV_ARRIVAL && ev.idx == WATERMARK_IDX) {
+                fetch_next(&s);
+            }
+            else if (ev.type == EV_ARRIVAL) {
+                int idx = admit(&s);
+                if (idx != -1) {
+                    rq_enqueue(&s, place_arrival(&s), idx, current_time);
+                    fetch_next(&s);
+                }
+            }
+            else if (ev.type == EV_SLICE_END) {
+                if (ev.aux == s.cpu[ev.cpu].dispatch_id) {
+                    stop_running(&s, ev.cpu, current_time, 1);
+                }
+                // ýѱռ¼
+            }
+            else if (ev.type == EV_IO_DONE) {
+                device_complete(&s, ev.cpu, current_time);
+            }
+            else if (ev.type == EV_WAKE) {
+                s.proc[ev.idx].blocked_time += current_time - s.last_ran[ev.idx];
+                rq_enqueue(&s, ev.cpu, ev.idx, current_time);
+            }
+            else {
+                rebalance(&s, current_time);
+                if (!s.source_done || s.completed < s.arrived) {
+                    s.error |= heap_push(&s.events, current_time + cfg->rebalance_period,
+                        EV_REBALANCE, -1, 0, 0);
+                }
+            }
+        }
+
+        // кȡ CPU
+        for (int c = 0; c < cfg->ncpu; ++c) {
+            if (s.cpu[c].running == -1) {
+                dispatch(&s, c, current_time);
+            }
+        }
+
+        // ½̾ɲԾǷռϵĵǰ
+        if (s.woken && ops->should_preempt != NULL) {
+            for (int c = 0; c < cfg->ncpu; ++c) {
+                CpuState* cpu = &s.cpu[c];
+                SchedPolicy* rq = rq_of(&s, c);
+                if (cpu->running == -1) {
+                    continue;
+                }
+                long long ran = current_time > cpu->run_start ? current_time - cpu->run_start : 0;
+                if (ops->should_preempt(rq, cpu->running, ran, current_time)) {
+                    cpu->block = 0;     // ûܵ˵
+                    stop_running(&s, c, current_time, 1);
+                    st->preemptions++;
+                    dispatch(&s, c, current_time);
+                }
+            }
+        }
+
+        s.cpus_busy = 0;
+        for (int c = 0; c < cfg->ncpu; ++c) {
+            s.cpus_busy += s.cpu[c].running != -1;
+        }
+    }
+
+    if (s.rq != NULL && s.rq[0].ops != NULL) {
+        for (int r = 0; r < nrq; ++r) {
+            ops->destroy(&s.rq[r]);
+        }
+    }
+    for (int d = 0; d < MAX_DEVICES; ++d) {
+        free_queue(&s.dev[d].fifo);
+        keyheap_free(&s.dev[d].sweep[0]);
+        keyheap_free(&s.dev[d].sweep[1]);
+    }
+    heap_free(&s.events);
+    free(env.se);
+    free(s.base);
+    free(s.proc);
+    free(s.last_cpu);
+    free(s.last_ran);
+    free(s.seq);
+    free(s.free_slots);
+
+    int ok = !s.error && s.source_done && s.completed == s.arrived;
+    st->processes = s.completed;
+    if (ok && s.completed > 0) {
+        sketch_summary(&s.sketch[0], &st->turnaround);
+        sketch_summary(&s.sketch[1], &st->response);
+        sketch_summary(&s.sketch[2], &st->waiting);
+        sketch_summary(&s.sketch[3], &st->tardiness);
+        st->fairness = s.sum_rate * s.sum_rate / (s.completed * s.sum_rate_sq);
+        if (cfg->window > 0) {
+            advance_window(&s, st->makespan + cfg->window);     // رһ
+            st->avg_window = (double)s.completed / st->windows;
+        }
+        st->min_util = 1.0;
+        for (int c = 0; c < cfg->ncpu; ++c) {
+            double u = st->makespan > 0 ? (double)s.cpu[c].busy_time / st->makespan : 0.0;
+            st->avg_util += u / cfg->ncpu;
+            if (u < st->min_util) st->min_util = u;
+            if (u > st->max_util) st->max_util = u;
+            st->overhead_time += s.cpu[c].overhead_time;
+            st->busy_time += s.cpu[c].busy_time;
+        }
+        st->idle_time = st->makespan * cfg->ncpu - st->busy_time - st->overhead_time;
+    }
+    if (ok && per_cpu != NULL) {
+        for (int c = 0; c < cfg->ncpu; ++c) {
+            per_cpu[c].busy_time = s.cpu[c].busy_time;
+            per_cpu[c].overhead_time = s.cpu[c].overhead_time;
+            per_cpu[c].dispatches = s.cpu[c].dispatches;
+        }
+    }
+
+    free(s.sketch);
+    free(s.rq);
+    free(s.cpu);
+    return !ok;
+}
@@ -0,0 +1,178 @@
+/*
+ * ̵棺ɢ¼ģ⣬ֶ֧ˣȫֶлÿ˶ + ȡ
+ * RR/MLFQ/CFS/EEVDF/SRTF/̬ȼ/EDF/RMS ֲԡI/O 豸ʵʱҵ
+ * ̴ ProcessSource ʱʽȡ룬ڴֻͬʱϵͳеĽйأ
+ * ȫ״̬һ simulate_source õջͶϣκڶ߳ͬʱģ⡣
+ * ˸ٻʱÿ˵ƬΡռͻдʱߣ trace.h
+ * ̵ģʵ-ʱƬת㷨Ľǰˣϵͳۺģܲ׼Ҳȡ
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_DEVICES 8       // ģ I/O 豸ޣ豸 0 ~ MAX_DEVICES-1
+
+// һͻdevice Ϊ -1 ʾ CPU ͻΪڸ豸ϵһ I/O
+typedef struct {
+    int device;
+    int track;              // I/O ĴŵţݵȰ
+    long long length;       // CPU ʱ豸ʱ
+} Burst;
+
+typedef struct {
+    int pid;                //  ID
+    long long arrival_time; // ʱ
+    long long service_time; // ʱ䣨CPU 
+    int priority;           // ȼֵԽСԽȣCFS/EEVDF Ϊ nice ֵ-20~19
+    int burst_count;        // ͻ0 ʾʱһ CPU ͻ
+    Burst* bursts;          // CPUI/O ͻУβ CPU ͻ
+    long long deadline;     // ʵʱҵľԽֹڣ0 ʾûнֹ
+    long long period;       // ʵʱҵڣRMS ȼ0 ʾʵʱ
+} ProcessBase;
+
+// ʱ
+typedef struct {
+    long long remaining_time; // ǰ CPU ͻʣʱ
+    long long start_time;   // һοʼִеʱ
+    long long finish_time;  // ʱ
+    int burst;              // ǰͻ±
+    long long blocked_time; // 豸ŶӺ I/OԼ run ʱ
+} ProcessRun;
+
+// ȲԱţ˵ 1..POLICY_COUNT ֮һһӦ
+enum {
+    POLICY_RR, POLICY_MLFQ, POLICY_CFS, POLICY_EEVDF,
+    POLICY_SRTF, POLICY_PRIO, POLICY_EDF, POLICY_RMS,
+    POLICY_COUNT
+};
+
+const char* policy_name(int policy_id);
+
+enum { DEV_FCFS = 0, DEV_ELEVATOR = 1 };
+
+/*
+ * ģã
+ * пԡռ CPU ƽ̡ʽ룺
+ * ˻һʱлʱǨƿ
+ * ˻뿪˳ cache_hot_window 󻺴䣬ٸؿ
+ */
+typedef struct {
+    int ncpu;                   // CPU 
+    int per_cpu_queues;         // 0=ȫֹУ1=ÿ˾ + ȡ
+    long long migration_cost;   // еǨƿ
+    long long cache_penalty;    // ¼صĿ
+    long long cache_hot_window; // ͬһ뿪ʱΪ
+    long long rebalance_period; // ÿ˶ʱԸؾ0=
+    long long switch_cost;      // л/ֳָлַռ䣩
+    int dev_sched[MAX_DEVICES]; // 豸ȴеķ˳DEV_FCFS / DEV_ELEVATOR
+    long long seek_cost;        // ͷÿƶһŵʱ䣨0=Ѱ
+    long long window;           // ͳƴڿȣ0=ͳƣ
+    /*
+     * ʱ߸٣NULL=٣ǵ simulate_source ߳ԼĻ
+     *  c ڸٽ trace_pid Ĺ c ϣ̵ƬΣP ӵţ
+     * ƬΣoverheadԼûͱ£preemptͻУmigrate˲ʱ¼
+     */
+    TrRing* trace;
+    int trace_pid;
+} SimConfig;
+
+// һλʽͼƣ
+typedef struct {
+    long long p50;
+    long long p95;
+    long long p99;
+    long long p999;
+    long long max;
+} Quantiles;
+
+// һεȵĻָꣻȫڽʱۼƣ
+typedef struct {
+    long long processes;    // ɵĽ
+    double sum_turnaround;
+    double sum_weighted_turnaround;
+    double sum_response;    // Ӧʱ = ״ - 
+    double sum_waiting;     // ȴʱ = ת - CPU  - I/O 
+    Quantiles turnaround;
+    Quantiles response;
+    Quantiles waiting;
+    double fairness;        // Jain ƽ̵ָƽ /ת 
+    long long idle_time;    // к˼ûнҲûʱ
+    long long windows;      // ͳƴÿ͡ƽ
+    long long min_window;
+    double avg_window;
+    long long max_window;
+    long long dispatches;   // ɴ
+    long long preemptions;  // ½̾ռĴ
+    long long makespan;     // һ̵ʱ
+    long long migrations;   // д
+    long long steals;       // кȡ
+    long long rebalance_moves; // Ըؾ˵Ľ
+    long long context_switches; // ˻һеĴ
+    long long overhead_time;   // к˵л + Ǩ + 濪
+    long long busy_time;       // к˵Чʱ
+    long long io_requests[MAX_DEVICES]; // 豸ɵ I/O 
+    long long io_busy[MAX_DEVICES];     // 豸æµʱ䣨Ѱ + 䣩
+    long long io_wait;      // I/O 豸ȴʱ
+    long long overlap_time; // һæͬʱһ豸æʱ
+    double avg_util;        // ʣЧ / makespanƽС
+    double min_util;
+    double max_util;
+    long long deadline_jobs;    // ֹڵҵдֹڵĸ
+    long long deadline_misses;
+    double sum_lateness;        // ӳ =  - ֹڣǰΪ
+    long long max_lateness;
+    Quantiles tardiness;        // ʱ = max(ӳ, 0) ķλ
+} SchedStats;
+
+// ˵ͳ
+typedef struct {
+    long long busy_time;        // Чʱ
+    long long overhead_time;    // л + Ǩ + 濪
+    long long dispatches;
+} CpuStats;
+
+#define SOURCE_WATERMARK 2
+#define SOURCE_LATER     3
+
+/*
+ * Դģİʱ˳ȡ̣Ҫȫȷڴ
+ * ֹ顢ߵʵΪһԴ
+ */
+typedef struct ProcessSource ProcessSource;
+struct ProcessSource {
+    // ȡһ̣ʱ䲻 1=ȡ0=ûˣ-1=
+    // SOURCE_WATERMARK=ֻʱˮλout->arrival_time ֮ǰн̵
+    // SOURCE_LATER=ʱûУһɣcomplete ص֮ȡ̶ֹĶ̶ȣ
+    // ֻڻнϵͳʱ
+    int (*next)(ProcessSource* self, ProcessBase* out);
+    // ʱصseq Ϊţ 0 ʼΪ NULL
+    void (*complete)(ProcessSource* self, long long seq, const ProcessBase* p, const ProcessRun* r);
+    /*
+     * ÿ CPU ʱصΪ NULLÿζԸʱƬ굱ǰͻ
+     *  seq  now ʼ slice ʱ䵥λʵʱ䣨0 ~ slice
+     * *block д֮Ҫʱ0 = ʼΪ 0ȱҳⲿ¼ӵϡ
+     * ǰͻʱ *block ԣ 0 ʱ
+     * ռʽԿڷصʱ֮ǰ½̣ʱ
+     */
+    long long (*run)(ProcessSource* self, long long seq, long long now, long long slice, long long* block);
+    void* state;
+};
+
+/*
+ * ӽԴʽ̣øԡʱƬͶһ
+ * per_cpu Ϊ NULL ʱдÿ˵ͳƣcfg->ncpu 
+ * ֵ0=ɹ1=ڴ治Դ
+ */
+int simulate_source(ProcessSource* src, int policy_id, int time_quantum,
+    const SimConfig* cfg, SchedStats* st, CpuStats* per_cpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,331 @@
+/*
+ * ʱ߸ٵʵ֣ trace.h
+ *
+ * ÿǵߵߵĻд뷽ֻ headֻ̨߳ tail
+ * ¼дλٷ headreleasę̶߳ headacquire֮ٶλ
+ * ֻڵǼ»ʱĶһ̨߳ÿһֳһΡ
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+/* ---------------- ̵߳ƽ̨װ ---------------- */
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+#define THREAD_RET DWORD WINAPI
+#define THREAD_RET_VALUE 0
+#define mutex_init(m)           InitializeCriticalSection(m)
+#define mutex_destroy(m)        DeleteCriticalSection(m)
+#define mutex_lock(m)           EnterCriticalSection(m)
+#define mutex_unlock(m)         LeaveCriticalSection(m)
+#define load_acquire(p)         (*(p))
+#define store_release(p, v)     (*(p) = (v))
+#define cpu_relax()             SwitchToThread()
+#define sleep_ms(ms)            Sleep(ms)
+#else
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+#define THREAD_RET void*
+#define THREAD_RET_VALUE NULL
+#define mutex_init(m)           pthread_mutex_init((m), NULL)
+#define mutex_destroy(m)        pthread_mutex_destroy(m)
+#define mutex_lock(m)           pthread_mutex_lock(m)
+#define mutex_unlock(m)         pthread_mutex_unlock(m)
+#define load_acquire(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define cpu_relax()             sched_yield()
+static void sleep_ms(int ms) {
+    struct timespec ts = { 0, ms * 1000000L };
+    nanosleep(&ts, NULL);
+}
+#endif
+
+#define NAME_MAX_LEN  64        // ¼Ͳдôֽ
+#define EVENT_MAX_LEN 512       // һ¼ʽĳ
+#define OUT_SIZE      (1 << 16)
+#define RELEASE_BATCH 1024
+
+typedef struct {
+    long long ts;
+    long long dur;          // < 0 ʾ˲ʱ¼
+    long long arg;
+    const char* name;
+    const char* arg_name;
+    int id;
+    int pid, tid;
+} TrEvent;
+
+struct TrRing {
+    TrEvent* buf;
+    long long mask;
+    volatile long long head;    // д뷽һҪдλ
+    volatile long long tail;    // ̨߳һҪλ
+    long long stalls;           // ֻд뷽޸ģtr_close ʱ
+    struct TrRing* next;
+};
+
+typedef struct TrName {
+    int pid, tid;
+    char* name;
+    struct TrName* next;
+} TrName;
+
+struct Tracer {
+    FILE* f;
+    int capacity;
+    TrRing* rings;
+    TrName* names;
+    mutex_t lock;
+    thread_t flusher;
+    volatile int stop;
+    long long events;           // ֻɺ̨߳޸
+    int first;                  // ûд¼ҪҪдţ
+    char out[OUT_SIZE];         // д JSON ı
+    int len;
+};
+
+/*
+ * ¼ںֹ̨߳ʽ out У fwrite
+ * дٶȾд뷽᲻򻺳ȴֶ fprintf Ҫü
+ */
+static char* put_str(char* p, const char* s) {
+    for (int k = 0; k < NAME_MAX_LEN && s[k] != '\0'; ++k) {
+        *p++ = s[k];
+    }
+    return p;
+}
+
+static char* put_int(char* p, long long v) {
+    char digits[24];
+    int k = 0;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    if (v < 0) *p++ = '-';
+    do {
+        digits[k++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    while (k > 0) *p++ = digits[--k];
+    return p;
+}
+
+static void write_event(Tracer* t, const TrEvent* e) {
+    char* p = t->out + t->len;
+    p = put_str(p, t->first ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+    p = put_str(p, e->name);
+    if (e->id >= 0) p = put_int(p, e->id);
+    p = put_str(p, e->dur >= 0 ? "\",\"ph\":\"X\",\"ts\":" : "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":");
+    p = put_int(p, e->ts);
+    if (e->dur >= 0) {
+        p = put_str(p, ",\"dur\":");
+        p = put_int(p, e->dur);
+    }
+    p = put_str(p, ",\"pid\":");
+    p = put_int(p, e->pid);
+    p = put_str(p, ",\"tid\":");
+    p = put_int(p, e->tid);
+    if (e->arg_name != NULL) {
+        p = put_str(p, ",\"args\":{\"");
+        p = put_str(p, e->arg_name);
+        p = put_str(p, "\":");
+        p = put_int(p, e->arg);
+        *p++ = '}';
+    }
+    *p++ = '}';
+    t->len = (int)(p - t->out);
+    if (t->len > OUT_SIZE - EVENT_MAX_LEN) {
+        fwrite(t->out, 1, (size_t)t->len, t->f);
+        t->len = 0;
+    }
+    t->first = 0;
+    t->events++;
+}
+
+// ȡлѷ¼ȡߵĸ
+static long long drain(Tracer* t) {
+    long long n = 0;
+    mutex_lock(&t->lock);
+    for (TrRing* r = t->rings; r != NULL; r = r->next) {
+        long long head = load_acquire(&r->head), tail = r->tail;
+        n += head - tail;
+        while (tail < head) {
+            write_event(t, &r->buf[tail & r->mask]);
+            // ÿдһ͹黹λд뷽صȡ
+            if ((++tail & (RELEASE_BATCH - 1)) == 0) {
+                store_release(&r->tail, tail);
+            }
+        }
+        store_release(&r->tail, tail);
+    }
+    mutex_unlock(&t->lock);
+    return n;
+}
+
+static THREAD_RET flusher_main(void* arg) {
+    Tracer* t = (Tracer*)arg;
+    while (!load_acquire(&t->stop)) {
+        if (drain(t) == 0) {
+            sleep_ms(1);
+        }
+    }
+    drain(t);
+    fwrite(t->out, 1, (size_t)t->len, t->f);
+    t->len = 0;
+    return THREAD_RET_VALUE;
+}
+
+Tracer* tr_open(const char* path, int ring_events) {
+    if (ring_events <= 0) {
+        return NULL;
+    }
+    Tracer* t = (Tracer*)calloc(1, sizeof(Tracer));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->f = fopen(path, "w");
+    if (t->f == NULL) {
+        free(t);
+        return NULL;
+    }
+    t->capacity = 1;
+    while (t->capacity < ring_events) {
+        t->capacity *= 2;
+    }
+    t->first = 1;
+    mutex_init(&t->lock);
+    fprintf(t->f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+#ifdef _WIN32
+    t->flusher = CreateThread(NULL, 0, flusher_main, t, 0, NULL);
+    int failed = t->flusher == NULL;
+#else
+    int failed = pthread_create(&t->flusher, NULL, flusher_main, t) != 0;
+#endif
+    if (failed) {
+        mutex_destroy(&t->lock);
+        fclose(t->f);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+TrRing* tr_ring(Tracer* t) {
+    TrRing* r = (TrRing*)calloc(1, sizeof(TrRing));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->buf = (TrEvent*)malloc((size_t)t->capacity * sizeof(TrEvent));
+    if (r->buf == NULL) {
+        free(r);
+        return NULL;
+    }
+    r->mask = t->capacity - 1;
+    mutex_lock(&t->lock);
+    r->next = t->rings;
+    t->rings = r;
+    mutex_unlock(&t->lock);
+    return r;
+}
+
+void tr_name(Tracer* t, int pid, int tid, const char* name) {
+    TrName* n = (TrName*)malloc(sizeof(TrName));
+    char* copy = (char*)malloc(strlen(name) + 1);
+    if (n == NULL || copy == NULL) {
+        free(n);
+        free(copy);
+        return;
+    }
+    strcpy(copy, name);
+    n->pid = pid;
+    n->tid = tid;
+    n->name = copy;
+    mutex_lock(&t->lock);
+    n->next = t->names;
+    t->names = n;
+    mutex_unlock(&t->lock);
+}
+
+// ռһλʱȺ̨߳ȡ
+static TrEvent* reserve(TrRing* r) {
+    if (r->head - load_acquire(&r->tail) > r->mask) {
+        r->stalls++;
+        do {
+            cpu_relax();
+        } while (r->head - load_acquire(&r->tail) > r->mask);
+    }
+    return &r->buf[r->head & r->mask];
+}
+
+void tr_slice(TrRing* r, int pid, int tid, long long ts, long long dur, const char* name, int id) {
+    TrEvent* e = reserve(r);
+    e->ts = ts;
+    e->dur = dur;
+    e->name = name;
+    e->id = id;
+    e->pid = pid;
+    e->tid = tid;
+    e->arg_name = NULL;
+    store_release(&r->head, r->head + 1);
+}
+
+void tr_instant(TrRing* r, int pid, int tid, long long ts, const char* name, int id,
+    const char* arg_name, long long arg) {
+    TrEvent* e = reserve(r);
+    e->ts = ts;
+    e->dur = -1;
+    e->name = name;
+    e->id = id;
+    e->pid = pid;
+    e->tid = tid;
+    e->arg_name = arg_name;
+    e->arg = arg;
+    store_release(&r->head, r->head + 1);
+}
+
+int tr_close(Tracer* t, TrStats* stats) {
+    store_release(&t->stop, 1);
+#ifdef _WIN32
+    WaitForSingleObject(t->flusher, INFINITE);
+    CloseHandle(t->flusher);
+#else
+    pthread_join(t->flusher, NULL);
+#endif
+    if (stats != NULL) {
+        stats->events = t->events;
+        stats->stalls = 0;
+    }
+    // Ԫ¼д
+    while (t->names != NULL) {
+        TrName* n = t->names;
+        fprintf(t->f, "%s\n{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            t->first ? "" : ",", n->tid < 0 ? "process_name" : "thread_name",
+            n->pid, n->tid < 0 ? 0 : n->tid, n->name);
+        t->first = 0;
+        t->names = n->next;
+        free(n->name);
+        free(n);
+    }
+    while (t->rings != NULL) {
+        TrRing* r = t->rings;
+        if (stats != NULL) stats->stalls += r->stalls;
+        t->rings = r->next;
+        free(r->buf);
+        free(r);
+    }
+    fprintf(t->f, "\n]}\n");
+    int error = ferror(t->f) != 0;
+    error |= fclose(t->f) != 0;
+    mutex_destroy(&t->lock);
+    free(t);
+    return error;
+}
@@ -0,0 +1,63 @@
+/*
+ * ʱ߸٣ģе¼д Chrome trace ʽ JSON
+ * ֱ chrome://tracing  Perfettoui.perfetto.dev򿪡
+ * ÿ¼߳һԼĻλTrRingдֻڱ߳ڽУ
+ * ̨̲߳ϰѸ¼ȡдļģ̲߳õȴ̡
+ * ʱд뷽ó CPU Ⱥ̨߳ȡߣ¼ᶪȴͳơ
+ * ʱ 1 ģʱ䵥λ = 1 ΢
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Tracer Tracer;
+typedef struct TrRing TrRing;
+
+typedef struct {
+    long long events;       // д¼
+    long long stalls;       // дʱȴ̵̨߳Ĵ
+} TrStats;
+
+/*
+ * 򿪸ļ̨д̣߳ring_eventsÿܷŵ¼ȡ 2 ݣ
+ *  NULL ʾļ򲻿Ƿڴ治
+ */
+Tracer* tr_open(const char* path, int ring_events);
+
+/*
+ * дʣ¼֣ļֹ̨̣ͣ߳ 0 = ɹ1 = дļ
+ * ǰ̶߳Ҫֹͣд룻֮ t Ļ
+ */
+int tr_close(Tracer* t, TrStats* stats);
+
+// Ϊ߳̽һֻ֮߳д NULL ʾڴ治
+TrRing* tr_ring(Tracer* t);
+
+/*
+ *  pidtid = -1 ʱ߳ tid  Chrome trace ʾΪ
+ * name ֻ ASCIIţᱻơ
+ * ̰߳ȫ tr_close ʱд
+ */
+void tr_name(Tracer* t, int pid, int tid, const char* name);
+
+/*
+ * ¼¼һ¼name  arg_name һֱЧַֻͨ ASCIIţ
+ *  64 ֽڵĲֲд
+ * id >= 0 ʱʾΪ name  id "P"  7 ʾΪ P7arg_name Ϊ NULL ʾ
+ */
+
+// һγĻ ts ʼ dur
+void tr_slice(TrRing* r, int pid, int tid, long long ts, long long dur, const char* name, int id);
+
+// һ˲ʱ¼
+void tr_instant(TrRing* r, int pid, int tid, long long ts, const char* name, int id,
+    const char* arg_name, long long arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
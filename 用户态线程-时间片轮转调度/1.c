@@ -0,0 +1,645 @@
+/*
+ * û̬ռʽ̣߳green threadʱM Э N ߳ϣM:N
+ * 롰̵ģʵ-ʱƬת㷨е RR һ£
+ * ȫ FIFO УʱƬŵβ
+ *
+ * Э ucontextÿһջʱƬźǿƣ
+ * ʱ߳Լ̣߳ǰһʱƬ͸̷߳ SIGUSR1
+ * źŴֱ swapcontext лظ̵߳ĵѭ
+ * ʱڲѭgt_yieldgt_spawnںͳڣ pthread_sigmask źţ
+ * ڼ񲻻ᱻռҲͲỻḶ́߳ĵǰ̺߳ʼͬһԡ
+ * ڼ䵽źƳٵʱ
+ *
+ *  ucontext  POSIX ź/ֻ̣߳ Linux Unix±룺
+ *     gcc -O2 -pthread 1.c -o green
+ *
+ * ע⣺ָռ֮󻹿ܻĹ̼߳У
+ *  printf/malloc ڲĿ⺯ʱҪ gt_preempt_disable()
+ */
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+int main() {
+    printf(" ucontext  POSIX źţ Linux ±\n");
+    return 1;
+}
+#else
+
+#include <pthread.h>
+#include <signal.h>
+#include <ucontext.h>
+
+#define STACK_SIZE   (64 * 1024)    // ÿջС
+#define MAX_WORKERS  64
+#define MAX_TASKS    100000
+#define PREEMPT_SIG  SIGUSR1
+
+typedef enum {
+    GT_READY,
+    GT_RUNNING,
+    GT_DONE
+} GtState;
+
+typedef struct GThread {
+    int id;
+    ucontext_t ctx;
+    void* stack;
+    void (*fn)(void*);
+    void* arg;
+    volatile GtState state;
+    long long start_ns;         // һ CPU ʱ̣-1 ʾûй
+    long long finish_ns;
+    long long preemptions;      // ʱƬźռĴ
+    long long yields;           // óĴ
+    struct GThread* next;       // 
+} GThread;
+
+typedef struct {
+    pthread_t tid;
+    int id;
+    ucontext_t sched_ctx;               // ̵߳ĵѭ
+    GThread* volatile current;          // е
+    volatile long long slice_start;     // ǰ񱾴 CPU ʱ
+    long long dispatches;
+} Worker;
+
+// ʱȫ״̬
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;        // зǿջȫ
+    GThread* head;              // ȫ FIFO 
+    GThread* tail;
+    int live;                   // û
+    int stopping;
+    Worker workers[MAX_WORKERS];
+    int nworkers;
+    long long quantum_ns;       // 0 ʾռЭ
+    sigset_t preempt_set;       // ֻ PREEMPT_SIG
+    pthread_t ticker;
+    volatile int ticker_stop;
+    long long epoch_ns;         // gt_run ʼʱ̣ͳ
+} rt;
+
+static __thread Worker* tls_worker;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * ռһ߳ϻֲָ߳̾ĵַ
+ * ڼĴͻ̵߳ݣÿζͨĺȡ
+ */
+__attribute__((noinline)) static Worker* current_worker(void) {
+    return tls_worker;
+}
+
+static void ready_push(GThread* t) {
+    t->next = NULL;
+    if (rt.tail == NULL) {
+        rt.head = t;
+    }
+    else {
+        rt.tail->next = t;
+    }
+    rt.tail = t;
+}
+
+static GThread* ready_pop(void) {
+    GThread* t = rt.head;
+    if (t != NULL) {
+        rt.head = t->next;
+        if (rt.head == NULL) {
+            rt.tail = NULL;
+        }
+    }
+    return t;
+}
+
+/*
+ * ʱƬźţлصѭִڼźűΣĹ̺߳񲻻䣻
+ * ڼƳźſ¡һտʼʱ͵Ҫ¿ʱƬǷ
+ */
+static void on_preempt(int sig) {
+    (void)sig;
+    Worker* w = current_worker();
+    if (w == NULL || w->current == NULL || now_ns() - w->slice_start < rt.quantum_ns) {
+        return;
+    }
+    GThread* t = w->current;
+    t->preemptions++;
+    swapcontext(&t->ctx, &w->sched_ctx);
+    // µȣڱĹ߳ϣʱָϴź
+}
+
+// ʱڲʱƬźţԭд oldռʱʲôҲ
+static void preempt_block(sigset_t* old) {
+    if (rt.quantum_ns > 0) {
+        pthread_sigmask(SIG_BLOCK, &rt.preempt_set, old);
+    }
+}
+
+static void preempt_restore(const sigset_t* old) {
+    if (rt.quantum_ns > 0) {
+        pthread_sigmask(SIG_SETMASK, old, NULL);
+    }
+}
+
+// ֹ/ָռôĿ⺯ǰʹãǶ
+void gt_preempt_disable(void) {
+    if (rt.quantum_ns > 0) {
+        pthread_sigmask(SIG_BLOCK, &rt.preempt_set, NULL);
+    }
+}
+
+void gt_preempt_enable(void) {
+    if (rt.quantum_ns > 0) {
+        pthread_sigmask(SIG_UNBLOCK, &rt.preempt_set, NULL);
+    }
+}
+
+// ó CPUŵĩβ
+void gt_yield(void) {
+    sigset_t old;
+    preempt_block(&old);
+    Worker* w = current_worker();
+    GThread* t = w->current;
+    t->yields++;
+    swapcontext(&t->ctx, &w->sched_ctx);
+    // ﱣκָ֣óǰ
+    preempt_restore(&old);
+}
+
+// ڣĽʱʱƬźţ init_contextȡٽ
+static void trampoline(void) {
+    GThread* t = current_worker()->current;
+    gt_preempt_enable();
+    t->fn(t->arg);
+
+    gt_preempt_disable();
+    t->finish_ns = now_ns();
+    t->state = GT_DONE;
+    setcontext(&current_worker()->sched_ctx);
+}
+
+// ջ trampoline ʼִе
+__attribute__((noinline)) static int init_context(GThread* t) {
+    t->stack = malloc(STACK_SIZE);
+    if (t->stack == NULL || getcontext(&t->ctx) != 0) {
+        free(t->stack);
+        return 1;
+    }
+    t->ctx.uc_stack.ss_sp = t->stack;
+    t->ctx.uc_stack.ss_size = STACK_SIZE;
+    t->ctx.uc_link = NULL;
+    // ռʱʱƬźŵ״̬ʼtrampoline ȡٽ
+    sigemptyset(&t->ctx.uc_sigmask);
+    if (rt.quantum_ns > 0) {
+        sigaddset(&t->ctx.uc_sigmask, PREEMPT_SIG);
+    }
+    makecontext(&t->ctx, trampoline, 0);
+    return 0;
+}
+
+/*
+ * 񲢷Уgt_run ֮ǰڲԵ
+ * ָ룬ʧܷ NULLջգGThread ߶ͳ
+ */
+GThread* gt_spawn(void (*fn)(void*), void* arg) {
+    static int next_id = 0;
+    sigset_t old;
+    preempt_block(&old);
+
+    GThread* t = (GThread*)calloc(1, sizeof(GThread));
+    if (t == NULL || init_context(t) != 0) {
+        free(t);
+        preempt_restore(&old);
+        return NULL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->state = GT_READY;
+    t->start_ns = -1;
+
+    pthread_mutex_lock(&rt.lock);
+    t->id = next_id++;
+    rt.live++;
+    ready_push(t);
+    pthread_cond_signal(&rt.cond);
+    pthread_mutex_unlock(&rt.lock);
+
+    preempt_restore(&old);
+    return t;
+}
+
+// ̵߳ĵѭȡУռ/óķŻضβ
+static void* worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    tls_worker = w;
+    // ѭʼʱƬźţɸԵĻָ
+    pthread_sigmask(SIG_BLOCK, &rt.preempt_set, NULL);
+
+    for (;;) {
+        pthread_mutex_lock(&rt.lock);
+        while (rt.head == NULL && !rt.stopping) {
+            pthread_cond_wait(&rt.cond, &rt.lock);
+        }
+        GThread* t = ready_pop();
+        pthread_mutex_unlock(&rt.lock);
+        if (t == NULL) {
+            break;
+        }
+
+        long long now = now_ns();
+        if (t->start_ns == -1) {
+            t->start_ns = now;
+        }
+        t->state = GT_RUNNING;
+        w->dispatches++;
+        w->slice_start = now;
+        w->current = t;
+        swapcontext(&w->sched_ctx, &t->ctx);
+        w->current = NULL;
+
+        pthread_mutex_lock(&rt.lock);
+        if (t->state == GT_DONE) {
+            free(t->stack);
+            t->stack = NULL;
+            if (--rt.live == 0) {
+                rt.stopping = 1;
+                pthread_cond_broadcast(&rt.cond);
+            }
+        }
+        else {
+            t->state = GT_READY;
+            ready_push(t);
+            pthread_cond_signal(&rt.cond);
+        }
+        pthread_mutex_unlock(&rt.lock);
+    }
+    return NULL;
+}
+
+// ʱ̣߳ 1/4 ʱƬΪڼ飬һʱƬͷźռֹռʱƳٵָ
+static void* ticker_main(void* arg) {
+    (void)arg;
+    long long period = rt.quantum_ns / 4 > 0 ? rt.quantum_ns / 4 : 1;
+    struct timespec ts;
+    ts.tv_sec = period / 1000000000LL;
+    ts.tv_nsec = period % 1000000000LL;
+
+    while (!rt.ticker_stop) {
+        nanosleep(&ts, NULL);
+        long long now = now_ns();
+        for (int i = 0; i < rt.nworkers; ++i) {
+            Worker* w = &rt.workers[i];
+            if (w->current != NULL && now - w->slice_start >= rt.quantum_ns) {
+                pthread_kill(w->tid, PREEMPT_SIG);
+            }
+        }
+    }
+    return NULL;
+}
+
+// ʼʱnworkers ̣߳ʱƬ quantum_us ΢루0=ռ
+int gt_init(int nworkers, long long quantum_us) {
+    memset(&rt, 0, sizeof(rt));
+    if (nworkers <= 0 || nworkers > MAX_WORKERS || quantum_us < 0) {
+        return 1;
+    }
+    rt.nworkers = nworkers;
+    rt.quantum_ns = quantum_us * 1000;
+    pthread_mutex_init(&rt.lock, NULL);
+    pthread_cond_init(&rt.cond, NULL);
+    sigemptyset(&rt.preempt_set);
+    sigaddset(&rt.preempt_set, PREEMPT_SIG);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_preempt;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    return sigaction(PREEMPT_SIG, &sa, NULL) != 0;
+}
+
+// ߳ȫֱ 0=ɹ
+int gt_run(void) {
+    int started = 0;
+    int error = 0;
+    rt.epoch_ns = now_ns();
+    pthread_mutex_lock(&rt.lock);
+    rt.stopping = rt.live == 0;
+    pthread_mutex_unlock(&rt.lock);
+
+    for (int i = 0; i < rt.nworkers; ++i) {
+        rt.workers[i].id = i;
+        if (pthread_create(&rt.workers[i].tid, NULL, worker_main, &rt.workers[i]) != 0) {
+            error = 1;
+            break;
+        }
+        started++;
+    }
+    rt.nworkers = started;
+    if (started == 0) {
+        return 1;
+    }
+
+    rt.ticker_stop = 0;
+    int ticking = rt.quantum_ns > 0 &&
+        pthread_create(&rt.ticker, NULL, ticker_main, NULL) == 0;
+
+    for (int i = 0; i < started; ++i) {
+        pthread_join(rt.workers[i].tid, NULL);
+    }
+    if (ticking) {
+        rt.ticker_stop = 1;
+        pthread_join(rt.ticker, NULL);
+    }
+    return error;
+}
+
+void gt_destroy(void) {
+    pthread_mutex_destroy(&rt.lock);
+    pthread_cond_destroy(&rt.cond);
+}
+
+/* ---------------- ʾ׼ ---------------- */
+
+static double iters_per_ms;     // æѭУ׼ÿܵĵ
+
+static void spin(long long iters) {
+    volatile long long x = 0;
+    for (long long i = 0; i < iters; ++i) {
+        x += i;
+    }
+}
+
+static void calibrate(void) {
+    long long iters = 1000000;
+    for (;;) {
+        long long t0 = now_ns();
+        spin(iters);
+        long long dt = now_ns() - t0;
+        if (dt > 50000000LL) {
+            iters_per_ms = (double)iters * 1000000.0 / dt;
+            return;
+        }
+        iters *= 2;
+    }
+}
+
+typedef struct {
+    int pid;
+    long long service_ms;
+} DemoArg;
+
+static void demo_task(void* arg) {
+    DemoArg* a = (DemoArg*)arg;
+    spin((long long)(a->service_ms * iters_per_ms));
+}
+
+// 1. ռʽ RR ʾ t=0 㡢Ӳó
+static void run_demo(void) {
+    int nworkers, n;
+    long long quantum_ms;
+    printf(" ߳ N ʱƬ(ms0=ռ)  M: ");
+    if (scanf("%d %lld %d", &nworkers, &quantum_ms, &n) != 3 ||
+        nworkers <= 0 || nworkers > MAX_WORKERS || quantum_ms < 0 || n <= 0 || n > 1000) {
+        printf("Ƿ\n");
+        return;
+    }
+
+    DemoArg* args = (DemoArg*)malloc((size_t)n * sizeof(DemoArg));
+    GThread** tasks = (GThread**)calloc((size_t)n, sizeof(GThread*));
+    if (args == NULL || tasks == NULL) {
+        printf("ڴ治\n");
+        free(args);
+        free(tasks);
+        return;
+    }
+    printf("ÿ PID ʱ(ms):\n");
+    for (int i = 0; i < n; ++i) {
+        if (scanf("%d %lld", &args[i].pid, &args[i].service_ms) != 2 || args[i].service_ms <= 0) {
+            printf("\n");
+            free(args);
+            free(tasks);
+            return;
+        }
+    }
+
+    if (gt_init(nworkers, quantum_ms * 1000) != 0) {
+        printf("ʱʼʧ\n");
+        free(args);
+        free(tasks);
+        return;
+    }
+    for (int i = 0; i < n; ++i) {
+        tasks[i] = gt_spawn(demo_task, &args[i]);
+        if (tasks[i] == NULL) {
+            printf("ʧ\n");
+            exit(1);
+        }
+    }
+    gt_run();
+
+    double sum = 0;
+    long long dispatches = 0;
+    printf("\nPID\t(ms)\tʼ(ms)\t(ms)\tת(ms)\tռ\n");
+    for (int i = 0; i < n; ++i) {
+        GThread* t = tasks[i];
+        double start = (t->start_ns - rt.epoch_ns) / 1e6;
+        double finish = (t->finish_ns - rt.epoch_ns) / 1e6;
+        sum += finish;
+        printf("%d\t%lld\t\t%.1f\t\t%.1f\t\t%.1f\t\t%lld\n",
+            args[i].pid, args[i].service_ms, start, finish, finish, t->preemptions);
+        free(t);
+    }
+    for (int i = 0; i < rt.nworkers; ++i) {
+        dispatches += rt.workers[i].dispatches;
+    }
+    printf("ƽתʱ = %.1f msɴ = %lld\n", sum / n, dispatches);
+    gt_destroy();
+    free(args);
+    free(tasks);
+}
+
+// 2. лͬһ߳ϻó
+static long long switch_rounds;
+
+static void pingpong_task(void* arg) {
+    (void)arg;
+    for (long long i = 0; i < switch_rounds; ++i) {
+        gt_yield();
+    }
+}
+
+// OS ֮߳û + ӣÿνӶһ߳л
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int turn;
+} os_pp;
+
+static void* os_pingpong(void* arg) {
+    int me = (int)(long)arg;
+    for (long long i = 0; i < switch_rounds; ++i) {
+        pthread_mutex_lock(&os_pp.lock);
+        while (os_pp.turn != me) {
+            pthread_cond_wait(&os_pp.cond, &os_pp.lock);
+        }
+        os_pp.turn = !me;
+        pthread_cond_signal(&os_pp.cond);
+        pthread_mutex_unlock(&os_pp.lock);
+    }
+    return NULL;
+}
+
+static void bench_switch(void) {
+    printf("ÿĽ: ");
+    if (scanf("%lld", &switch_rounds) != 1 || switch_rounds <= 0) {
+        printf("Ƿ\n");
+        return;
+    }
+
+    // û̬1 ̡߳ռÿ gt_yield ѭеһ
+    gt_init(1, 0);
+    GThread* a = gt_spawn(pingpong_task, NULL);
+    GThread* b = gt_spawn(pingpong_task, NULL);
+    long long t0 = now_ns();
+    gt_run();
+    long long green = now_ns() - t0;
+    free(a);
+    free(b);
+    gt_destroy();
+
+    pthread_t ta, tb;
+    pthread_mutex_init(&os_pp.lock, NULL);
+    pthread_cond_init(&os_pp.cond, NULL);
+    os_pp.turn = 0;
+    t0 = now_ns();
+    pthread_create(&ta, NULL, os_pingpong, (void*)0L);
+    pthread_create(&tb, NULL, os_pingpong, (void*)1L);
+    pthread_join(ta, NULL);
+    pthread_join(tb, NULL);
+    long long os = now_ns() - t0;
+    pthread_mutex_destroy(&os_pp.lock);
+    pthread_cond_destroy(&os_pp.cond);
+
+    long long switches = 2 * switch_rounds;
+    printf("\nʽ\t\tܺʱ(ms)\tÿл(ns)\n");
+    // û̬ÿóҪѭ ->  -> һл
+    printf("û̬߳\t%.2f\t\t%.1f\n", green / 1e6, (double)green / switches);
+    printf("OS ߳\t\t%.2f\t\t%.1f\n", os / 1e6, (double)os / switches);
+}
+
+// 3. £û̶̬߳Աȡÿһ OS ̡߳
+static long long task_iters;
+
+static void short_task(void* arg) {
+    (void)arg;
+    spin(task_iters);
+}
+
+static void* os_short_task(void* arg) {
+    (void)arg;
+    spin(task_iters);
+    return NULL;
+}
+
+#define OS_BATCH 256            // OS ߳һͬʱڵ
+
+static void bench_throughput(void) {
+    int m, nworkers;
+    printf("  ÿæѭ ߳: ");
+    if (scanf("%d %lld %d", &m, &task_iters, &nworkers) != 3 ||
+        m <= 0 || m > MAX_TASKS || task_iters < 0 || nworkers <= 0 || nworkers > MAX_WORKERS) {
+        printf("Ƿ\n");
+        return;
+    }
+
+    GThread** tasks = (GThread**)malloc((size_t)m * sizeof(GThread*));
+    if (tasks == NULL) {
+        printf("ڴ治\n");
+        return;
+    }
+    gt_init(nworkers, 0);
+    long long t0 = now_ns();
+    for (int i = 0; i < m; ++i) {
+        tasks[i] = gt_spawn(short_task, NULL);
+        if (tasks[i] == NULL) {
+            printf("ʧ\n");
+            exit(1);
+        }
+    }
+    gt_run();
+    long long green = now_ns() - t0;
+    for (int i = 0; i < m; ++i) {
+        free(tasks[i]);
+    }
+    free(tasks);
+    gt_destroy();
+
+    pthread_t threads[OS_BATCH];
+    t0 = now_ns();
+    for (int done = 0; done < m; ) {
+        int k = m - done < OS_BATCH ? m - done : OS_BATCH;
+        int created = 0;
+        for (; created < k; ++created) {
+            if (pthread_create(&threads[created], NULL, os_short_task, NULL) != 0) {
+                break;
+            }
+        }
+        for (int i = 0; i < created; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        if (created == 0) {
+            printf(" OS ߳ʧ\n");
+            return;
+        }
+        done += created;
+    }
+    long long os = now_ns() - t0;
+
+    printf("\nʽ\t\t\tܺʱ(ms)\t(/)\n");
+    printf("û̬߳(N=%d)\t%.2f\t\t%.0f\n", nworkers, green / 1e6, m / (green / 1e9));
+    printf("ÿһ OS ߳\t%.2f\t\t%.0f\n", os / 1e6, m / (os / 1e9));
+}
+
+int main() {
+    int choice;
+    calibrate();
+    printf("=========== û̬ռʽ̣߳M:NRR ȣ ===========\n");
+    printf("æѭУ׼%.0f ε/ms\n", iters_per_ms);
+
+    for (;;) {
+        printf("\n1. ռʽ RR ʾ\n");
+        printf("2. лû̬߳ vs OS ߳\n");
+        printf("3. £û̬߳ vs OS ߳\n");
+        printf("0. ˳\n");
+        printf("ѡ");
+        if (scanf("%d", &choice) != 1 || choice == 0) {
+            break;
+        }
+        if (choice == 1) {
+            run_demo();
+        }
+        else if (choice == 2) {
+            bench_switch();
+        }
+        else if (choice == 3) {
+            bench_throughput();
+        }
+        else {
+            printf("ѡǷ\n");
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Դresource_manager.cӳٲ
+ * ģһ鹤߳ùԴأӲۡڴԤ㡢ļ̴ơ
+ * ÿ߳һ̡ Maxÿַ뵽 MaxռһСʱȫ黹
+ * Աֲʽд + Դ߿·һȫÿζȫԼ飩
+ * ÿɵrm_acquire ӳٷֲԼ·Ĵ
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "resource_manager.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define MAX_THREADS 64
+#define NRES        4
+#define BUCKETS     40          // ӳֱͼ k Ͱ [2^k, 2^(k+1)) 
+
+static const char* const RES_NAMES[NRES] = { "Ӳ", "ڴԤ(MB)", "ļ", "̴" };
+static const int RES_TOTAL[NRES] = { 32, 1024, 128, 16 };
+
+/* ---------------- ̵߳ƽ̨װ ---------------- */
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+#define THREAD_RET DWORD WINAPI
+#define THREAD_RET_VALUE 0
+#define load_acquire(p)         (*(p))
+#define store_release(p, v)     (*(p) = (v))
+#define cpu_relax()             YieldProcessor()
+#else
+typedef pthread_t thread_t;
+#define THREAD_RET void*
+#define THREAD_RET_VALUE NULL
+#define load_acquire(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define cpu_relax()             sched_yield()
+#endif
+
+static int thread_start(thread_t* t, THREAD_RET (*fn)(void*), void* arg) {
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t == NULL;
+#else
+    return pthread_create(t, NULL, fn, arg) != 0;
+#endif
+}
+
+static void thread_join(thread_t t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+static double now_sec(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// splitmix64ÿ߳һ״̬
+static unsigned int next_random(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+/* ----------------  ---------------- */
+
+typedef struct {
+    ResourceManager* rm;
+    volatile int start;
+} Bench;
+
+typedef struct {
+    Bench* bench;
+    int pid;
+    int max[NRES];
+    long long rounds;
+    double hold_sec;                // ÿõȫԴռõʱ
+    unsigned long long rng;
+    long long latency[BUCKETS];     // rm_acquire ӳֱͼ
+} Worker;
+
+static void record_latency(Worker* w, double sec) {
+    long long ns = (long long)(sec * 1e9);
+    int k = 0;
+    while (k < BUCKETS - 1 && ns >= (2LL << k)) k++;
+    w->latency[k]++;
+}
+
+static void spin(double sec) {
+    double until = now_sec() + sec;
+    while (now_sec() < until) {
+    }
+}
+
+// ÿ֣ Max һ֣ʣµĲ֣ռһȫ黹
+static THREAD_RET bench_worker(void* arg) {
+    Worker* w = (Worker*)arg;
+    Bench* b = w->bench;
+    int first[NRES], rest[NRES];
+    while (!load_acquire(&b->start)) {
+        cpu_relax();
+    }
+    for (long long r = 0; r < w->rounds; ++r) {
+        for (int j = 0; j < NRES; ++j) {
+            first[j] = (int)(next_random(&w->rng) % (unsigned int)(w->max[j] + 1));
+            rest[j] = w->max[j] - first[j];
+        }
+        double t0 = now_sec();
+        rm_acquire(b->rm, w->pid, first);
+        double t1 = now_sec();
+        rm_acquire(b->rm, w->pid, rest);
+        double t2 = now_sec();
+        record_latency(w, t1 - t0);
+        record_latency(w, t2 - t1);
+        spin(w->hold_sec);
+        rm_release_all(b->rm, w->pid);
+    }
+    return THREAD_RET_VALUE;
+}
+
+// ֱͼе q λͰϽ磨룩
+static double percentile(const long long* hist, long long total, double q) {
+    long long target = (long long)(q * total), seen = 0;
+    for (int k = 0; k < BUCKETS; ++k) {
+        seen += hist[k];
+        if (seen > target) return (double)(2LL << k);
+    }
+    return (double)(2LL << (BUCKETS - 1));
+}
+
+/*
+ * nthreads ̸߳ rounds ֣ӡһн 0 = ɹ
+ * Max ɣģʽͬһ Max
+ */
+static int run_bench(int mode, int nthreads, long long rounds, double hold_sec, unsigned long long seed) {
+    static Worker workers[MAX_THREADS];
+    thread_t threads[MAX_THREADS];
+    int max[MAX_THREADS * NRES] = { 0 };
+    Bench b;
+    unsigned long long rng = seed;
+
+    // ÿ̵߳ Max ȡ 1/8 ~ 1/2߳һԳ
+    for (int i = 0; i < nthreads; ++i) {
+        for (int j = 0; j < NRES; ++j) {
+            int lo = RES_TOTAL[j] / 8, hi = RES_TOTAL[j] / 2;
+            max[i * NRES + j] = lo + (int)(next_random(&rng) % (unsigned int)(hi - lo + 1));
+        }
+    }
+    memset(&b, 0, sizeof(b));
+    b.rm = rm_create(nthreads, NRES, RES_TOTAL, max, mode);
+    if (b.rm == NULL) {
+        return 1;
+    }
+
+    int started = 0, error = 0;
+    for (int i = 0; i < nthreads; ++i) {
+        memset(&workers[i], 0, sizeof(Worker));
+        workers[i].bench = &b;
+        workers[i].pid = i;
+        memcpy(workers[i].max, &max[i * NRES], sizeof(workers[i].max));
+        workers[i].rounds = rounds;
+        workers[i].hold_sec = hold_sec;
+        workers[i].rng = seed * 31 + i;
+        if (thread_start(&threads[i], bench_worker, &workers[i]) != 0) {
+            error = 1;
+            break;
+        }
+        started++;
+    }
+    double t0 = now_sec();
+    store_release(&b.start, 1);
+    for (int i = 0; i < started; ++i) {
+        thread_join(threads[i]);
+    }
+    double elapsed = now_sec() - t0;
+
+    long long hist[BUCKETS] = { 0 }, total = 0;
+    for (int i = 0; i < started; ++i) {
+        for (int k = 0; k < BUCKETS; ++k) {
+            hist[k] += workers[i].latency[k];
+            total += workers[i].latency[k];
+        }
+    }
+    RmStats st;
+    rm_get_stats(b.rm, &st);
+    if (!error && !rm_check_idle(b.rm)) {
+        printf("Уʧܣȫ黹Դһ\n");
+        error = 1;
+    }
+    rm_destroy(b.rm);
+    if (error || total == 0) {
+        return 1;
+    }
+
+    printf("%d\t%s\t%10.0f\t%8.1f\t%8.1f\t%9.1f\t%6.1f%%\t%8lld\t%8lld\t%8lld\n",
+        nthreads, mode == RM_GLOBAL_LOCK ? "ȫ" : "ϸ",
+        started * rounds / elapsed,
+        percentile(hist, total, 0.5) / 1e3, percentile(hist, total, 0.99) / 1e3,
+        percentile(hist, total, 0.999) / 1e3,
+        100.0 * st.fast_path / (st.acquires ? st.acquires : 1),
+        st.safety_checks, st.resource_waits, st.unsafe_waits);
+    return 0;
+}
+
+int main() {
+    long long rounds;
+    int max_threads;
+    double hold_us;
+
+    printf("=========== м㷨Դ ===========\n");
+    printf("Դأ");
+    for (int j = 0; j < NRES; ++j) {
+        printf("%s %d%s", RES_NAMES[j], RES_TOTAL[j], j < NRES - 1 ? "" : "\n");
+    }
+    printf(" ÿ̵߳ ߳(<= %d) ÿռʱ(΢): ", MAX_THREADS);
+    if (scanf("%lld %d %lf", &rounds, &max_threads, &hold_us) != 3 ||
+        rounds <= 0 || max_threads <= 0 || max_threads > MAX_THREADS || hold_us < 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+
+    printf("\n߳\tģʽ\t(/s)\tp50(us)\t\tp99(us)\t\tp99.9(us)\t·\tȫ\tԴ\t\tȰȫ\n");
+    // ߳ 124  һ max_threads 
+    for (int t = 1; t <= max_threads; t = t < max_threads && t * 2 > max_threads ? max_threads : t * 2) {
+        for (int mode = RM_FINE_GRAINED; mode <= RM_GLOBAL_LOCK; ++mode) {
+            if (run_bench(mode, t, rounds, hold_us / 1e6, 12345) != 0) {
+                printf("ʧ\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,475 @@
+/*
+ * Դʵ֣ resource_manager.h
+ *
+ * RM_FINE_GRAINED
+ *   ״̬д state_lock ƽʱԹʽУٰԴŴСס漰Դ
+ *   · p ȫʣ Need[p] <= Availableֱӷ䣬ȫԼ顪
+ *    p õȫ貢ɣɺ work = ԭ Available + ԭ Allocation[p]
+ *   ԭİȫÿһ٣״̬Ȼȫ
+ *   漰ͬԴ͹黹ֻп·ʱԶռʽ state_lock
+ *   һİȫԼ顣黹ְܱȫֻ蹲ʽ
+ * RM_GLOBAL_LOCK
+ *   һѻȫ״̬ÿ붼Է䲢İȫԼ飬ա
+ *
+ * ԴʱԴϵӣ
+ * 󲻰ȫʱ safety_cond ϵһι黹release_seq 仯
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdlib.h>
+#include <string.h>
+#include "resource_manager.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define CACHE_LINE 64
+
+/* ---------------- ԭӲƽ̨װ ---------------- */
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef SRWLOCK rwlock_t;
+typedef volatile LONG64 atomic_ll;
+#define mutex_init(m)       InitializeCriticalSection(m)
+#define mutex_destroy(m)    DeleteCriticalSection(m)
+#define mutex_lock(m)       EnterCriticalSection(m)
+#define mutex_unlock(m)     LeaveCriticalSection(m)
+#define cond_init(c)        InitializeConditionVariable(c)
+#define cond_destroy(c)     ((void)0)
+#define cond_wait(c, m)     SleepConditionVariableCS((c), (m), INFINITE)
+#define cond_broadcast(c)   WakeAllConditionVariable(c)
+#define rwlock_init(l)      InitializeSRWLock(l)
+#define rwlock_destroy(l)   ((void)0)
+#define read_lock(l)        AcquireSRWLockShared(l)
+#define read_unlock(l)      ReleaseSRWLockShared(l)
+#define write_lock(l)       AcquireSRWLockExclusive(l)
+#define write_unlock(l)     ReleaseSRWLockExclusive(l)
+#define atomic_load(p)      InterlockedCompareExchange64((p), 0, 0)
+#define atomic_add(p, v)    InterlockedExchangeAdd64((p), (v))
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_rwlock_t rwlock_t;
+typedef volatile long long atomic_ll;
+#define mutex_init(m)       pthread_mutex_init((m), NULL)
+#define mutex_destroy(m)    pthread_mutex_destroy(m)
+#define mutex_lock(m)       pthread_mutex_lock(m)
+#define mutex_unlock(m)     pthread_mutex_unlock(m)
+#define cond_init(c)        pthread_cond_init((c), NULL)
+#define cond_destroy(c)     pthread_cond_destroy(c)
+#define cond_wait(c, m)     pthread_cond_wait((c), (m))
+#define cond_broadcast(c)   pthread_cond_broadcast(c)
+#define rwlock_init(l)      pthread_rwlock_init((l), NULL)
+#define rwlock_destroy(l)   pthread_rwlock_destroy(l)
+#define read_lock(l)        pthread_rwlock_rdlock(l)
+#define read_unlock(l)      pthread_rwlock_unlock(l)
+#define write_lock(l)       pthread_rwlock_wrlock(l)
+#define write_unlock(l)     pthread_rwlock_unlock(l)
+#define atomic_load(p)      __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define atomic_add(p, v)    __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#endif
+
+/* ---------------- ݽṹ ---------------- */
+
+// ÿԴһۣռһУⲻͬԴα
+typedef struct {
+    mutex_t lock;               //  available
+    cond_t freed;               // available ʱ㲥
+    int available;
+} ResourceSlot;
+
+typedef struct {
+    ResourceSlot s;
+    char pad[CACHE_LINE - sizeof(ResourceSlot) % CACHE_LINE];
+} PaddedSlot;
+
+struct ResourceManager {
+    int nproc, nres, mode;
+    int* total;
+    int* max;                   // nproc  nresд
+    int* alloc;
+    int* need;
+    PaddedSlot* res;
+    rwlock_t state_lock;
+
+    mutex_t safety_lock;        //  safety_cond ȴһι黹
+    cond_t safety_cond;
+    atomic_ll release_seq;      // ÿι黹 1
+    atomic_ll safety_waiters;
+
+    mutex_t global;             // RM_GLOBAL_LOCK ±ȫ״̬
+    cond_t global_cond;
+
+    int* work;                  // ȫԼĹֻڶռȫʹ
+    int* finish;
+
+    atomic_ll acquires, fast_path, safety_checks, resource_waits, unsafe_waits;
+};
+
+#define ROW(rm, a, p) ((rm)->a + (size_t)(p) * (rm)->nres)
+#define AVAIL(rm, j)  ((rm)->res[j].s.available)
+
+// Դ鰴ж䣬PaddedSlot ĲÿռԼĻ
+static void* aligned_calloc(size_t size) {
+#ifdef _WIN32
+    void* p = _aligned_malloc(size, CACHE_LINE);
+#else
+    void* p = NULL;
+    if (posix_memalign(&p, CACHE_LINE, size) != 0) p = NULL;
+#endif
+    if (p != NULL) memset(p, 0, size);
+    return p;
+}
+
+static void aligned_free(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+ResourceManager* rm_create(int nproc, int nres, const int* total, const int* max, int mode) {
+    if (nproc <= 0 || nres <= 0 || nres > RM_MAX_RES) {
+        return NULL;
+    }
+    for (int p = 0; p < nproc; ++p) {
+        for (int j = 0; j < nres; ++j) {
+            if (max[(size_t)p * nres + j] < 0 || max[(size_t)p * nres + j] > total[j]) return NULL;
+        }
+    }
+    ResourceManager* rm = (ResourceManager*)calloc(1, sizeof(ResourceManager));
+    if (rm == NULL) {
+        return NULL;
+    }
+    size_t cells = (size_t)nproc * nres;
+    rm->nproc = nproc;
+    rm->nres = nres;
+    rm->mode = mode;
+    rm->total = (int*)malloc((size_t)nres * sizeof(int));
+    rm->max = (int*)malloc(cells * sizeof(int));
+    rm->alloc = (int*)calloc(cells, sizeof(int));
+    rm->need = (int*)malloc(cells * sizeof(int));
+    rm->res = (PaddedSlot*)aligned_calloc((size_t)nres * sizeof(PaddedSlot));
+    rm->work = (int*)malloc((size_t)nres * sizeof(int));
+    rm->finish = (int*)malloc((size_t)nproc * sizeof(int));
+    if (rm->total == NULL || rm->max == NULL || rm->alloc == NULL || rm->need == NULL ||
+        rm->res == NULL || rm->work == NULL || rm->finish == NULL) {
+        free(rm->total);
+        free(rm->max);
+        free(rm->alloc);
+        free(rm->need);
+        aligned_free(rm->res);
+        free(rm->work);
+        free(rm->finish);
+        free(rm);
+        return NULL;
+    }
+    memcpy(rm->total, total, (size_t)nres * sizeof(int));
+    memcpy(rm->max, max, cells * sizeof(int));
+    memcpy(rm->need, max, cells * sizeof(int));
+    for (int j = 0; j < nres; ++j) {
+        mutex_init(&rm->res[j].s.lock);
+        cond_init(&rm->res[j].s.freed);
+        AVAIL(rm, j) = total[j];
+    }
+    rwlock_init(&rm->state_lock);
+    mutex_init(&rm->safety_lock);
+    cond_init(&rm->safety_cond);
+    mutex_init(&rm->global);
+    cond_init(&rm->global_cond);
+    return rm;
+}
+
+void rm_destroy(ResourceManager* rm) {
+    if (rm == NULL) {
+        return;
+    }
+    for (int j = 0; j < rm->nres; ++j) {
+        mutex_destroy(&rm->res[j].s.lock);
+        cond_destroy(&rm->res[j].s.freed);
+    }
+    rwlock_destroy(&rm->state_lock);
+    mutex_destroy(&rm->safety_lock);
+    cond_destroy(&rm->safety_cond);
+    mutex_destroy(&rm->global);
+    cond_destroy(&rm->global_cond);
+    free(rm->total);
+    free(rm->max);
+    free(rm->alloc);
+    free(rm->need);
+    aligned_free(rm->res);
+    free(rm->work);
+    free(rm->finish);
+    free(rm);
+}
+
+/* ---------------- ȫԼ飨߶ռȫ״̬ ---------------- */
+
+static int is_safe(ResourceManager* rm) {
+    int n = rm->nproc, m = rm->nres, count = 0;
+    atomic_add(&rm->safety_checks, 1);
+    for (int j = 0; j < m; ++j) {
+        rm->work[j] = AVAIL(rm, j);
+    }
+    for (int i = 0; i < n; ++i) {
+        rm->finish[i] = 0;
+    }
+    int found = 1;
+    while (found && count < n) {
+        found = 0;
+        for (int i = 0; i < n; ++i) {
+            if (rm->finish[i]) continue;
+            const int* need = ROW(rm, need, i);
+            int j = 0;
+            while (j < m && need[j] <= rm->work[j]) j++;
+            if (j < m) continue;
+            const int* alloc = ROW(rm, alloc, i);
+            for (j = 0; j < m; ++j) {
+                rm->work[j] += alloc[j];
+            }
+            rm->finish[i] = 1;
+            count++;
+            found = 1;
+        }
+    }
+    return count == n;
+}
+
+//  req ǵ p £sign = 1sign = -1ֻд req  0 Դס
+static void apply(ResourceManager* rm, int p, const int* req, int sign) {
+    int* alloc = ROW(rm, alloc, p);
+    int* need = ROW(rm, need, p);
+    for (int j = 0; j < rm->nres; ++j) {
+        if (req[j] != 0) {
+            AVAIL(rm, j) -= sign * req[j];
+            alloc[j] += sign * req[j];
+            need[j] -= sign * req[j];
+        }
+    }
+}
+
+/* ---------------- 뻽 ---------------- */
+
+// Դ j Ŀﵽ amount
+static void wait_resource(ResourceManager* rm, int j, int amount) {
+    atomic_add(&rm->resource_waits, 1);
+    mutex_lock(&rm->res[j].s.lock);
+    while (AVAIL(rm, j) < amount) {
+        cond_wait(&rm->res[j].s.freed, &rm->res[j].s.lock);
+    }
+    mutex_unlock(&rm->res[j].s.lock);
+}
+
+/*
+ *  release_seq 뿪 seenȵǼǵȴٶţ黹ȼٿûеȴߣ
+ * ߶˳һµԭӲԲ˫ûԷĶʧ
+ */
+static void wait_release(ResourceManager* rm, long long seen) {
+    atomic_add(&rm->unsafe_waits, 1);
+    atomic_add(&rm->safety_waiters, 1);
+    mutex_lock(&rm->safety_lock);
+    while (atomic_load(&rm->release_seq) == seen) {
+        cond_wait(&rm->safety_cond, &rm->safety_lock);
+    }
+    mutex_unlock(&rm->safety_lock);
+    atomic_add(&rm->safety_waiters, -1);
+}
+
+static void notify_release(ResourceManager* rm) {
+    atomic_add(&rm->release_seq, 1);
+    if (atomic_load(&rm->safety_waiters) > 0) {
+        mutex_lock(&rm->safety_lock);
+        cond_broadcast(&rm->safety_cond);
+        mutex_unlock(&rm->safety_lock);
+    }
+}
+
+// ŴСס mask еԴ̶˳򣬱֮以ȴ
+static void lock_mask(ResourceManager* rm, unsigned long long mask) {
+    for (int j = 0; j < rm->nres; ++j) {
+        if (mask >> j & 1) mutex_lock(&rm->res[j].s.lock);
+    }
+}
+
+static void unlock_mask(ResourceManager* rm, unsigned long long mask) {
+    for (int j = rm->nres - 1; j >= 0; --j) {
+        if (mask >> j & 1) mutex_unlock(&rm->res[j].s.lock);
+    }
+}
+
+/* ----------------  ---------------- */
+
+static int acquire_global(ResourceManager* rm, int pid, const int* req) {
+    mutex_lock(&rm->global);
+    for (;;) {
+        int j = 0;
+        while (j < rm->nres && req[j] <= AVAIL(rm, j)) j++;
+        if (j == rm->nres) {
+            apply(rm, pid, req, 1);
+            if (is_safe(rm)) {
+                break;
+            }
+            apply(rm, pid, req, -1);
+            atomic_add(&rm->unsafe_waits, 1);
+        }
+        else {
+            atomic_add(&rm->resource_waits, 1);
+        }
+        cond_wait(&rm->global_cond, &rm->global);
+    }
+    mutex_unlock(&rm->global);
+    return 0;
+}
+
+static int acquire_fine(ResourceManager* rm, int pid, const int* req) {
+    const int* need = ROW(rm, need, pid);
+    for (;;) {
+        long long seen = atomic_load(&rm->release_seq);
+        unsigned long long mask = 0;
+        int blocked = -1, fast = 1;
+
+        // ·ʽ״ֻ̬ p ҪЩԴ󲻳 NeedѰڣ
+        read_lock(&rm->state_lock);
+        for (int j = 0; j < rm->nres; ++j) {
+            if (need[j] > 0) mask |= 1ULL << j;
+        }
+        lock_mask(rm, mask);
+        for (int j = 0; j < rm->nres; ++j) {
+            if (req[j] > AVAIL(rm, j)) {
+                blocked = j;
+                break;
+            }
+            if (need[j] > AVAIL(rm, j)) fast = 0;
+        }
+        if (blocked < 0 && fast) {
+            apply(rm, pid, req, 1);
+        }
+        unlock_mask(rm, mask);
+        read_unlock(&rm->state_lock);
+        if (blocked < 0 && fast) {
+            atomic_add(&rm->fast_path, 1);
+            return 0;
+        }
+
+        // ·ռ״̬İȫԼ飻 Available ʱסӦԴ wait_resource 
+        int safe = 0;
+        if (blocked < 0) {
+            write_lock(&rm->state_lock);
+            for (int j = 0; j < rm->nres; ++j) {
+                if (req[j] > AVAIL(rm, j)) {
+                    blocked = j;
+                    break;
+                }
+            }
+            if (blocked < 0) {
+                lock_mask(rm, mask);
+                apply(rm, pid, req, 1);
+                unlock_mask(rm, mask);
+                safe = is_safe(rm);
+                if (!safe) {
+                    lock_mask(rm, mask);
+                    apply(rm, pid, req, -1);
+                    unlock_mask(rm, mask);
+                }
+            }
+            write_unlock(&rm->state_lock);
+        }
+        if (safe) {
+            return 0;
+        }
+        if (blocked >= 0) {
+            wait_resource(rm, blocked, req[blocked]);
+        }
+        else {
+            wait_release(rm, seen);
+        }
+    }
+}
+
+int rm_acquire(ResourceManager* rm, int pid, const int* req) {
+    if (pid < 0 || pid >= rm->nproc) {
+        return -1;
+    }
+    const int* need = ROW(rm, need, pid);
+    for (int j = 0; j < rm->nres; ++j) {
+        if (req[j] < 0 || req[j] > need[j]) return -1;
+    }
+    if (rm->mode == RM_GLOBAL_LOCK) {
+        acquire_global(rm, pid, req);
+    }
+    else {
+        acquire_fine(rm, pid, req);
+    }
+    atomic_add(&rm->acquires, 1);
+    return 0;
+}
+
+/* ---------------- 黹 ---------------- */
+
+int rm_release(ResourceManager* rm, int pid, const int* vec) {
+    if (pid < 0 || pid >= rm->nproc) {
+        return -1;
+    }
+    const int* alloc = ROW(rm, alloc, pid);
+    unsigned long long mask = 0;
+    for (int j = 0; j < rm->nres; ++j) {
+        if (vec[j] < 0 || vec[j] > alloc[j]) return -1;
+        if (vec[j] > 0) mask |= 1ULL << j;
+    }
+    if (mask == 0) {
+        return 0;
+    }
+    if (rm->mode == RM_GLOBAL_LOCK) {
+        mutex_lock(&rm->global);
+        apply(rm, pid, vec, -1);
+        cond_broadcast(&rm->global_cond);
+        mutex_unlock(&rm->global);
+        return 0;
+    }
+
+    read_lock(&rm->state_lock);
+    lock_mask(rm, mask);
+    apply(rm, pid, vec, -1);
+    unlock_mask(rm, mask);
+    read_unlock(&rm->state_lock);
+    for (int j = 0; j < rm->nres; ++j) {
+        if (mask >> j & 1) {
+            mutex_lock(&rm->res[j].s.lock);
+            cond_broadcast(&rm->res[j].s.freed);
+            mutex_unlock(&rm->res[j].s.lock);
+        }
+    }
+    notify_release(rm);
+    return 0;
+}
+
+int rm_release_all(ResourceManager* rm, int pid) {
+    int held[RM_MAX_RES];
+    if (pid < 0 || pid >= rm->nproc) {
+        return -1;
+    }
+    memcpy(held, ROW(rm, alloc, pid), (size_t)rm->nres * sizeof(int));
+    return rm_release(rm, pid, held);
+}
+
+void rm_get_stats(ResourceManager* rm, RmStats* stats) {
+    stats->acquires = atomic_load(&rm->acquires);
+    stats->fast_path = atomic_load(&rm->fast_path);
+    stats->safety_checks = atomic_load(&rm->safety_checks);
+    stats->resource_waits = atomic_load(&rm->resource_waits);
+    stats->unsafe_waits = atomic_load(&rm->unsafe_waits);
+}
+
+int rm_check_idle(ResourceManager* rm) {
+    for (int j = 0; j < rm->nres; ++j) {
+        if (AVAIL(rm, j) != rm->total[j]) return 0;
+    }
+    for (size_t k = 0; k < (size_t)rm->nproc * rm->nres; ++k) {
+        if (rm->alloc[k] != 0 || rm->need[k] != rm->max[k]) return 0;
+    }
+    return 1;
+}
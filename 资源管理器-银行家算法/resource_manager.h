@@ -0,0 +1,48 @@
+/*
+ * ̰߳ȫԴм㷨
+ * ÿ pid һ̡ʱԸԴ Max
+ * rm_acquire ߣֱڱ֤ϵͳȫǰ·䣻
+ * rm_release 黹Դѿܼĵȴߡ
+ * ͬһ pid ͬһʱֻһ߳ʹãһ˳͹黹
+ */
+#ifndef RESOURCE_MANAGER_H
+#define RESOURCE_MANAGER_H
+
+#define RM_MAX_RES 64           // Դޣλ¼ҪԴ
+
+// ʽ
+#define RM_FINE_GRAINED 0       // д + ÿԴһȫԼ
+#define RM_GLOBAL_LOCK  1       // գһȫÿȫԼ
+
+typedef struct ResourceManager ResourceManager;
+
+typedef struct {
+    long long acquires;         // ɹ rm_acquire 
+    long long fast_path;        // вȫԼ׼Ĵ
+    long long safety_checks;    // ȫԼ
+    long long resource_waits;   // ԴĴ
+    long long unsafe_waits;     // 󲻰ȫĴ
+} RmStats;
+
+/*
+ * total[nres]Դmax[nproc * nres]дŵ
+ *  NULL ʾǷڴ治
+ */
+ResourceManager* rm_create(int nproc, int nres, const int* total, const int* max, int mode);
+void rm_destroy(ResourceManager* rm);
+
+//  req[nres] 0 = ѷ䣬-1 = pid Ƿ򳬹ý̵ʣ󣨲
+int rm_acquire(ResourceManager* rm, int pid, const int* req);
+
+// 黹 vec[nres] 0 = ɹ-1 = pid Ƿ򳬹ѷ״̬䣩
+int rm_release(ResourceManager* rm, int pid, const int* vec);
+
+// 黹 pid еȫԴ 0 = ɹ-1 = pid Ƿ
+int rm_release_all(ResourceManager* rm, int pid);
+
+void rm_get_stats(ResourceManager* rm, RmStats* stats);
+
+// û߳ʱã Available Ƿÿ̶ûгԴ 1 = һ
+int rm_check_idle(ResourceManager* rm);
+
+#endif
@@ -1,236 +1,1493 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "scheduler.h"
 
-#define MAX_PROCESSES 100
+#define PRINT_LIMIT 100     // ֵʱʾӡϸ
 
-typedef struct {
-    int pid;                //  ID
-    int arrival_time;       // ʱ
-    int service_time;       // ʱ䣨CPU 
-} ProcessBase;
+// Ƿн̴ I/O ͻ
+int has_io(const ProcessBase base[], int n) {
+    for (int i = 0; i < n; ++i) {
+        if (base[i].burst_count > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void free_processes(ProcessBase base[], int n) {
+    for (int i = 0; i < n; ++i) {
+        free(base[i].bursts);
+    }
+    free(base);
+}
+
+/*
+ * ʱ򣬷水ʱƽ
+ * LSD ÿ 16 λO(n)ȶͬһʱ̵Ḻ̌˳
+ * ֻ󵽴ʱЧλΪֹСʱͨ 1~2 ˼ɡ
+ */
+int sort_by_arrival(ProcessBase p[], int n) {
+    long long max_key = 0;
+    for (int i = 0; i < n; ++i) {
+        if (p[i].arrival_time > max_key) {
+            max_key = p[i].arrival_time;
+        }
+    }
+    if (n < 2 || max_key == 0) {
+        return 0;
+    }
+
+    ProcessBase* tmp = (ProcessBase*)malloc((size_t)n * sizeof(ProcessBase));
+    size_t* count = (size_t*)malloc(65536 * sizeof(size_t));
+    if (tmp == NULL || count == NULL) {
+        free(tmp);
+        free(count);
+        return 1;
+    }
+
+    ProcessBase* src = p;
+    ProcessBase* dst = tmp;
+    for (int shift = 0; shift < 64 && (max_key >> shift) != 0; shift += 16) {
+        memset(count, 0, 65536 * sizeof(size_t));
+        for (int i = 0; i < n; ++i) {
+            count[(src[i].arrival_time >> shift) & 0xFFFF]++;
+        }
+        size_t sum = 0;
+        for (int d = 0; d < 65536; ++d) {
+            size_t c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+        for (int i = 0; i < n; ++i) {
+            dst[count[(src[i].arrival_time >> shift) & 0xFFFF]++] = src[i];
+        }
+        ProcessBase* t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != p) {
+        memcpy(p, src, (size_t)n * sizeof(ProcessBase));
+    }
 
+    free(tmp);
+    free(count);
+    return 0;
+}
+
+// Ĭãˡлƿ豸ȷ뿪ģ֮ǰΪһ
+static const SimConfig DEFAULT_CONFIG = { 1, 0, 0, 0, 0, 0, 0, { 0 }, 0, 0, NULL, 0 };
+
+// иļʱԵÿ˵ʱд Chrome traceֻ߳д
+static Tracer* tracer;
+static TrRing* trace_ring;
+static int trace_runs;
+
+// Դ±˳ѰʱźḶ̌ѡÿ̵н
 typedef struct {
-    int pid;
-    int arrival_time;
-    int service_time;
-    int remaining_time;
-    int start_time;         // һοʼִеʱ
-    int finish_time;        // ʱ
-    double turnaround_time;         // תʱ =  - 
-    double weighted_turnaround_time; // Ȩתʱ = ת / 
-} ProcessRun;
-
-// ʱ򣬷水ʱƽ
-void sort_by_arrival(ProcessBase p[], int n) {
-    for (int i = 0; i < n - 1; ++i) {
-        for (int j = 0; j < n - 1 - i; ++j) {
-            if (p[j].arrival_time > p[j + 1].arrival_time) {
-                ProcessBase tmp = p[j];
-                p[j] = p[j + 1];
-                p[j + 1] = tmp;
+    const ProcessBase* base;
+    int n;
+    int next;
+    ProcessRun* runs;       // ţ±꣩ţΪ NULL ʱ¼
+} ArraySource;
+
+static int array_next(ProcessSource* self, ProcessBase* out) {
+    ArraySource* a = (ArraySource*)self->state;
+    if (a->next == a->n) {
+        return 0;
+    }
+    *out = a->base[a->next++];
+    return 1;
+}
+
+static void array_complete(ProcessSource* self, long long seq, const ProcessBase* p,
+    const ProcessRun* r) {
+    ArraySource* a = (ArraySource*)self->state;
+    (void)p;
+    if (a->runs != NULL) {
+        a->runs[seq] = *r;
+    }
+}
+
+// ÿ̵ϸ
+static void array_report(ProcessSource* self) {
+    ArraySource* a = (ArraySource*)self->state;
+    if (a->runs == NULL) {
+        printf(" %d  %dʡϸ\n", a->n, PRINT_LIMIT);
+        return;
+    }
+    printf("PID\t\t\tȼ\tʼ\t\tת\tȨת\n");
+    for (int i = 0; i < a->n; ++i) {
+        const ProcessBase* b = &a->base[i];
+        double t = (double)(a->runs[i].finish_time - b->arrival_time);
+        printf("%d\t%lld\t%lld\t%d\t%lld\t%lld\t%.1f\t%.2f\n",
+            b->pid,
+            b->arrival_time,
+            b->service_time,
+            b->priority,
+            a->runs[i].start_time,
+            a->runs[i].finish_time,
+            t,
+            t / b->service_time);
+    }
+}
+
+/*
+ * õһģ⣬ʱӡʾ
+ * detail1=ģɹ reportΪ NULLӡϸӡÿͳƣʱ
+ * ֵ0=ɹ1=ڴ治Դ
+ */
+static int simulate_detail(ProcessSource* src, void (*report)(ProcessSource* self),
+    int policy_id, int time_quantum, const SimConfig* cfg, int detail, SchedStats* st) {
+    CpuStats* cpu = NULL;
+    if (detail && cfg->ncpu > 1) {
+        cpu = (CpuStats*)malloc((size_t)cfg->ncpu * sizeof(CpuStats));
+        if (cpu == NULL) {
+            printf("ڴ治㣬ģֹ\n");
+            return 1;
+        }
+    }
+    int ret = simulate_source(src, policy_id, time_quantum, cfg, st, cpu);
+    if (ret != 0) {
+        printf("ڴ治Դģֹ\n");
+    }
+    else if (detail) {
+        if (report != NULL) {
+            report(src);
+        }
+        if (cpu != NULL) {
+            printf("\n\tЧ\t\t\tɴ\n");
+            for (int c = 0; c < cfg->ncpu; ++c) {
+                printf("%d\t%lld\t\t%lld\t%.2f%%\t%lld\n", c,
+                    cpu[c].busy_time, cpu[c].overhead_time,
+                    st->makespan > 0 ? 100.0 * cpu[c].busy_time / st->makespan : 0.0,
+                    cpu[c].dispatches);
             }
         }
     }
+    free(cpu);
+    return ret;
+}
+
+/*
+ * ڴеĽһȣѰʱ
+ * detail1=ӡÿ̵ϸ PRINT_LIMIT ʱÿͳ
+ * ֵ0=ɹ1=ڴ治
+ */
+int simulate(ProcessBase base[], int n, int policy_id, int time_quantum,
+    const SimConfig* cfg, int detail, SchedStats* st) {
+    ArraySource a = { base, n, 0, NULL };
+    ProcessSource src = { array_next, array_complete, NULL, &a };
+
+    if (detail && n <= PRINT_LIMIT) {
+        a.runs = (ProcessRun*)malloc((size_t)(n > 0 ? n : 1) * sizeof(ProcessRun));
+        if (a.runs == NULL) {
+            printf("ڴ治㣬ģֹ\n");
+            return 1;
+        }
+    }
+    int ret = simulate_detail(&src, array_report, policy_id, time_quantum, cfg, detail, st);
+    free(a.runs);
+    return ret;
 }
 
-// Уѭʵ֣
+/* ---------------- ø̣ռڴ棩 ---------------- */
+
+enum { GEN_POISSON, GEN_MMPP };                     // 
+enum { GEN_EXP, GEN_PARETO, GEN_BIMODAL };          // ʱֲ
+
 typedef struct {
-    int data[MAX_PROCESSES];
-    int front;
-    int rear;
-    int count;
-} Queue;
+    unsigned long long seed;
+    long long count;        // 
+    int arrival;
+    int service;
+    double mean_service;    // ƽʱ
+    double load;            // Ŀ긺  = ˡE[S] / 
+    double rate;            // ƽ ˣ load ͺ㣬̶֮
+    double burst_ratio;     // MMPP߷嵽 / ͹ȵ
+    double mmpp_period;     // MMPPÿ״̬ƽʱ
+    double pareto_alpha;    // Pareto ״ > 1
+    double short_fraction;  // ˫壺ҵ
+    double long_ratio;      // ˫壺ҵ / ҵʱ
+} GenConfig;
 
-void init_queue(Queue* q) {
-    q->front = 0;
-    q->rear = 0;
-    q->count = 0;
+typedef struct {
+    const GenConfig* cfg;
+    unsigned long long rng;
+    long long made;
+    double clock;
+    int high;               // MMPP ǰǷڸ߷״̬
+    double state_left;      // MMPP ǰ״̬ʣʱ
+} Generator;
+
+// splitmix64״ֻ̬һ 64 λͬһӽɸ
+static unsigned long long next_random(unsigned long long* x) {
+    unsigned long long z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
 }
 
-int is_empty(Queue* q) {
-    return q->count == 0;
+// (0, 1] ϵľȷֲ
+static double uniform01(unsigned long long* x) {
+    return ((next_random(x) >> 11) + 1) * (1.0 / 9007199254740992.0);
 }
 
-void enqueue(Queue* q, int x) {
-    if (q->count == MAX_PROCESSES) {
-        printf("޷\n");
-        return;
+static double exponential(unsigned long long* x, double mean) {
+    return -mean * log(uniform01(x));
+}
+
+static double sample_service(Generator* g) {
+    const GenConfig* c = g->cfg;
+    if (c->service == GEN_PARETO) {
+        double xm = c->mean_service * (c->pareto_alpha - 1) / c->pareto_alpha;
+        return xm / pow(uniform01(&g->rng), 1.0 / c->pareto_alpha);
+    }
+    if (c->service == GEN_BIMODAL) {
+        double a = c->mean_service /
+            (c->short_fraction + (1 - c->short_fraction) * c->long_ratio);
+        return uniform01(&g->rng) <= c->short_fraction ? a : a * c->long_ratio;
+    }
+    return exponential(&g->rng, c->mean_service);
+}
+
+// һεļMMPP ڸߵ֮л״̬ƽʱͬ
+static double sample_interarrival(Generator* g) {
+    const GenConfig* c = g->cfg;
+    if (c->arrival == GEN_POISSON) {
+        return exponential(&g->rng, 1.0 / c->rate);
+    }
+    double lo = 2 * c->rate / (1 + c->burst_ratio);
+    double dt = 0;
+    for (;;) {
+        double step = exponential(&g->rng, 1.0 / (g->high ? lo * c->burst_ratio : lo));
+        if (step < g->state_left) {
+            g->state_left -= step;
+            return dt + step;
+        }
+        // ״̬лˣֲָ޼䣬״̬³
+        dt += g->state_left;
+        g->high = !g->high;
+        g->state_left = exponential(&g->rng, c->mmpp_period);
+    }
+}
+
+static int gen_next(ProcessSource* self, ProcessBase* out) {
+    Generator* g = (Generator*)self->state;
+    if (g->made == g->cfg->count) {
+        return 0;
+    }
+    g->clock += sample_interarrival(g);
+    long long service = (long long)(sample_service(g) + 0.5);
+    memset(out, 0, sizeof(*out));
+    out->pid = (int)++g->made;
+    out->arrival_time = (long long)g->clock;
+    out->service_time = service > 0 ? service : 1;
+    return 1;
+}
+
+/* ---------------- ʵʱ񼯣/żͷʱҵ ---------------- */
+
+typedef struct {
+    long long wcet;         // ÿҵִʱ C
+    long long period;       //  TżΪС
+    long long deadline;     // Խֹ DC <= D <= T
+    int sporadic;           // 0= 1=ż
+} RtTask;
+
+typedef struct {
+    RtTask* tasks;
+    int count;
+    long long horizon;      // ֻͷ [0, horizon) ڵҵ
+    double jitter;          // żĵ [T, T(1+jitter)] ھȷֲ
+    unsigned long long seed;
+} TaskSet;
+
+/*
+ * һҵͷʱ䣬ͷʱͬʱȺ󣨿ʼʱţ
+ * ֹģÿɨȡļ
+ */
+typedef struct {
+    const TaskSet* ts;
+    long long* release;     // -1 ʾ horizon ڲͷҵ
+    long long* order;       // 
+    long long next_order;
+    unsigned long long rng;
+} TaskSetSource;
+
+static int taskset_next(ProcessSource* self, ProcessBase* out) {
+    TaskSetSource* t = (TaskSetSource*)self->state;
+    int k = -1;
+    for (int i = 0; i < t->ts->count; ++i) {
+        if (t->release[i] >= 0 && (k == -1 || t->release[i] < t->release[k] ||
+            (t->release[i] == t->release[k] && t->order[i] < t->order[k]))) {
+            k = i;
+        }
+    }
+    if (k == -1) {
+        return 0;
+    }
+    long long at = t->release[k];
+    const RtTask* task = &t->ts->tasks[k];
+    memset(out, 0, sizeof(*out));
+    out->pid = k + 1;
+    out->arrival_time = at;
+    out->service_time = task->wcet;
+    out->deadline = at + task->deadline;
+    out->period = task->period;
+
+    long long gap = task->period;
+    if (task->sporadic) {
+        gap += (long long)(task->period * t->ts->jitter * (1 - uniform01(&t->rng)));
     }
-    q->data[q->rear] = x;
-    q->rear = (q->rear + 1) % MAX_PROCESSES;
-    q->count++;
+    t->release[k] = at + gap < t->ts->horizon ? at + gap : -1;
+    t->order[k] = t->next_order++;
+    return 1;
 }
 
-int dequeue(Queue* q) {
-    if (is_empty(q)) {
-        printf("Ϊգ޷\n");
-        return -1;
+static int taskset_open(TaskSetSource* t, const TaskSet* ts) {
+    t->ts = ts;
+    t->rng = ts->seed;
+    t->release = (long long*)malloc((size_t)ts->count * sizeof(long long));
+    t->order = (long long*)malloc((size_t)ts->count * sizeof(long long));
+    if (t->release == NULL || t->order == NULL) {
+        return 1;
+    }
+    for (int i = 0; i < ts->count; ++i) {
+        t->release[i] = 0;
+        t->order[i] = i;
     }
-    int x = q->data[q->front];
-    q->front = (q->front + 1) % MAX_PROCESSES;
-    q->count--;
-    return x;
+    t->next_order = ts->count;
+    return 0;
+}
+
+static void taskset_close(TaskSetSource* t) {
+    free(t->release);
+    free(t->order);
+}
+
+//  horizon ͷŵҵ
+static long long taskset_jobs(const TaskSet* ts) {
+    TaskSetSource t;
+    ProcessSource src = { taskset_next, NULL, NULL, &t };
+    ProcessBase p;
+    long long jobs = 0;
+    if (taskset_open(&t, ts) == 0) {
+        while (taskset_next(&src, &p) == 1) {
+            jobs++;
+        }
+    }
+    taskset_close(&t);
+    return jobs;
 }
 
-// ģԸʱƬ time_quantum һȣ
-void simulate_rr(ProcessBase base[], int n, int time_quantum) {
-    // һʱݣʵ໥Ӱ
-    ProcessRun proc[MAX_PROCESSES];
+/*
+ * ˿ɵԷͬͷšҵ
+ * RMSLiu-Layland ʽ U <= n(2^(1/n)-1)˫ (U_i+1) <= 2 ǳ
+ *      Ӧʱ R = C_i +  ceil(R/T_j)C_jj Ϊڸ̻ͬǾȷж
+ * EDFD = T ʱ U <= 1 ǳҪԣ
+ *       [0, L] ÿԽֹ t   (floor((t-D_i)/T_i)+1)C_i <= t
+ */
+void analyze_task_set(const TaskSet* ts) {
+    int n = ts->count;
+    double u = 0, hyper = 1, density = 0;
+    int implicit = 1;
+    for (int i = 0; i < n; ++i) {
+        const RtTask* t = &ts->tasks[i];
+        double ui = (double)t->wcet / t->period;
+        u += ui;
+        hyper *= ui + 1;
+        density += (double)t->wcet / t->deadline;
+        implicit &= t->deadline == t->period;
+    }
+    double ll = n * (pow(2.0, 1.0 / n) - 1);
+
+    printf("\n===== ˿ɵԷ%d  U = %.4f=====\n", n, u);
+    printf("RMS ʽ磺U <= %.4f %s\n", ll, u <= ll ? "ɵ" : "ܾݴж");
+    printf("RMS ˫磺(U_i+1) = %.4f %s\n", hyper,
+        hyper <= 2 ? "<= 2ɵ" : "> 2ܾݴж");
+
+    // Ӧʱ㣬Խֹڼжɵ
+    int rta_ok = 1;
+    printf("\tC\tT\tD\tRMS Ӧ\n");
+    for (int i = 0; i < n; ++i) {
+        const RtTask* ti = &ts->tasks[i];
+        long long r = ti->wcet, prev = -1;
+        while (r != prev && r <= ti->deadline) {
+            prev = r;
+            r = ti->wcet;
+            for (int j = 0; j < n; ++j) {
+                const RtTask* tj = &ts->tasks[j];
+                if (j != i && (tj->period < ti->period || (tj->period == ti->period && j < i))) {
+                    r += (prev + tj->period - 1) / tj->period * tj->wcet;
+                }
+            }
+        }
+        if (r <= ti->deadline) {
+            printf("%d\t%lld\t%lld\t%lld\t%lld\n", i + 1, ti->wcet, ti->period, ti->deadline, r);
+        }
+        else {
+            printf("%d\t%lld\t%lld\t%lld\t> D\n", i + 1, ti->wcet, ti->period, ti->deadline);
+            rta_ok = 0;
+        }
+    }
+    printf("RMS Ӧʱ%s\n", rta_ok ? "ȫֹڣɵ" : "ֹܴ");
+
+    if (u > 1) {
+        printf("EDFU > 1ɵ\n");
+        return;
+    }
+    if (implicit || density <= 1) {
+        printf("EDF%sɵ\n", implicit ? "D = T  U <= 1" : "ܶ  C/D <= 1");
+        return;
+    }
+    // ԵļϽ磺U < 1 ʱΪ max(D_i, (T_i-D_i)U_i / (1-U))ģʱֻ鵽ģʱ
+    long long limit = ts->horizon;
+    int capped = 1;
+    if (u < 1) {
+        double la = 0;
+        for (int i = 0; i < n; ++i) {
+            const RtTask* t = &ts->tasks[i];
+            la += (double)(t->period - t->deadline) * t->wcet / t->period;
+        }
+        la /= 1 - u;
+        for (int i = 0; i < n; ++i) {
+            if (ts->tasks[i].deadline > la) la = (double)ts->tasks[i].deadline;
+        }
+        if (la < (double)limit) {
+            limit = (long long)la + 1;
+            capped = 0;
+        }
+    }
     for (int i = 0; i < n; ++i) {
-        proc[i].pid = base[i].pid;
-        proc[i].arrival_time = base[i].arrival_time;
-        proc[i].service_time = base[i].service_time;
-        proc[i].remaining_time = base[i].service_time;
-        proc[i].start_time = -1;
-        proc[i].finish_time = -1;
-        proc[i].turnaround_time = 0.0;
-        proc[i].weighted_turnaround_time = 0.0;
-    }
-
-    int current_time = 0;
-    int completed = 0;
-    int next_arrival_index = 0;   // ָһûϵͳĽ
-
-    Queue ready;
-    init_queue(&ready);
-
-    double sum_turnaround = 0.0;
-    double sum_weighted_turnaround = 0.0;
-
-    while (completed < n) {
-        // еʱ <= ǰʱĽ̷
-        while (next_arrival_index < n &&
-            proc[next_arrival_index].arrival_time <= current_time) {
-            enqueue(&ready, next_arrival_index);
-            next_arrival_index++;
-        }
-
-        // Ϊգнûֱһ̵ʱ
-        if (is_empty(&ready)) {
-            if (next_arrival_index < n) {
-                current_time = proc[next_arrival_index].arrival_time;
-                // ĽӣԼͬһʱ̵ģ
-                while (next_arrival_index < n &&
-                    proc[next_arrival_index].arrival_time <= current_time) {
-                    enqueue(&ready, next_arrival_index);
-                    next_arrival_index++;
+        const RtTask* ti = &ts->tasks[i];
+        for (long long d = ti->deadline; d <= limit; d += ti->period) {
+            long long demand = 0;
+            for (int j = 0; j < n; ++j) {
+                const RtTask* tj = &ts->tasks[j];
+                if (d >= tj->deadline) {
+                    demand += ((d - tj->deadline) / tj->period + 1) * tj->wcet;
                 }
             }
-            else {
-                // ϲߵûоûδûɣ
-                break;
+            if (demand > d) {
+                printf("EDF ԣt = %lld ʱ %lld > tɵ\n", d, demand);
+                return;
             }
         }
+    }
+    printf("EDF ԣ鵽 t = %lld 㣬%s\n", limit,
+        capped ? "ģʱڲֹ" : "ɵ");
+}
 
-        int idx = dequeue(&ready);
-        ProcessRun* p = &proc[idx];
+// һģḶֹ̌飬ʵʱ񼯰ʱÿģⶼͷطţ
+typedef struct {
+    ProcessBase* base;      // Ϊ NULL ʱʹ񼯻򵽴
+    int n;
+    const GenConfig* gen;
+    const TaskSet* tasks;   //  NULL ʱ
+    ProcessSource* stream;  // ģʽĵֻģһΣ NULL ʱԴ
+} Workload;
 
-        // һִʱ¼ʼʱ
-        if (p->start_time == -1) {
-            p->start_time = current_time;
-        }
+static long long workload_size(const Workload* w) {
+    if (w->base != NULL) return w->n;
+    if (w->stream != NULL) return 0;    // δ֪
+    return w->tasks != NULL ? taskset_jobs(w->tasks) : w->gen->count;
+}
 
-        // ʵִʱ
-        int exec_time = (p->remaining_time <= time_quantum)
-            ? p->remaining_time
-            : time_quantum;
+static int workload_has_io(const Workload* w) {
+    return w->base != NULL && has_io(w->base, w->n);
+}
 
-        current_time += exec_time;
-        p->remaining_time -= exec_time;
+int simulate_workload(const Workload* w, int policy_id, int time_quantum,
+    const SimConfig* cfg, int detail, SchedStats* st) {
+    if (w->base != NULL) {
+        return simulate(w->base, w->n, policy_id, time_quantum, cfg, detail, st);
+    }
+    if (w->stream != NULL) {
+        return simulate_detail(w->stream, NULL, policy_id, time_quantum, cfg, detail, st);
+    }
+    if (w->tasks != NULL) {
+        TaskSetSource t;
+        ProcessSource src = { taskset_next, NULL, NULL, &t };
+        int ret = taskset_open(&t, w->tasks);
+        if (ret != 0) {
+            printf("ڴ治㣬ģֹ\n");
+        }
+        else {
+            ret = simulate_detail(&src, NULL, policy_id, time_quantum, cfg, detail, st);
+        }
+        taskset_close(&t);
+        return ret;
+    }
+    Generator g;
+    memset(&g, 0, sizeof(g));
+    g.cfg = w->gen;
+    g.rng = w->gen->seed;
+    g.state_left = exponential(&g.rng, w->gen->mmpp_period);
+    ProcessSource src = { gen_next, NULL, NULL, &g };
+    return simulate_detail(&src, NULL, policy_id, time_quantum, cfg, detail, st);
+}
 
-        // ִйУ½̵ˣǼ
-        while (next_arrival_index < n &&
-            proc[next_arrival_index].arrival_time <= current_time) {
-            enqueue(&ready, next_arrival_index);
-            next_arrival_index++;
+// I/O ֵı棺豸ʡȴʱԼ CPU  I/O ص
+static void print_io_stats(const SchedStats* st, const SimConfig* cfg) {
+    long long requests = 0;
+    for (int d = 0; d < MAX_DEVICES; ++d) {
+        requests += st->io_requests[d];
+    }
+    if (requests == 0) {
+        return;
+    }
+    printf("CPU  = %.2f%%I/O  = %lldƽ豸Ŷʱ = %.2f\n",
+        100.0 * st->avg_util, requests, (double)st->io_wait / requests);
+    for (int d = 0; d < MAX_DEVICES; ++d) {
+        if (st->io_requests[d] > 0) {
+            printf("豸 %d%s = %lld = %.2f%%\n", d,
+                cfg->dev_sched[d] == DEV_ELEVATOR ? "" : "ȷ",
+                st->io_requests[d],
+                st->makespan > 0 ? 100.0 * st->io_busy[d] / st->makespan : 0.0);
         }
+    }
+    printf("CPU  I/O صʱ = %lldռʱ %.2f%% = %.4f /ʱ䵥λ\n",
+        st->overlap_time,
+        st->makespan > 0 ? 100.0 * st->overlap_time / st->makespan : 0.0,
+        st->makespan > 0 ? (double)st->processes / st->makespan : 0.0);
+}
 
-        if (p->remaining_time == 0) {
-            // ý
-            p->finish_time = current_time;
-            p->turnaround_time = p->finish_time - p->arrival_time;
-            p->weighted_turnaround_time = p->turnaround_time / p->service_time;
+static void print_quantiles(const char* name, const Quantiles* q) {
+    printf("%s P50/P95/P99/P99.9/ = %lld / %lld / %lld / %lld / %lld\n",
+        name, q->p50, q->p95, q->p99, q->p999, q->max);
+}
 
-            sum_turnaround += p->turnaround_time;
-            sum_weighted_turnaround += p->weighted_turnaround_time;
-            completed++;
-        }
-        else {
-            // ûɣ
-            enqueue(&ready, idx);
+// Ե
+int simulate_policy(const Workload* w, int policy_id, int time_quantum,
+    const SimConfig* cfg) {
+    SchedStats st;
+    SimConfig traced = *cfg;
+
+    // ÿαǸһ̣ÿһ
+    if (trace_ring != NULL) {
+        char name[64];
+        traced.trace = trace_ring;
+        traced.trace_pid = ++trace_runs;
+        sprintf(name, "%s q=%d", policy_name(policy_id), time_quantum);
+        tr_name(tracer, traced.trace_pid, -1, name);
+        for (int c = 0; c < cfg->ncpu; ++c) {
+            sprintf(name, "CPU %d", c);
+            tr_name(tracer, traced.trace_pid, c, name);
         }
+        cfg = &traced;
     }
 
     // 
     printf("\n=============================\n");
+    printf("  Ȳ = %s\n", policy_name(policy_id));
     printf("  ʱƬС = %d\n", time_quantum);
+    if (cfg->ncpu > 1) {
+        printf("  CPU  = %d%s\n", cfg->ncpu,
+            cfg->per_cpu_queues ? "ÿ˶" : "ȫֶ");
+    }
     printf("=============================\n");
-    printf("PID\t\t\tʼ\t\tת\tȨת\n");
-    for (int i = 0; i < n; ++i) {
-        printf("%d\t%d\t%d\t%d\t%d\t%.1f\t%.2f\n",
-            proc[i].pid,
-            proc[i].arrival_time,
-            proc[i].service_time,
-            proc[i].start_time,
-            proc[i].finish_time,
-            proc[i].turnaround_time,
-            proc[i].weighted_turnaround_time);
+    if (simulate_workload(w, policy_id, time_quantum, cfg, 1, &st) != 0) {
+        return 1;
     }
 
     printf("---------------------------------------------\n");
-    printf("ƽתʱ = %.2f\n", sum_turnaround / n);
-    printf("ƽȨתʱ = %.2f\n", sum_weighted_turnaround / n);
+    printf("ƽתʱ = %.2f\n", st.sum_turnaround / st.processes);
+    printf("ƽȨתʱ = %.2f\n", st.sum_weighted_turnaround / st.processes);
+    printf("ƽӦʱ = %.2f\n", st.sum_response / st.processes);
+    printf("ƽȴʱ = %.2f\n", st.sum_waiting / st.processes);
+    print_quantiles("תʱ", &st.turnaround);
+    print_quantiles("Ӧʱ", &st.response);
+    print_quantiles("ȴʱ", &st.waiting);
+    printf("Jain ƽָ = %.4fCPU ʱ = %lld\n", st.fairness, st.idle_time);
+    if (cfg->window > 0) {
+        printf("ÿ %lld ʱ䵥λ %lldƽ %.2f %lld %lld \n",
+            cfg->window, st.min_window, st.avg_window, st.max_window, st.windows);
+    }
+    printf("ɴ = %lldռ = %lld\n", st.dispatches, st.preemptions);
+    if (st.overhead_time > 0) {
+        printf("л = %lld Σʱ = %lldռ CPU ʱ %.2f%%\n",
+            st.context_switches, st.overhead_time,
+            100.0 * st.overhead_time / (st.overhead_time + st.busy_time));
+    }
+    if (cfg->ncpu > 1) {
+        printf("Ǩƴ = %lldȡ = %lld = %lld\n",
+            st.migrations, st.steals, st.rebalance_moves);
+        printf("ƽ = %.2f%% %.2f%% %.2f%%\n",
+            100.0 * st.avg_util, 100.0 * st.min_util, 100.0 * st.max_util);
+    }
+    print_io_stats(&st, cfg);
+    if (st.deadline_jobs > 0) {
+        printf("ֹڣҵ = %lld = %lld%.2f%%ƽӳ = %.2fӳ = %lld\n",
+            st.deadline_jobs, st.deadline_misses, 100.0 * st.deadline_misses / st.deadline_jobs,
+            st.sum_lateness / st.deadline_jobs, st.max_lateness);
+        print_quantiles("ʱ", &st.tardiness);
+    }
+    return 0;
 }
 
-int main() {
-    int n;
-    ProcessBase base[MAX_PROCESSES];
+int simulate_rr(ProcessBase base[], int n, int time_quantum) {
+    Workload w = { base, n, NULL, NULL, NULL };
+    return simulate_policy(&w, POLICY_RR, time_quantum, &DEFAULT_CONFIG);
+}
 
-    printf(" n (<= %d): ", MAX_PROCESSES);
-    if (scanf("%d", &n) != 1 || n <= 0 || n > MAX_PROCESSES) {
-        printf("Ƿ\n");
+// ͬһءͬһʱƬвԵָԱ
+int compare_policies(const Workload* w, int time_quantum, const SimConfig* cfg) {
+    printf("\n===== ԶԱȣʱƬ = %d = %lld = %d=====\n",
+        time_quantum, workload_size(w), cfg->ncpu);
+    int io = workload_has_io(w);
+    int rt = w->tasks != NULL;
+    printf("\tƽת\tƽȨ\tƽӦ\tP50\tP95\tP99\t\tռ%s%s\n",
+        io ? "\tCPU\tصռ\t" : "",
+        rt ? "\tֹ\tӳ\tP99" : "");
+    for (int id = 0; id < POLICY_COUNT; ++id) {
+        SchedStats st;
+        if (simulate_workload(w, id, time_quantum, cfg, 0, &st) != 0) {
+            return 1;
+        }
+        printf("%s\t%.2f\t\t%.2f\t\t%.2f\t\t%lld\t%lld\t%lld\t%lld\t%lld",
+            policy_name(id),
+            st.sum_turnaround / st.processes,
+            st.sum_weighted_turnaround / st.processes,
+            st.sum_response / st.processes,
+            st.turnaround.p50, st.turnaround.p95, st.turnaround.p99,
+            st.turnaround.max, st.preemptions);
+        if (io) {
+            printf("\t%.2f%%\t\t%.2f%%\t\t%.4f",
+                100.0 * st.avg_util,
+                st.makespan > 0 ? 100.0 * st.overlap_time / st.makespan : 0.0,
+                st.makespan > 0 ? (double)st.processes / st.makespan : 0.0);
+        }
+        if (rt) {
+            printf("\t%.2f%%\t\t%lld\t\t%lld",
+                st.deadline_jobs > 0 ? 100.0 * st.deadline_misses / st.deadline_jobs : 0.0,
+                st.max_lateness, st.tardiness.p99);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+//  1  cfg->ncpuԱȫֶÿ˶
+int compare_smp(const Workload* w, int policy_id, int time_quantum,
+    const SimConfig* cfg) {
+    printf("\n===== ȫֶ vs ÿ˶У = %sʱƬ = %d=====\n",
+        policy_name(policy_id), time_quantum);
+    printf("\t֯\tƽת\tP99\tƽ\tʼ\tǨ\tȡ\tʱ\n");
+    for (int k = 1; ; k = k * 2 < cfg->ncpu ? k * 2 : cfg->ncpu) {
+        for (int design = 0; design <= 1; ++design) {
+            SimConfig c = *cfg;
+            SchedStats st;
+            c.ncpu = k;
+            c.per_cpu_queues = design;
+            if (simulate_workload(w, policy_id, time_quantum, &c, 0, &st) != 0) {
+                return 1;
+            }
+            printf("%d\t%s\t%.2f\t\t%lld\t%.2f%%\t\t%.2f%%\t\t%lld\t%lld\t%lld\n",
+                k, design ? "ÿ" : "ȫ",
+                st.sum_turnaround / st.processes, st.turnaround.p99,
+                100.0 * st.avg_util, 100.0 * (st.max_util - st.min_util),
+                st.migrations, st.steals, st.overhead_time);
+        }
+        if (k == cfg->ncpu) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/* ---------------- ʱƬԶ̲߳ѡʱƬ ---------------- */
+
+#define SEARCH_GRID 32      // һִѵĺѡ
+#define MAX_WORKERS 64
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+#define THREAD_RET DWORD WINAPI
+#define THREAD_RET_VALUE 0
+#else
+typedef pthread_t thread_t;
+#define THREAD_RET void*
+#define THREAD_RET_VALUE NULL
+#endif
+
+static int thread_start(thread_t* t, THREAD_RET (*fn)(void*), void* arg) {
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t == NULL;
+#else
+    return pthread_create(t, NULL, fn, arg) != 0;
+#endif
+}
+
+static void thread_join(thread_t t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+static int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long k = sysconf(_SC_NPROCESSORS_ONLN);
+    return k > 0 ? (int)k : 1;
+#endif
+}
+
+// һѡʱƬ
+typedef struct {
+    int quantum;
+    int error;
+    SchedStats st;
+} QuantumTrial;
+
+typedef struct {
+    const Workload* w;
+    int policy_id;
+    const SimConfig* cfg;
+    QuantumTrial* trials;
+    int count;
+    int worker;             // ̱߳ţ worker, worker+nworkers, ... ̬ѡ
+    int nworkers;
+} SearchTask;
+
+static THREAD_RET search_worker(void* arg) {
+    SearchTask* t = (SearchTask*)arg;
+    for (int i = t->worker; i < t->count; i += t->nworkers) {
+        QuantumTrial* q = &t->trials[i];
+        q->error = simulate_workload(t->w, t->policy_id, q->quantum, t->cfg, 0, &q->st);
+    }
+    return THREAD_RET_VALUE;
+}
+
+//  trials еÿʱƬ̴߳ʧʱ˻صǰ߳
+static int evaluate_trials(const Workload* w, int policy_id, const SimConfig* cfg,
+    QuantumTrial trials[], int count) {
+    SearchTask tasks[MAX_WORKERS];
+    thread_t threads[MAX_WORKERS];
+    int started[MAX_WORKERS];
+    int nworkers = cpu_count();
+    if (nworkers > MAX_WORKERS) nworkers = MAX_WORKERS;
+    if (nworkers > count) nworkers = count;
+
+    for (int k = 0; k < nworkers; ++k) {
+        SearchTask t = { w, policy_id, cfg, trials, count, k, nworkers };
+        tasks[k] = t;
+        started[k] = k > 0 && thread_start(&threads[k], search_worker, &tasks[k]) == 0;
+    }
+    search_worker(&tasks[0]);
+    for (int k = 1; k < nworkers; ++k) {
+        if (started[k]) thread_join(threads[k]);
+        else search_worker(&tasks[k]);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (trials[i].error) return 1;
+    }
+    return 0;
+}
+
+static double trial_cost(const QuantumTrial* q, int use_p99) {
+    return use_p99 ? (double)q->st.turnaround.p99 : q->st.sum_turnaround / q->st.processes;
+}
+
+static void print_trial(const QuantumTrial* q, int best) {
+    long long cpu_time = q->st.busy_time + q->st.overhead_time;
+    printf("%d\t%.2f\t\t%lld\t%lld\t\t%.2f%%\t\t%.4f%s\n",
+        q->quantum,
+        q->st.sum_turnaround / q->st.processes,
+        q->st.turnaround.p99,
+        q->st.context_switches,
+        cpu_time > 0 ? 100.0 * q->st.overhead_time / cpu_time : 0.0,
+        q->st.makespan > 0 ? (double)q->st.processes / q->st.makespan : 0.0,
+        best ? "\t<- " : "");
+}
+
+/*
+ *  [qmin, qmax] ʹƽתuse_p99=0 P99 תuse_p99=1СʱƬ
+ * һ֣䲻ʱȡ SEARCH_GRID ηֲĵ
+ * ڶ֣ŵھ̫֮ʱȾȡ SEARCH_GRID 
+ */
+int search_quantum(const Workload* w, int policy_id, const SimConfig* cfg,
+    int qmin, int qmax, int use_p99) {
+    QuantumTrial grid[SEARCH_GRID], fine[SEARCH_GRID];
+    int ng = 0, nf = 0;
+
+    if (qmax - qmin + 1 <= SEARCH_GRID) {
+        for (int q = qmin; q <= qmax; ++q) grid[ng++].quantum = q;
+    }
+    else {
+        double ratio = pow((double)qmax / qmin, 1.0 / (SEARCH_GRID - 1));
+        double x = qmin;
+        for (int i = 0; i < SEARCH_GRID; ++i, x *= ratio) {
+            int q = i == SEARCH_GRID - 1 ? qmax : (int)(x + 0.5);
+            if (ng == 0 || q > grid[ng - 1].quantum) grid[ng++].quantum = q;
+        }
+    }
+    if (evaluate_trials(w, policy_id, cfg, grid, ng) != 0) {
+        return 1;
+    }
+
+    int best = 0;
+    for (int i = 1; i < ng; ++i) {
+        if (trial_cost(&grid[i], use_p99) < trial_cost(&grid[best], use_p99)) best = i;
+    }
+    QuantumTrial result = grid[best];
+
+    // ڶ֣ŵںѡ֮仹ûʱϸ
+    int lo = best > 0 ? grid[best - 1].quantum + 1 : qmin;
+    int hi = best < ng - 1 ? grid[best + 1].quantum - 1 : qmax;
+    if (hi - lo + 1 > 1) {
+        long long span = (long long)hi - lo;
+        for (int i = 0; i < SEARCH_GRID; ++i) {
+            int q = (int)(lo + span * i / (SEARCH_GRID - 1));
+            if (q != result.quantum && (nf == 0 || q > fine[nf - 1].quantum)) fine[nf++].quantum = q;
+        }
+        if (nf > 0 && evaluate_trials(w, policy_id, cfg, fine, nf) != 0) {
+            return 1;
+        }
+        for (int i = 0; i < nf; ++i) {
+            if (trial_cost(&fine[i], use_p99) < trial_cost(&result, use_p99)) result = fine[i];
+        }
+    }
+
+    printf("\n===== ʱƬ = %sĿ = %sΧ = [%d, %d] = %d=====\n",
+        policy_name(policy_id), use_p99 ? "P99 ת" : "ƽת",
+        qmin, qmax, cfg->ncpu);
+    printf("ʱƬ\tƽת\tP99\tл\tռ\t\n");
+    for (int i = 0; i < ng; ++i) {
+        print_trial(&grid[i], grid[i].quantum == result.quantum);
+    }
+    if (nf > 0) {
+        printf("--  [%d, %d] ϸ --\n", lo, hi);
+        for (int i = 0; i < nf; ++i) {
+            print_trial(&fine[i], fine[i].quantum == result.quantum);
+        }
+    }
+    printf("ʱƬ = %dƽת = %.2fP99 = %lld\n",
+        result.quantum, result.st.sum_turnaround / result.st.processes, result.st.turnaround.p99);
+
+    // 벻лʱȣԵ
+    if (cfg->switch_cost > 0 || cfg->cache_penalty > 0 || cfg->migration_cost > 0) {
+        SimConfig ideal = *cfg;
+        QuantumTrial base_trial = result;
+        ideal.switch_cost = ideal.cache_penalty = ideal.migration_cost = 0;
+        if (simulate_workload(w, policy_id, result.quantum, &ideal, 0, &base_trial.st) != 0) {
+            return 1;
+        }
+        double tp = result.st.makespan > 0 ? (double)result.st.processes / result.st.makespan : 0.0;
+        double tp0 = base_trial.st.makespan > 0 ? (double)base_trial.st.processes / base_trial.st.makespan : 0.0;
+        printf("㿪 = %.4fʵ = %.4fлʧ %.2f%%\n",
+            tp0, tp, tp0 > 0 ? 100.0 * (tp0 - tp) / tp0 : 0.0);
+    }
+    return 0;
+}
+
+/*
+ * ʱֶΣ֣öŷָCPU  I/O ͻ
+ *  5,d0:3,4,d1:2@120,1CPU 5  豸 0  I/O 3  CPU 4  豸 1 ŵ 120  I/O 2  CPU 1
+ * ֵ0=ɹ1=ʽ
+ */
+int parse_bursts(const char* text, ProcessBase* p) {
+    int k = 1;
+    for (const char* c = text; *c; ++c) {
+        k += *c == ',';
+    }
+    p->burst_count = 0;
+    p->bursts = NULL;
+    p->service_time = 0;
+    if (k == 1) {
+        char* end;
+        p->service_time = strtoll(text, &end, 10);
+        return *end != '\0';
+    }
+    if (k % 2 == 0) {
+        return 1;                           //  CPU ͻͷͽβ
+    }
+
+    Burst* b = (Burst*)malloc((size_t)k * sizeof(Burst));
+    if (b == NULL) {
+        return 1;
+    }
+    const char* c = text;
+    for (int i = 0; i < k; ++i) {
+        char* end;
+        b[i].device = -1;
+        b[i].track = 0;
+        if (i % 2 == 1) {
+            if (*c != 'd') break;
+            b[i].device = (int)strtol(c + 1, &end, 10);
+            if (end == c + 1 || *end != ':' || b[i].device < 0 || b[i].device >= MAX_DEVICES) break;
+            c = end + 1;
+        }
+        b[i].length = strtoll(c, &end, 10);
+        if (end == c || b[i].length <= 0) break;
+        c = end;
+        if (i % 2 == 1 && *c == '@') {
+            b[i].track = (int)strtol(c + 1, &end, 10);
+            if (end == c + 1 || b[i].track < 0) break;
+            c = end;
+        }
+        if (*c != (i == k - 1 ? '\0' : ',')) break;
+        c++;
+        if (i % 2 == 0) {
+            p->service_time += b[i].length;
+        }
+        if (i == k - 1) {
+            p->burst_count = k;
+            p->bursts = b;
+            return 0;
+        }
+    }
+    free(b);
+    return 1;
+}
+
+/*
+ * һнϢPID ʱ ʱ [ȼ]
+ * ʱͻУ parse_bursts
+ * ֵ0=ɹ1=ʽEOF=
+ */
+int parse_process(const char* line, ProcessBase* p) {
+    char service[4096];
+    int used = 0;
+    int fields = sscanf(line, "%d %lld %4095s%n",
+        &p->pid, &p->arrival_time, service, &used);
+    if (fields == EOF) {
+        return EOF;
+    }
+    if (fields < 3) {
         return 1;
     }
+    if (sscanf(line + used, "%d", &p->priority) != 1) {
+        p->priority = 0;
+    }
+    return parse_bursts(service, p);
+}
 
-    printf("˳ÿ̵ϢPID ʱ ʱ\n");
-    printf("(: 1 0 5 ʾ PID=1, t=0 , Ҫ 5 ʱ䵥λ)\n");
+// ӱ׼һнϢУֵ0=ɹ1=ʽ-1=
+int read_process(ProcessBase* p) {
+    char line[4096];
+    for (;;) {
+        if (fgets(line, sizeof(line), stdin) == NULL) {
+            return -1;
+        }
+        int r = parse_process(line, p);
+        if (r != EOF) {
+            return r;
+        }
+        // Уһ scanf µĻУ
+    }
+}
 
+// 豸з˳Ѱʱ䣻base Ϊ NULLȲ֪Щ豸ʱ豸һ
+int read_device_config(SimConfig* cfg, const ProcessBase base[], int n) {
+    int used[MAX_DEVICES] = { 0 };
+    if (base == NULL) {
+        printf("豸ķ˳0=ȷ 1=ݣLOOK: ");
+        if (scanf("%d", &cfg->dev_sched[0]) != 1 ||
+            (cfg->dev_sched[0] != DEV_FCFS && cfg->dev_sched[0] != DEV_ELEVATOR)) {
+            printf("ѡǷ\n");
+            return 1;
+        }
+        for (int d = 1; d < MAX_DEVICES; ++d) {
+            cfg->dev_sched[d] = cfg->dev_sched[0];
+        }
+    }
     for (int i = 0; i < n; ++i) {
-        printf(" %d: ", i + 1);
-        if (scanf("%d %d %d",
-            &base[i].pid,
-            &base[i].arrival_time,
-            &base[i].service_time) != 3) {
+        for (int k = 1; k < base[i].burst_count; k += 2) {
+            used[base[i].bursts[k].device] = 1;
+        }
+    }
+    for (int d = 0; d < MAX_DEVICES; ++d) {
+        if (!used[d]) {
+            continue;
+        }
+        printf("豸 %d ķ˳0=ȷ 1=ݣLOOK: ", d);
+        if (scanf("%d", &cfg->dev_sched[d]) != 1 ||
+            (cfg->dev_sched[d] != DEV_FCFS && cfg->dev_sched[d] != DEV_ELEVATOR)) {
+            printf("ѡǷ\n");
+            return 1;
+        }
+    }
+    printf("ͷÿƶһŵѰʱ䣨0 ʾѰ: ");
+    if (scanf("%lld", &cfg->seek_cost) != 1 || cfg->seek_cost < 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    return 0;
+}
+
+// øĲҪȺĿ긺ػ㡣 0=ɹ
+int read_gen_config(GenConfig* gen) {
+    memset(gen, 0, sizeof(*gen));
+    printf("  : ");
+    if (scanf("%lld %llu", &gen->count, &gen->seed) != 2 ||
+        gen->count <= 0 || gen->count > INT_MAX) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    printf("̣0= 1=MMPP߷塢͹ֵʽ棩: ");
+    if (scanf("%d", &gen->arrival) != 1 || (gen->arrival != GEN_POISSON && gen->arrival != GEN_MMPP)) {
+        printf("ѡǷ\n");
+        return 1;
+    }
+    gen->burst_ratio = 1;
+    gen->mmpp_period = 1;
+    if (gen->arrival == GEN_MMPP) {
+        printf(" ߷͹ȵ֮ ÿ״̬ƽʱ: ");
+        if (scanf("%lf %lf", &gen->burst_ratio, &gen->mmpp_period) != 2 ||
+            gen->burst_ratio < 1 || gen->mmpp_period <= 0) {
+            printf("Ƿ\n");
+            return 1;
+        }
+    }
+    printf("ʱֲ0=ָ 1=Paretoβ 2=˫: ");
+    if (scanf("%d", &gen->service) != 1 || gen->service < GEN_EXP || gen->service > GEN_BIMODAL) {
+        printf("ѡǷ\n");
+        return 1;
+    }
+    printf("ƽʱ: ");
+    if (scanf("%lf", &gen->mean_service) != 1 || gen->mean_service <= 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    if (gen->service == GEN_PARETO) {
+        printf(" Pareto ״  > 1: ");
+        if (scanf("%lf", &gen->pareto_alpha) != 1 || gen->pareto_alpha <= 1) {
+            printf("Ƿ\n");
+            return 1;
+        }
+    }
+    else if (gen->service == GEN_BIMODAL) {
+        printf(" ҵ0~1 ҵҵķʱ֮: ");
+        if (scanf("%lf %lf", &gen->short_fraction, &gen->long_ratio) != 2 ||
+            gen->short_fraction <= 0 || gen->short_fraction > 1 || gen->long_ratio < 1) {
+            printf("Ƿ\n");
+            return 1;
+        }
+    }
+    printf("Ŀ긺 ѣ  ƽʱ /  0.8: ");
+    if (scanf("%lf", &gen->load) != 1 || gen->load <= 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    return 0;
+}
+
+// ʵʱ񼯣ÿһ ִʱ  [Խֹ] [0= 1=ż] 0=ɹ
+int read_task_set(TaskSet* ts) {
+    int sporadic = 0;
+    memset(ts, 0, sizeof(*ts));
+    printf("ʵʱ k: ");
+    if (scanf("%d", &ts->count) != 1 || ts->count <= 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    ts->tasks = (RtTask*)calloc((size_t)ts->count, sizeof(RtTask));
+    if (ts->tasks == NULL) {
+        printf("ڴ治\n");
+        return 1;
+    }
+    printf("˳ÿִʱ  [Խֹ] []\n");
+    printf("(Խֹʡʱڣ 0=Ĭϣ 1=żΪС)\n");
+    for (int i = 0; i < ts->count; ++i) {
+        RtTask* t = &ts->tasks[i];
+        char line[256];
+        int fields;
+        printf(" %d: ", i + 1);
+        do {
+            if (fgets(line, sizeof(line), stdin) == NULL) {
+                printf("\n");
+                return 1;
+            }
+            fields = sscanf(line, "%lld %lld %lld %d", &t->wcet, &t->period, &t->deadline, &t->sporadic);
+        } while (fields == EOF);    // һ scanf µĻ
+        if (fields < 2) {
             printf("\n");
             return 1;
         }
-        if (base[i].service_time <= 0) {
-            printf("ʱ > 0\n");
+        if (fields < 3) {
+            t->deadline = t->period;
+        }
+        if (t->wcet <= 0 || t->period <= 0 || t->deadline < t->wcet || t->deadline > t->period ||
+            t->sporadic < 0 || t->sporadic > 1) {
+            printf("ǷҪ 0 < ִʱ <= Խֹ <= \n");
+            return 1;
+        }
+        sporadic |= t->sporadic;
+    }
+    printf("ģʱڴ֮ǰͷҵ: ");
+    if (scanf("%lld", &ts->horizon) != 1 || ts->horizon <= 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    if (sporadic) {
+        printf(" ż񵽴 0.5 ʾ [T, 1.5T] : ");
+        if (scanf("%lf %llu", &ts->jitter, &ts->seed) != 2 || ts->jitter < 0) {
+            printf("Ƿ\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 뿪ã 0=ɹ
+int read_sim_config(SimConfig* cfg, int* compare_designs) {
+    *cfg = DEFAULT_CONFIG;
+    *compare_designs = 0;
+
+    printf(" CPU 1 = ˣ: ");
+    if (scanf("%d", &cfg->ncpu) != 1 || cfg->ncpu <= 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    if (cfg->ncpu > 1) {
+        int design;
+        printf("֯0=ȫֹ 1=ÿ˶+ȡ 2=Ա: ");
+        if (scanf("%d", &design) != 1 || design < 0 || design > 2) {
+            printf("ѡǷ\n");
+            return 1;
+        }
+        cfg->per_cpu_queues = design == 1;
+        *compare_designs = design == 2;
+
+        printf(" Ǩƿ ؾڣ0 ʾģ/: ");
+        if (scanf("%lld %lld", &cfg->migration_cost, &cfg->rebalance_period) != 2 ||
+            cfg->migration_cost < 0 || cfg->rebalance_period < 0) {
+            printf("Ƿ\n");
+            return 1;
+        }
+    }
+
+    printf(" л ؿ 汣´ڣ0 ʾģ: ");
+    if (scanf("%lld %lld %lld", &cfg->switch_cost, &cfg->cache_penalty,
+        &cfg->cache_hot_window) != 3 ||
+        cfg->switch_cost < 0 || cfg->cache_penalty < 0 || cfg->cache_hot_window < 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+
+    printf("ͳƴڿȣ0 ʾͳƣ: ");
+    if (scanf("%lld", &cfg->window) != 1 || cfg->window < 0) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* ---------------- ʽģʽ߶ģ ---------------- */
+
+typedef struct {
+    long long lines;        // Ѷʱָλ
+    int header_done;
+    long long last_arrival; // һ̵ĵʱˮλ˳
+} StreamSource;
+
+// ÿһ̣ʽֹͬ룩 "@ ʱ" ʾʱ֮ǰн̵
+static int stream_next(ProcessSource* self, ProcessBase* out) {
+    StreamSource* ss = (StreamSource*)self->state;
+    char line[4096];
+    for (;;) {
+        if (fgets(line, sizeof(line), stdin) == NULL) {
+            return 0;
+        }
+        ss->lines++;
+        memset(out, 0, sizeof(*out));
+        const char* at = line + strspn(line, " \t");
+        if (*at == '@') {
+            if (sscanf(at + 1, "%lld", &out->arrival_time) != 1) {
+                printf(" %lld Уˮλʽ\n", ss->lines);
+                return -1;
+            }
+            if (out->arrival_time < ss->last_arrival) {
+                printf("ʱ %lld ֮ǰ %lldԴ밴ʱ\n",
+                    out->arrival_time, ss->last_arrival);
+                return -1;
+            }
+            ss->last_arrival = out->arrival_time;
+            return SOURCE_WATERMARK;
+        }
+        int r = parse_process(line, out);
+        if (r == EOF) {
+            continue;
+        }
+        if (r != 0 || out->arrival_time < 0 || out->service_time <= 0) {
+            printf(" %lld У\n", ss->lines);
+            free(out->bursts);
+            return -1;
+        }
+        if (out->arrival_time < ss->last_arrival) {
+            printf("ʱ %lld ֮ǰ %lldԴ밴ʱ\n",
+                out->arrival_time, ss->last_arrival);
+            free(out->bursts);
+            return -1;
+        }
+        ss->last_arrival = out->arrival_time;
+        return 1;
+    }
+}
+
+// һɾһм¼ˢͻ漴ͷ
+static void stream_complete(ProcessSource* self, long long seq, const ProcessBase* p,
+    const ProcessRun* r) {
+    StreamSource* ss = (StreamSource*)self->state;
+    double t = (double)(r->finish_time - p->arrival_time);
+    (void)seq;
+    if (!ss->header_done) {
+        printf("PID\t\t\tȼ\tʼ\t\tת\tȨת\n");
+        ss->header_done = 1;
+    }
+    printf("%d\t%lld\t%lld\t%d\t%lld\t%lld\t%.1f\t%.2f\n",
+        p->pid, p->arrival_time, p->service_time, p->priority,
+        r->start_time, r->finish_time, t, t / p->service_time);
+    fflush(stdout);
+    free(p->bursts);
+}
+
+/*
+ * ʽģʽȶԺãٴӱ׼жֱ EOF
+ * ڴֻϵͳеĽйأԽʵʱҵĳùܵ
+ */
+int run_online(void) {
+    int policy_id, tq, compare_designs;
+    SimConfig cfg;
+
+    printf("\nѡȲԣ\n");
+    for (int id = 0; id < POLICY_COUNT; ++id) {
+        printf("%d. %s\n", id + 1, policy_name(id));
+    }
+    printf("ѡ");
+    if (scanf("%d", &policy_id) != 1 || policy_id < 1 || policy_id > POLICY_COUNT) {
+        printf("ѡǷ\n");
+        return 1;
+    }
+    if (read_sim_config(&cfg, &compare_designs) != 0) {
+        return 1;
+    }
+    if (compare_designs) {
+        printf("ģʽֻѡһ־֯\n");
+        return 1;
+    }
+    if (read_device_config(&cfg, NULL, 0) != 0) {
+        return 1;
+    }
+    printf("ʱƬС: ");
+    if (scanf("%d", &tq) != 1 || tq <= 0) {
+        printf("ʱƬΪ\n");
+        return 1;
+    }
+    printf("ʼ뵽ÿ PID ʱ ʱ [ȼ]ʱ\n");
+    printf("\"@ ʱ\" ʾʱ֮ǰн̵EOF\n");
+
+    StreamSource ss = { 0, 0, LLONG_MIN };
+    ProcessSource src = { stream_next, stream_complete, NULL, &ss };
+    Workload w = { NULL, 0, NULL, NULL, &src };
+    return simulate_policy(&w, policy_id - 1, tq, &cfg);
+}
+
+// ͷֹĽ̺ʵʱ
+static void free_inputs(ProcessBase base[], int n, TaskSet* ts) {
+    free_processes(base, n);
+    free(ts->tasks);
+}
+
+static int run(void) {
+    int n;
+    GenConfig gen;
+    TaskSet ts;
+
+    printf(" n 0 ʹø-1 ʵʱ񼯣-2 ʽģʽ: ");
+    if (scanf("%d", &n) != 1 || n < -2) {
+        printf("Ƿ\n");
+        return 1;
+    }
+    if (n == -2) {
+        return run_online();
+    }
+    if (n == 0 && read_gen_config(&gen) != 0) {
+        return 1;
+    }
+    if (n == -1) {
+        int error = read_task_set(&ts);
+        if (!error) {
+            analyze_task_set(&ts);
+        }
+        else {
+            free(ts.tasks);
+            return 1;
+        }
+        n = 0;
+    }
+    else {
+        ts.tasks = NULL;
+    }
+
+    ProcessBase* base = NULL;
+    if (n > 0) {
+        base = (ProcessBase*)calloc((size_t)n, sizeof(ProcessBase));
+        if (base == NULL) {
+            printf("ڴ治\n");
+            return 1;
+        }
+        printf("˳ÿ̵ϢPID ʱ ʱ [ȼ]\n");
+        printf("(: 1 0 5 ʾ PID=1, t=0 , Ҫ 5 ʱ䵥λȼʡʱΪ 0)\n");
+        printf("(ʱҲд CPU/I-O ͻУ 5,d0:3,4,d1:2@120,1\n");
+        printf(" d0:3 ʾ豸 0  3 ʱ䵥λ I/O@120 Ϊŵ)\n");
+
+        for (int i = 0; i < n; ++i) {
+            if (n <= PRINT_LIMIT) {
+                printf(" %d: ", i + 1);
+            }
+            if (read_process(&base[i]) != 0) {
+                printf("\n");
+                free_inputs(base, n, &ts);
+                return 1;
+            }
+            if (base[i].arrival_time < 0) {
+                printf("ʱ >= 0\n");
+                free_inputs(base, n, &ts);
+                return 1;
+            }
+            if (base[i].service_time <= 0) {
+                printf("ʱ > 0\n");
+                free_inputs(base, n, &ts);
+                return 1;
+            }
+        }
+
+        // ΪӦԡûаʱ롱ﰴʱ
+        if (sort_by_arrival(base, n) != 0) {
+            printf("ڴ治\n");
+            free_inputs(base, n, &ts);
             return 1;
         }
     }
 
-    // ΪӦԡûаʱ롱ﰴʱ
-    sort_by_arrival(base, n);
+    int policy_id;
+    printf("\nѡȲԣ\n");
+    for (int id = 0; id < POLICY_COUNT; ++id) {
+        printf("%d. %s\n", id + 1, policy_name(id));
+    }
+    printf("0. ȫԶԱ\n");
+    printf("ѡ");
+    if (scanf("%d", &policy_id) != 1 || policy_id < 0 || policy_id > POLICY_COUNT) {
+        printf("ѡǷ\n");
+        free_inputs(base, n, &ts);
+        return 1;
+    }
+
+    SimConfig cfg;
+    int compare_designs;
+    if (read_sim_config(&cfg, &compare_designs) != 0 ||
+        (has_io(base, n) && read_device_config(&cfg, base, n) != 0)) {
+        free_inputs(base, n, &ts);
+        return 1;
+    }
+    // ĵʰĺ㣬Աʱֲ
+    Workload w = { base, n, &gen, ts.tasks != NULL ? &ts : NULL, NULL };
+    if (n == 0 && w.tasks == NULL) {
+        gen.rate = gen.load * cfg.ncpu / gen.mean_service;
+    }
 
     int m;
     printf("\n׼ԲͬʱƬС\n");
-    printf("ҪԵʱƬ m: ");
-    if (scanf("%d", &m) != 1 || m <= 0) {
+    printf("ҪԵʱƬ m 0 ʾԶʱƬ: ");
+    if (scanf("%d", &m) != 1 || m < 0) {
         printf("m Ƿ\n");
+        free_inputs(base, n, &ts);
         return 1;
     }
 
+    if (m == 0) {
+        int qmin, qmax, objective;
+        printf("Χ СʱƬ ʱƬ: ");
+        if (scanf("%d %d", &qmin, &qmax) != 2 || qmin <= 0 || qmax < qmin) {
+            printf("ΧǷ\n");
+            free_inputs(base, n, &ts);
+            return 1;
+        }
+        printf("ŻĿ꣺1=ƽתʱ 2=P99 תʱ: ");
+        if (scanf("%d", &objective) != 1 || objective < 1 || objective > 2) {
+            printf("ĿǷ\n");
+            free_inputs(base, n, &ts);
+            return 1;
+        }
+        int error = 0;
+        for (int id = 0; id < POLICY_COUNT && !error; ++id) {
+            if (policy_id == 0 || id == policy_id - 1) {
+                error = search_quantum(&w, id, &cfg, qmin, qmax, objective == 2);
+            }
+        }
+        free_inputs(base, n, &ts);
+        return error;
+    }
+
     for (int i = 0; i < m; ++i) {
         int tq;
         printf(" %d ʱƬС: ", i + 1);
         if (scanf("%d", &tq) != 1 || tq <= 0) {
             printf("ʱƬΪ\n");
+            free_inputs(base, n, &ts);
+            return 1;
+        }
+        int error = 0;
+        if (compare_designs) {
+            for (int id = 0; id < POLICY_COUNT && !error; ++id) {
+                if (policy_id == 0 || id == policy_id - 1) {
+                    error = compare_smp(&w, id, tq, &cfg);
+                }
+            }
+        }
+        else if (policy_id == 0) {
+            error = compare_policies(&w, tq, &cfg);
+        }
+        else {
+            error = simulate_policy(&w, policy_id - 1, tq, &cfg);
+        }
+        if (error) {
+            free_inputs(base, n, &ts);
             return 1;
         }
-        simulate_rr(base, n, tq);
     }
 
+    free_inputs(base, n, &ts);
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        tracer = tr_open(argv[1], 1 << 16);
+        trace_ring = tracer != NULL ? tr_ring(tracer) : NULL;
+        if (trace_ring == NULL) {
+            printf("޷ļ %s\n", argv[1]);
+            return 1;
+        }
+    }
+    int ret = run();
+    if (tracer != NULL) {
+        TrStats ts;
+        if (tr_close(tracer, &ts) != 0) {
+            printf("\nдļ %s \n", argv[1]);
+            return 1;
+        }
+        printf("\nʱд %s%lld ¼ȴ %lld Σ chrome://tracing  ui.perfetto.dev 򿪣\n",
+            argv[1], ts.events, ts.stalls);
+    }
+    return ret;
+}
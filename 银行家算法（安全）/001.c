@@ -1,15 +1,41 @@
+/*
+ * м㷨ģ
+ * ȫԼ顢ȴС롢Ϳģ banker.c ɣ
+ * ֻܲԡٵĻطɣԼõ̳߳ء
+ * 룺gcc -O2 -pthread -I ../ģ 001.c ../ģ/banker.c -o banker
+ */
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include "banker.h"
 
-#define MAX_P 10      // 
-#define MAX_R 10      // Դ
+#define PRINT_LIMIT 20    // Դʱӡ
 
-// ȫݽṹ
 int n, m;                                 // n ̣m Դ
-int Available[MAX_R];                     // Դ
-int Max[MAX_P][MAX_R];                    // 
-int Allocation[MAX_P][MAX_R];             // ѷ
-int Need[MAX_P][MAX_R];                   // 
+Banker* bk;                               // ģʽµ
+
+static const char* const SIMD_NAMES[] = { "", "AVX2", "AVX-512" };
+
+static double nowSec() {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
 
 // ӡǰϵͳ״̬
 void printSystemState() {
@@ -18,10 +44,15 @@ void printSystemState() {
     printf("\n========== ǰϵͳ״̬ ==========\n");
 
     printf(" n = %d, Դ m = %d\n", n, m);
+    if (n > PRINT_LIMIT || m > PRINT_LIMIT) {
+        printf("ģ %dʡԾ\n", PRINT_LIMIT);
+        printf("==================================\n\n");
+        return;
+    }
 
     printf("\nAvailableԴ\n");
     for (j = 0; j < m; j++) {
-        printf("R%d:%d  ", j, Available[j]);
+        printf("R%d:%d  ", j, bk_available(bk, j));
     }
     printf("\n");
 
@@ -29,7 +60,7 @@ void printSystemState() {
     for (i = 0; i < n; i++) {
         printf("P%d: ", i);
         for (j = 0; j < m; j++) {
-            printf("%3d ", Max[i][j]);
+            printf("%3d ", bk_max(bk, i, j));
         }
         printf("\n");
     }
@@ -38,7 +69,7 @@ void printSystemState() {
     for (i = 0; i < n; i++) {
         printf("P%d: ", i);
         for (j = 0; j < m; j++) {
-            printf("%3d ", Allocation[i][j]);
+            printf("%3d ", bk_allocation(bk, i, j));
         }
         printf("\n");
     }
@@ -47,7 +78,7 @@ void printSystemState() {
     for (i = 0; i < n; i++) {
         printf("P%d: ", i);
         for (j = 0; j < m; j++) {
-            printf("%3d ", Need[i][j]);
+            printf("%3d ", bk_need(bk, i, j));
         }
         printf("\n");
     }
@@ -55,86 +86,151 @@ void printSystemState() {
     printf("==================================\n\n");
 }
 
-// ¼ Need = Max - Allocation
-void calculateNeed() {
-    int i, j;
-    for (i = 0; i < n; i++) {
-        for (j = 0; j < m; j++) {
-            Need[i][j] = Max[i][j] - Allocation[i][j];
-        }
+// ӡȫУ̺ܶʱֻӡͷһΣ
+void printSafeSeq(const int safeSeq[]) {
+    int k;
+    printf("һְȫΪ");
+    for (k = 0; k < n && k < PRINT_LIMIT; k++) {
+        printf("P%d", safeSeq[k]);
+        if (k != n - 1) printf(" -> ");
     }
+    if (n > PRINT_LIMIT) {
+        printf("... %d ̣", n);
+    }
+    printf("\n\n");
 }
 
-/*
- * ȫԼ飺жϵǰϵͳ״̬Ƿȫ
- * safeSeq[]ȫһȫ
- * ֵ1 = ȫ0 = ȫ
- */
-int isSafe(int safeSeq[]) {
-    int work[MAX_R];
-    int finish[MAX_P];
-    int i, j, count = 0;
+/* ---------------- 롢롢ͷšȴ ---------------- */
 
-    // ʼ
+// Ľ BK_* 
+static const char* const RESULT_NAMES[] = { "׼", "ݻ", "ݻ", "ܾ", "ڴ治" };
+
+// ȴ󱻻Ѻ뿪ʱӡ
+static void onBankerEvent(void* user, const BkEvent* ev) {
+    (void)user;
+    if (ev->type == BK_EV_WAKE) {
+        printf("ȴе #%lldP%d%s\n", ev->ticket, ev->pid,
+            ev->result == BK_GRANTED ? "÷" : "ѳʣ󣬳");
+    }
+}
+
+// ӡȴУܶʱֻӡͷһΣ
+void printWaitQueue() {
+    BkWaiter shown[PRINT_LIMIT];
+    int count = bk_waiters(bk, shown, PRINT_LIMIT), k, j;
+    printf("\nȴУ %d \n", bk_pending(bk));
+    for (k = 0; k < count; k++) {
+        printf("#%lld P%d  (", shown[k].ticket, shown[k].pid);
+        for (j = 0; j < m && j < PRINT_LIMIT; j++) {
+            printf(j ? " %d" : "%d", shown[k].vec[j]);
+        }
+        printf(m > PRINT_LIMIT ? " ...)" : ")");
+        if (shown[k].missing > 0) printf("  ȴ %d Դ\n", shown[k].missing);
+        else printf("  ȴ״̬䰲ȫ\n");
+    }
+    printf("\n");
+}
+
+// ͷһԴ
+void handleRelease() {
+    int p, j;
+    int* vec;
+    printf("ͷԴĽ̺ p0 ~ %d", n - 1);
+    if (scanf("%d", &p) != 1 || p < 0 || p >= n) {
+        printf("̺ŷǷ\n");
+        return;
+    }
+    vec = (int*)calloc((size_t)m, sizeof(int));
+    if (vec == NULL) {
+        printf("ڴ治㡣\n");
+        return;
+    }
+    printf(" P%d ͷŵԴ %d Դ\n", p, m);
     for (j = 0; j < m; j++) {
-        work[j] = Available[j];   //  work = Available
+        printf("Release[%d] = ", j);
+        scanf("%d", &vec[j]);
     }
-    for (i = 0; i < n; i++) {
-        finish[i] = 0;            // н̳ʼδ
+    if (bk_release(bk, p, vec) != 0) {
+        printf("ͷŷǷ̵ܳǰѷ\n\n");
+    }
+    else {
+        printf("P%d ͷԴȴʣ %d \n", p, bk_pending(bk));
+        printSystemState();
     }
+    free(vec);
+}
 
-    // ҵһȫ
-    while (count < n) {
-        int found = 0;
+// ̽
+void handleExit() {
+    int p;
+    printf("Ľ̺ p0 ~ %d", n - 1);
+    if (scanf("%d", &p) != 1 || p < 0 || p >= n) {
+        printf("̺ŷǷ\n");
+        return;
+    }
+    if (bk_exit(bk, p) != 0) {
+        printf("ڴ治㡣\n");
+        return;
+    }
+    printf("P%d ѽ黹ȫԴȴʣ %d \n", p, bk_pending(bk));
+    printSystemState();
+}
 
-        // Ѱһ㣺Finish[i] == 0  Need[i] <= work Ľ
-        for (i = 0; i < n; i++) {
-            if (finish[i] == 0) {
-                int canFinish = 1;
-                for (j = 0; j < m; j++) {
-                    if (Need[i][j] > work[j]) {
-                        canFinish = 0;
-                        break;
-                    }
-                }
+// һݻȴ
+void handleBatch() {
+    BkBatchItem* items;
+    int* vecs;
+    int count, i, j, granted, checks, tally[5] = { 0 };
 
-                if (canFinish) {
-                    // ٶ i ִ겢ͷԴ
-                    for (j = 0; j < m; j++) {
-                        work[j] += Allocation[i][j];
-                    }
-                    finish[i] = 1;
-                    safeSeq[count] = i;
-                    count++;
-                    found = 1;
-                }
-            }
+    printf("һ");
+    if (scanf("%d", &count) != 1 || count <= 0) {
+        printf("Ƿ\n");
+        return;
+    }
+    items = (BkBatchItem*)calloc((size_t)count, sizeof(BkBatchItem));
+    vecs = (int*)calloc((size_t)count * m, sizeof(int));
+    if (items == NULL || vecs == NULL) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+    for (i = 0; i < count; i++) {
+        items[i].vec = vecs + (size_t)i * m;
+        printf(" %d 󣺽̺ p0 ~ %d %d Դ", i + 1, n - 1, m);
+        if (scanf("%d", &items[i].pid) != 1 || items[i].pid < 0 || items[i].pid >= n) {
+            printf("̺ŷǷ\n");
+            goto done;
         }
-
-        // һûҵκοɵḶ̌˵ϵͳȫ
-        if (!found) {
-            break;
+        for (j = 0; j < m; j++) {
+            scanf("%d", &vecs[(size_t)i * m + j]);
         }
     }
 
-    // Ƿн̶
-    for (i = 0; i < n; i++) {
-        if (finish[i] == 0) {
-            return 0;   // ޷ɵḶ̌ϵͳȫ
+    granted = bk_admit_batch(bk, items, count, 1, &checks);
+    for (i = 0; i < count; i++) {
+        tally[items[i].result]++;
+        if (i < PRINT_LIMIT) {
+            printf(" %dP%d%s\n", i + 1, items[i].pid, RESULT_NAMES[items[i].result]);
         }
     }
+    printf(" %d ׼ %d ݻ %d ѼȴУܾ %d ȫԼ %d Ρ\n\n",
+        count, granted, tally[BK_WAIT] + tally[BK_UNSAFE], tally[BK_INVALID], checks);
+    printSystemState();
 
-    return 1;           // н̾ɣϵͳȫ
+done:
+    free(items);
+    free(vecs);
 }
 
 /*
  * һԴ Request
- * ̺ p m  Request 
+ * ̺ p m  Request ȴ
  */
 void handleRequest() {
     int p;
-    int Request[MAX_R];
+    int* Request;
+    int* safeSeq;
     int i;
+    long long ticket;
 
     printf("뷢Ľ̺ p0 ~ %d븺򣩣", n - 1);
     scanf("%d", &p);
@@ -148,94 +244,1489 @@ void handleRequest() {
         return;
     }
 
+    Request = (int*)malloc((size_t)m * sizeof(int));
+    safeSeq = (int*)malloc((size_t)n * sizeof(int));
+    if (Request == NULL || safeSeq == NULL) {
+        printf("ڴ治㡣\n");
+        free(Request);
+        free(safeSeq);
+        return;
+    }
+
     printf(" P%d  Request %d Դ\n", p, m);
     for (i = 0; i < m; i++) {
         printf("Request[%d] = ", i);
         scanf("%d", &Request[i]);
     }
 
-    // 1)  Request <= Need
-    for (i = 0; i < m; i++) {
-        if (Request[i] > Need[p][i]) {
+    //  Request <= NeedRequest <= AvailableԷȫԼ飬
+    switch (bk_submit(bk, p, Request, &ticket)) {
+    case BK_INVALID:
+        for (i = 0; i < m && Request[i] >= 0 && Request[i] <= bk_need(bk, p, i); i++) {
+        }
+        if (i < m && Request[i] >= 0) {
             printf("ǷRequest[%d] = %d > Need[P%d][%d] = %d\n",
-                i, Request[i], p, i, Need[p][i]);
+                i, Request[i], p, i, bk_need(bk, p, i));
             printf("ԭ򣺽ԴʣֱӾܾ\n\n");
-            return;
         }
+        else {
+            printf("ǷRequest[%d] = %d ΪֱӾܾ\n\n", i, Request[i]);
+        }
+        break;
+    case BK_WAIT:
+        for (i = 0; i < m && Request[i] <= bk_available(bk, i); i++) {
+        }
+        printf("ʱ㣺Request[%d] = %d > Available[%d] = %d\n",
+            i, Request[i], i, bk_available(bk, i));
+        printf("ԭϵͳǰԴ㣬ݲ䡣\n");
+        if (ticket >= 0) {
+            printf("ѼȴУԴͷʱټ顣\n");
+        }
+        printf("\n");
+        break;
+    case BK_GRANTED:
+        printf("Ϸģ׶...\n");
+        printf("ϵͳڰȫ״̬Ա㡣\n");
+        bk_is_safe(bk, safeSeq);
+        printSafeSeq(safeSeq);
+        printSystemState();
+        break;
+    case BK_UNSAFE:
+        printf("Ϸģ׶...\n");
+        printf("棺Դϵͳ벻ȫ״̬󱻾ܾ\n");
+        printf("ϵͳ״̬ѻعǰ\n");
+        printSystemState();
+        if (ticket >= 0) {
+            printf("ѼȴУԴͷźټ顣\n\n");
+        }
+        break;
+    default:
+        printf("ڴ治㡣\n");
+        break;
     }
+    free(Request);
+    free(safeSeq);
+}
 
-    // 2)  Request <= Available
-    for (i = 0; i < m; i++) {
-        if (Request[i] > Available[i]) {
-            printf("ʱ㣺Request[%d] = %d > Available[%d] = %d\n",
-                i, Request[i], i, Available[i]);
-            printf("ԭϵͳǰԴ㣬ݲ䡣\n\n");
-            return;
+/* ---------------- ģܲ ---------------- */
+
+static unsigned long long rngState;
+
+// splitmix64ͬһӽɸ
+static unsigned int nextRandom() {
+    unsigned long long z = (rngState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+static int compareInt(const void* x, const void* y) {
+    int a = *(const int*)x, b = *(const int*)y;
+    return a < b ? -1 : a > b;
+}
+
+/*
+ * һȫ״̬д avail[m] Ͱдŵ maxallocn  m
+ * Max  [0, maxDemand] Allocation  [0, Max] 
+ * ȡһ˳򣬰 Available ǡ˳ͨСֵ
+ * chain = 1 ʱɨһԴϰ P(n-1), P(n-2), ..., P0 ֻһ̣
+ * ÿɨֻҵһ̣ÿ̶ҪȵһԴʧܡ 0 = ɹ
+ */
+int randomSafeState(unsigned long long seed, int maxDemand, int chain, int* avail, int* max, int* alloc) {
+    int* perm = (int*)malloc((size_t)n * sizeof(int));
+    int* released = (int*)calloc((size_t)m, sizeof(int));
+    int i, j, k;
+    if (perm == NULL || released == NULL) {
+        free(perm);
+        free(released);
+        return 1;
+    }
+    rngState = seed;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < m; j++) {
+            max[(size_t)i * m + j] = (int)(nextRandom() % (unsigned int)(maxDemand + 1));
+            alloc[(size_t)i * m + j] = (int)(nextRandom() % (unsigned int)(max[(size_t)i * m + j] + 1));
+        }
+        perm[i] = i;
+    }
+    for (i = n - 1; i > 0; i--) {
+        k = (int)(nextRandom() % (unsigned int)(i + 1));
+        j = perm[i];
+        perm[i] = perm[k];
+        perm[k] = j;
+    }
+    if (chain) {
+        for (k = 0; k < n; k++) {
+            int* maxRow = max + (size_t)(n - 1 - k) * m;
+            int* allocRow = alloc + (size_t)(n - 1 - k) * m;
+            perm[k] = n - 1 - k;
+            allocRow[m - 1] = 1;
+            maxRow[m - 1] = k + 1;    // ŵ k ĽǡҪǰ k ͷ
+            for (j = 0; j < m - 1; j++) {
+                allocRow[j] = maxRow[j];
+            }
+        }
+    }
+
+    // released ǡǰĽͷŵAvailable[j] ȡ max(Need - ͷ)
+    for (j = 0; j < m; j++) {
+        avail[j] = 0;
+    }
+    for (k = 0; k < n; k++) {
+        i = perm[k];
+        for (j = 0; j < m; j++) {
+            int need = max[(size_t)i * m + j] - alloc[(size_t)i * m + j];
+            if (need - released[j] > avail[j]) {
+                avail[j] = need - released[j];
+            }
+            released[j] += alloc[(size_t)i * m + j];
         }
     }
+    free(perm);
+    free(released);
+    return 0;
+}
 
-    // 3) ģ䣺޸ AvailableAllocationNeed
-    printf("Ϸģ׶...\n");
+/*
+ * ˵΢׼ÿһõĺˣбȽ Need[i] <= workwork ȡֵ֤ȵβ
+ * ۼ work += Allocation[i] ٶ
+ */
+void benchmarkKernels(const int* max, const int* alloc) {
+    int level, maxLevel = bk_simd_level(), padded = bk_padded(m);
+    int i, j, rows, rounds, ok = 0;
+    double t0, tCompare, tAdd;
+    BkKernels k;
+    int* big = bk_new_vector(m);
+    int* work = bk_new_vector(m);
+    int* needRows;
+    int* allocRows;
 
-    for (i = 0; i < m; i++) {
-        Available[i] -= Request[i];
-        Allocation[p][i] += Request[i];
-        Need[p][i] -= Request[i];
+    rows = n < 4096 ? n : 4096;   // ̶ɨǰ rows У L2 ʱڴ
+    needRows = bk_new_vector(rows * padded);
+    allocRows = bk_new_vector(rows * padded);
+    if (big == NULL || work == NULL || needRows == NULL || allocRows == NULL) {
+        goto done;
+    }
+    for (j = 0; j < m; j++) {
+        big[j] = INT_MAX;
+    }
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < m; j++) {
+            needRows[(size_t)i * padded + j] = max[(size_t)i * m + j] - alloc[(size_t)i * m + j];
+            allocRows[(size_t)i * padded + j] = alloc[(size_t)i * m + j];
+        }
     }
+    printf("\nˣÿ %d  int뵽 %d\n", m, padded);
+    for (level = 0; level <= maxLevel; level++) {
+        bk_kernels(level, &k);
+        rounds = 0;
+        t0 = nowSec();
+        do {
+            for (i = 0; i < rows; i++) {
+                ok += k.less_equal(needRows + (size_t)i * padded, big, padded);
+            }
+            rounds++;
+        } while (nowSec() - t0 < 0.1);
+        tCompare = (nowSec() - t0) / ((double)rounds * rows);
 
-    // 4) ģϵͳ״̬Ƿȫ
-    int safeSeq[MAX_P];
-    if (isSafe(safeSeq)) {
-        int k;
-        printf("ϵͳڰȫ״̬Ա㡣\n");
-        printf("һְȫΪ");
-        for (k = 0; k < n; k++) {
-            printf("P%d", safeSeq[k]);
-            if (k != n - 1) printf(" -> ");
+        memset(work, 0, (size_t)padded * sizeof(int));
+        rounds = 0;
+        t0 = nowSec();
+        do {
+            for (i = 0; i < rows; i++) {
+                k.add(work, allocRows + (size_t)i * padded, padded);
+            }
+            rounds++;
+        } while (nowSec() - t0 < 0.1);
+        tAdd = (nowSec() - t0) / ((double)rounds * rows);
+
+        printf("%-8s Ƚ %8.1f ns/У%5.2f G Ԫ/s  ۼ %8.1f ns/У%5.2f G Ԫ/s\n",
+            SIMD_NAMES[level], tCompare * 1e9, m / tCompare / 1e9, tAdd * 1e9, m / tAdd / 1e9);
+    }
+    if (ok < 0) printf("%d\n", ok);   // ֹȽϱŻ
+
+done:
+    bk_free_vector(big);
+    bk_free_vector(work);
+    bk_free_vector(needRows);
+    bk_free_vector(allocRows);
+}
+
+/*
+ *  availmaxalloc ״̬Ͻһ棬Դٶ headroom 
+ * ȫ״̬ Available ǸպùõСֵκԲͻʱȼ
+ */
+static Banker* createWithHeadroom(const int* avail, const int* max, const int* alloc, int headroom) {
+    int* extra = (int*)malloc((size_t)m * sizeof(int));
+    Banker* b = NULL;
+    int j;
+    if (extra != NULL) {
+        for (j = 0; j < m; j++) {
+            extra[j] = avail[j] + headroom;
         }
-        printf("\n\n");
+        b = bk_create(n, m, extra, max, alloc);
+    }
+    free(extra);
+    return b;
+}
 
-        printSystemState();
+// һ̺ͼԴÿҪ 1 ~ 2  Needд vec[m]ؽ̺
+static int smallRequest(Banker* b, int* vec) {
+    int p = (int)(nextRandom() % (unsigned int)n), j, k;
+    for (k = 0; k < 4; k++) {
+        j = (int)(nextRandom() % (unsigned int)m);
+        vec[j] = 1 + (int)(nextRandom() % 2);
+        if (vec[j] > bk_need(b, p, j)) {
+            vec[j] = bk_need(b, p, j);
+        }
+    }
+    return p;
+}
+
+/*
+ * Ķգͬһ bk_requestԷ + ȫԼ + ȫͻع
+ *  bk_admit_batch һΣ֮׼黹״̬ԭ
+ */
+void benchmarkBatch(int count, const int* avail, const int* max, const int* alloc) {
+    BkBatchItem* items = (BkBatchItem*)calloc((size_t)count, sizeof(BkBatchItem));
+    int* vecs = (int*)calloc((size_t)count * m, sizeof(int));
+    int i, granted = 0, checks, batchGranted, headroom = 1 + 3 * count / m;
+    double t0, tSeq, tBatch;
+    Banker* b = createWithHeadroom(avail, max, alloc, headroom);
+
+    if (items == NULL || vecs == NULL || b == NULL) {
+        goto done;
+    }
+    for (i = 0; i < count; i++) {
+        items[i].vec = vecs + (size_t)i * m;
+        items[i].pid = smallRequest(b, vecs + (size_t)i * m);
+    }
+
+    // ÿͨǰҪһİȫԼ
+    t0 = nowSec();
+    for (i = 0; i < count; i++) {
+        items[i].result = bk_request(b, items[i].pid, items[i].vec);
+        granted += items[i].result == BK_GRANTED;
+    }
+    tSeq = nowSec() - t0;
+    for (i = count - 1; i >= 0; i--) {
+        if (items[i].result == BK_GRANTED) bk_release(b, items[i].pid, items[i].vec);
+    }
+
+    t0 = nowSec();
+    batchGranted = bk_admit_batch(b, items, count, 0, &checks);
+    tBatch = nowSec() - t0;
+
+    printf("\n%d ÿԴ %d\n", count, headroom);
+    printf("׼ %d %.2f ms%.0f /s\n", granted, tSeq * 1e3, count / tSeq);
+    printf("׼ %d ȫԼ %d Σ%.2f ms%.0f /s\n",
+        batchGranted, checks, tBatch * 1e3, count / tBatch);
+
+done:
+    bk_destroy(b);
+    free(items);
+    free(vecs);
+}
+
+/*
+ * ȴеĻѿȰ count Ϊһ bk_admit_batch˵ڶ
+ * ýͷ 1 Դͳÿͷ¼˶ٸȴ
+ * ûаԴʱÿͷŶҪزһ
+ */
+void benchmarkWakeup(int count, int releases, const int* avail, const int* max, const int* alloc) {
+    BkBatchItem* items = (BkBatchItem*)calloc((size_t)count, sizeof(BkBatchItem));
+    int* vecs = (int*)calloc((size_t)count * m, sizeof(int));
+    int* vec = (int*)calloc((size_t)m, sizeof(int));
+    int i, j, p, done = 0, granted = 0, initial, checks;
+    int headroom = 1 + 3 * count / m;    // ͬ benchmarkBatchһҵڶ
+    long long checksBefore, pendingSum = 0;
+    double t0, t;
+    BkStats st;
+    Banker* b = createWithHeadroom(avail, max, alloc, headroom);
+
+    if (items == NULL || vecs == NULL || vec == NULL || b == NULL) {
+        goto done;
+    }
+    for (i = 0; i < count; i++) {
+        items[i].vec = vecs + (size_t)i * m;
+        items[i].pid = smallRequest(b, vecs + (size_t)i * m);
+    }
+    initial = bk_admit_batch(b, items, count, 1, &checks);
+
+    bk_get_stats(b, &st);
+    checksBefore = st.wake_checks;
+    t0 = nowSec();
+    while (done < releases && bk_pending(b) > 0) {
+        p = (int)(nextRandom() % (unsigned int)n);
+        j = (int)(nextRandom() % (unsigned int)m);
+        if (bk_allocation(b, p, j) == 0) continue;
+        memset(vec, 0, (size_t)m * sizeof(int));
+        vec[j] = 1;
+        pendingSum += bk_pending(b);
+        granted -= bk_pending(b);
+        bk_release(b, p, vec);
+        granted += bk_pending(b);
+        done++;
+    }
+    t = nowSec() - t0;
+    bk_get_stats(b, &st);
+
+    printf("\nȴУ%d 󣬵׼ %d \n", count, initial);
+    if (done > 0) {
+        printf("%d ͷţƽÿ¼ %.2f ȴ󣨶ƽ %.0f Ѻ׼ %d %.1f us/\n",
+            done, (double)(st.wake_checks - checksBefore) / done, (double)pendingSum / done, -granted, t / done * 1e6);
+    }
+
+done:
+    bk_destroy(b);
+    free(items);
+    free(vecs);
+    free(vec);
+}
+
+// ȫ״̬϶Ա bk_is_safeȫԼԭɨ
+void benchmarkSafety() {
+    unsigned long long seed;
+    int chain;
+    int* safeSeq;
+    int* avail;
+    int* max;
+    int* alloc;
+    int rounds = 0, safe = 0, naiveSafe = 0, hybridSafe;
+    int level, maxLevel = bk_simd_level();
+    double t0, tBuild, tSafe, tHybrid, tNaive = 0;
+
+    printf("  Դ ӣ 10000 1000 1");
+    if (scanf("%d %d %llu", &n, &m, &seed) != 3 || n <= 0 || m <= 0) {
+        printf("Ƿ\n");
+        return;
+    }
+    printf("״̬ͣ0=ȫ״̬ 1=ʽɨ");
+    if (scanf("%d", &chain) != 1 || chain < 0 || chain > 1) {
+        printf("Ƿ\n");
+        return;
+    }
+    safeSeq = (int*)malloc((size_t)n * sizeof(int));
+    avail = (int*)malloc((size_t)m * sizeof(int));
+    max = (int*)malloc((size_t)n * m * sizeof(int));
+    alloc = (int*)malloc((size_t)n * m * sizeof(int));
+    if (safeSeq == NULL || avail == NULL || max == NULL || alloc == NULL ||
+        randomSafeState(seed, 100, chain, avail, max, alloc) != 0) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+
+    t0 = nowSec();
+    bk = bk_create(n, m, avail, max, alloc);
+    tBuild = nowSec() - t0;
+    if (bk == NULL) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+
+    //  0.2 ȡƽ
+    t0 = nowSec();
+    do {
+        safe = bk_check_safe(bk, BK_CHECK_INDEXED, safeSeq);
+        rounds++;
+    } while (nowSec() - t0 < 0.2);
+    tSafe = (nowSec() - t0) / rounds;
+    rounds = 0;
+    t0 = nowSec();
+    do {
+        hybridSafe = bk_is_safe(bk, safeSeq);
+        rounds++;
+    } while (nowSec() - t0 < 0.2);
+    tHybrid = (nowSec() - t0) / rounds;
+
+    printf("\nģ %d  %d\n", n, m);
+    printf("״̬%.2f ms\n", tBuild * 1e3);
+    printf("ȫԼ飺%.3f ms/Σ%s\n", tSafe * 1e3, safe ? "ȫ" : "ȫ");
+    printf("bk_is_safeɨ༸֣%s%.3f ms/Σ%s\n", SIMD_NAMES[maxLevel],
+        tHybrid * 1e3, hybridSafe ? "ȫ" : "ȫ");
+    if (hybridSafe != safe) {
+        printf("ּһ£\n");
+    }
+    // ɨ n^2m/2 αȽϣ̫Ͳˣÿһ˸һ
+    if ((double)n * n * m / 2 <= 2e10) {
+        for (level = 0; level <= maxLevel; level++) {
+            bk_set_simd(bk, level);
+            t0 = nowSec();
+            naiveSafe = bk_check_safe(bk, BK_CHECK_NAIVE, safeSeq);
+            tNaive = nowSec() - t0;
+            printf("ɨ谲ȫԼ飨%s%.3f ms/Σ%s%s %.1f \n",
+                SIMD_NAMES[level], tNaive * 1e3, naiveSafe ? "ȫ" : "ȫ",
+                tNaive >= tSafe ? "" : "", tNaive >= tSafe ? tNaive / tSafe : tSafe / tNaive);
+            if (naiveSafe != safe) {
+                printf("ּһ£\n");
+            }
+        }
     }
     else {
-        int k;
-        printf("棺Դϵͳ벻ȫ״̬󱻾ܾ\n");
+        printf("ģ̫ɨգ\n");
+    }
+    benchmarkKernels(max, alloc);
+    benchmarkBatch(1000, avail, max, alloc);
+    benchmarkWakeup(1000, 10000, avail, max, alloc);
+    printf("\n");
 
-        // عղŵģ
-        for (i = 0; i < m; i++) {
-            Available[i] += Request[i];
-            Allocation[p][i] -= Request[i];
-            Need[p][i] += Request[i];
+done:
+    bk_destroy(bk);
+    bk = NULL;
+    free(safeSeq);
+    free(avail);
+    free(max);
+    free(alloc);
+}
+
+/*
+ * ͬһűϵĶԱȡ
+ * ÿ Maxַʽͬһ飩ÿһְ Max  TRACE_CHUNKS 룬
+ * ȫ黹 rounds ֡ÿһһûĽִһַʽͬһӡ
+ * ⣺bk_submitܷĽȴУ
+ * ⣺ͷ䣬bk_detect_requestͳгԴٵḶ̌ӱֿͷ
+ */
+#define TRACE_CHUNKS 3
+
+typedef struct {
+    long long steps, requests, immediate, checks, aborts, wastedChunks;
+    double opTime;                  // 󡢹黹Դϵʱ
+    double sumRunnable, sumHolding; // ÿһĿнԴĽ֮
+    BkStats engine;                 // ʱͳ
+} TraceStats;
+
+//  Max[p]  TRACE_CHUNKS ݣд plan ĵ p * TRACE_CHUNKS + c Уÿ m 
+static void makePlan(int p, const int* maxInit, int* plan, unsigned long long* rng) {
+    int j, c, cut[TRACE_CHUNKS + 1];
+    for (j = 0; j < m; j++) {
+        cut[0] = 0;
+        cut[TRACE_CHUNKS] = maxInit[(size_t)p * m + j];
+        for (c = 1; c < TRACE_CHUNKS; c++) {
+            unsigned long long save = rngState;
+            rngState = *rng;
+            cut[c] = (int)(nextRandom() % (unsigned int)(maxInit[(size_t)p * m + j] + 1));
+            *rng = rngState;
+            rngState = save;
+        }
+        qsort(cut + 1, TRACE_CHUNKS - 1, sizeof(int), compareInt);
+        for (c = 0; c < TRACE_CHUNKS; c++) {
+            plan[((size_t)p * TRACE_CHUNKS + c) * m + j] = cut[c + 1] - cut[c];
         }
+    }
+}
 
-        printf("ϵͳ״̬ѻعǰ\n");
-        printSystemState();
+// ⷽʽµһ󣺰ȫͷ䷵ 1ȴз 0
+static int avoidRequest(Banker* b, int p, const int* req, TraceStats* st) {
+    int r = bk_submit(b, p, req, NULL);
+    if (r == BK_GRANTED || r == BK_UNSAFE) {
+        st->checks++;
     }
+    return r == BK_GRANTED;
+}
+
+/*
+ *  detect ѡʽűtotal ǸԴmaxInit  Maxn  m дţ
+ *  0 = ɹ1 = ڴ治޷ƽ״̬
+ */
+static int runTrace(int detect, int rounds, unsigned long long seed, const int* total, const int* maxInit, TraceStats* st) {
+    int* plan = (int*)malloc((size_t)n * TRACE_CHUNKS * m * sizeof(int));
+    int* step = (int*)calloc((size_t)n, sizeof(int));
+    int* round = (int*)calloc((size_t)n, sizeof(int));
+    int* runnable = (int*)malloc((size_t)n * sizeof(int));
+    int* waiting = (int*)malloc((size_t)n * sizeof(int));
+    int* dead = (int*)malloc((size_t)n * sizeof(int));
+    unsigned long long* rngs = (unsigned long long*)malloc((size_t)n * sizeof(unsigned long long));
+    int* held = (int*)malloc((size_t)m * sizeof(int));
+    Banker* b = bk_create(n, m, total, maxInit, NULL);
+    int i, j, k, p, runCount = 0, waitCount = 0, finished = 0, holding = 0, deadCount = 0, error = 0;
+    double t0;
+
+    memset(st, 0, sizeof(*st));
+    if (plan == NULL || step == NULL || round == NULL || runnable == NULL || waiting == NULL ||
+        dead == NULL || rngs == NULL || held == NULL || b == NULL) {
+        error = 1;
+        goto done;
+    }
+    for (i = 0; i < n; i++) {
+        rngs[i] = seed * 1000003ULL + i;
+        makePlan(i, maxInit, plan, &rngs[i]);
+        runnable[runCount++] = i;
+    }
+    rngState = seed;
+
+    while (finished < n) {
+        if (runCount == 0) {
+            // ⷽʽн̶ˣһιԼⷽʽӦ
+            if (!detect) {
+                error = 1;
+                break;
+            }
+            deadCount = bk_detect_reduce(b, dead, 1);
+            if (deadCount == 0) {
+                error = 1;
+                break;
+            }
+        }
+        // ԴٵḶֱ̌Լɾ
+        while (deadCount > 0) {
+            int victim = dead[0];
+            long long best = -1;
+            for (k = 0; k < deadCount; k++) {
+                long long sum = 0;
+                for (j = 0; j < m; j++) sum += bk_allocation(b, dead[k], j);
+                if (best < 0 || sum < best) {
+                    best = sum;
+                    victim = dead[k];
+                }
+            }
+            st->aborts++;
+            st->wastedChunks += step[victim];
+            t0 = nowSec();
+            bk_detect_abort(b, victim);
+            st->opTime += nowSec() - t0;
+            for (k = 0; k < waitCount; k++) {
+                if (waiting[k] == victim) waiting[k--] = waiting[--waitCount];
+            }
+            if (step[victim] > 0) holding--;
+            step[victim] = 0;
+            runnable[runCount++] = victim;
+            for (k = 0; k < waitCount; k++) {
+                if (!bk_waiting(b, waiting[k])) {
+                    p = waiting[k];
+                    waiting[k--] = waiting[--waitCount];
+                    runnable[runCount++] = p;
+                    if (step[p]++ == 0) holding++;
+                }
+            }
+            t0 = nowSec();
+            deadCount = bk_detect_reduce(b, dead, 0);
+            st->opTime += nowSec() - t0;
+        }
+
+        k = (int)(nextRandom() % (unsigned int)runCount);
+        p = runnable[k];
+        st->steps++;
+        st->sumRunnable += runCount;
+        st->sumHolding += holding;
+        if (step[p] < TRACE_CHUNKS) {
+            const int* req = plan + ((size_t)p * TRACE_CHUNKS + step[p]) * m;
+            int ok;
+            t0 = nowSec();
+            ok = detect ? bk_detect_request(b, p, req, dead, &deadCount) : avoidRequest(b, p, req, st);
+            st->opTime += nowSec() - t0;
+            st->requests++;
+            if (ok < 0) {
+                error = 1;
+                break;
+            }
+            if (ok) {
+                st->immediate++;
+                if (step[p]++ == 0) holding++;
+            }
+            else {
+                runnable[k] = runnable[--runCount];
+                waiting[waitCount++] = p;
+            }
+            continue;
+        }
+
+        // ˣȫ黹һֻ
+        for (j = 0; j < m; j++) {
+            held[j] = bk_allocation(b, p, j);
+        }
+        t0 = nowSec();
+        if (detect) bk_detect_release(b, p, held);
+        else bk_release(b, p, held);
+        st->opTime += nowSec() - t0;
+        holding--;
+        step[p] = 0;
+        if (++round[p] == rounds) {
+            finished++;
+            runnable[k] = runnable[--runCount];
+        }
+        else {
+            makePlan(p, maxInit, plan, &rngs[p]);
+        }
+        for (k = 0; k < waitCount; k++) {
+            int q = waiting[k];
+            if (!bk_waiting(b, q)) {
+                waiting[k--] = waiting[--waitCount];
+                runnable[runCount++] = q;
+                if (step[q]++ == 0) holding++;
+            }
+        }
+    }
+
+done:
+    if (b != NULL) bk_get_stats(b, &st->engine);
+    bk_destroy(b);
+    free(plan);
+    free(step);
+    free(round);
+    free(runnable);
+    free(waiting);
+    free(dead);
+    free(rngs);
+    free(held);
+    return error;
+}
+
+void compareDetection() {
+    unsigned long long seed;
+    int rounds, mode, i, j, maxDemand = 10;
+    int* total;
+    int* maxInit;
+    TraceStats st[2];
+    static const char* const MODE_NAMES[] = { "⣨мң", "⣨ͼ" };
+
+    printf("  Դ  ÿ̵ 200 8 1 20");
+    if (scanf("%d %d %llu %d", &n, &m, &seed, &rounds) != 4 || n <= 0 || m <= 0 || rounds <= 0) {
+        printf("Ƿ\n");
+        return;
+    }
+    total = (int*)malloc((size_t)m * sizeof(int));
+    maxInit = (int*)malloc((size_t)n * m * sizeof(int));
+    if (total == NULL || maxInit == NULL) {
+        printf("ڴ治㡣\n");
+        free(total);
+        free(maxInit);
+        return;
+    }
+    // ÿԴԼΪȫ Max ֮͵һ룬֮Գ
+    rngState = seed;
+    for (j = 0; j < m; j++) {
+        total[j] = n * maxDemand / 4 > maxDemand ? n * maxDemand / 4 : maxDemand;
+    }
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < m; j++) {
+            maxInit[(size_t)i * m + j] = (int)(nextRandom() % (unsigned int)(maxDemand + 1));
+        }
+    }
+
+    printf("\n%-16s%10s%10s%14s%14s%14s%12s%10s%12s\n", "ʽ", "", "", "ns/",
+        "ƽн", "ƽ", "/Լ", "", "");
+    for (mode = 0; mode <= 1; mode++) {
+        TraceStats* s = &st[mode];
+        if (runTrace(mode, rounds, seed, total, maxInit, s) != 0) {
+            printf("%sʧ\n", MODE_NAMES[mode]);
+            continue;
+        }
+        printf("%-16s%10lld%9.1f%%%14.0f%14.1f%14.1f%12lld%10lld%12lld\n", MODE_NAMES[mode],
+            s->requests, 100.0 * s->immediate / s->requests,
+            s->opTime * 1e9 / (s->requests + (double)n * rounds),
+            s->sumHolding / s->steps, s->sumRunnable / s->steps,
+            mode ? s->engine.reductions : s->checks, s->aborts, s->wastedChunks);
+        if (mode == 1) {
+            printf("Դͼӱ %lld Σгɻ %lld Σ\n", s->engine.edge_inserts, s->engine.cycle_hits);
+        }
+    }
+    printf("\n");
+    free(total);
+    free(maxInit);
+}
+
+/* ---------------- ٣ط ---------------- */
+
+/*
+ * ļ¼һʼ״̬һ¼طʱҪ롣
+ * ıʽ# ͷβעͣ
+ *   state n m
+ *   avail a0 ... a(m-1)
+ *   max p v0 ... v(m-1)        ÿһ
+ *   alloc p v0 ... v(m-1)      ÿһ
+ *   req p v0 ... v(m-1)         p 
+ *   rel p v0 ... v(m-1)         p 黹һԴ
+ *   exit p                      p 
+ * Ƹʽ4 ֽ "BKTR"int32  nmAvailableMaxnmAllocationnm
+ * ֮ÿ¼Ϊ int32 ͣ1 = req2 = rel3 = exitint32 ̺ţreq/rel ٸ m  int32
+ * ȴУ˵Ĵͬ黹ͽʱѡ
+ */
+
+#define TRACE_REQ  1
+#define TRACE_REL  2
+#define TRACE_EXIT 3
+#define LAT_BUCKETS 40      //  k Ͱ [2^k, 2^(k+1)) 
+
+typedef struct {
+    long long events, requests, releases, exits;
+    long long admitted, rejected, deferredDemand, deferredUnsafe, badEvents;
+    long long checks;
+    long long latency[LAT_BUCKETS];     // ˰ȫԼĺʱֱͼ
+} ReplayStats;
+
+static int readInt(FILE* f, int binary, int* v) {
+    if (binary) {
+        return fread(v, sizeof(int), 1, f) == 1;
+    }
+    return fscanf(f, "%d", v) == 1;
+}
+
+static void writeInt(FILE* f, int binary, int v) {
+    if (binary) fwrite(&v, sizeof(int), 1, f);
+    else fprintf(f, " %d", v);
+}
+
+// ıʽһؼ֣עͣû˷ 0
+static int readKeyword(FILE* f, char* word) {
+    while (fscanf(f, "%15s", word) == 1) {
+        if (word[0] != '#') return 1;
+        while (1) {
+            int c = fgetc(f);
+            if (c == '\n' || c == EOF) break;
+        }
+    }
+    return 0;
+}
+
+static int readRow(FILE* f, int binary, int* row) {
+    int j;
+    for (j = 0; j < m; j++) {
+        if (!readInt(f, binary, &row[j])) return 0;
+    }
+    return 1;
+}
+
+/*
+ * ļͷĳʼ״̬棨*out 0 = ɹ
+ * ıʽ maxalloc п԰˳
+ */
+static int readTraceState(FILE* f, int binary, Banker** out) {
+    char word[16];
+    int i, p, rows = 0, error = 1;
+    int* avail = NULL;
+    int* max = NULL;
+    int* alloc = NULL;
+    if (binary) {
+        if (!readInt(f, 1, &n) || !readInt(f, 1, &m)) return 1;
+    }
+    else if (!readKeyword(f, word) || strcmp(word, "state") != 0 ||
+        fscanf(f, "%d %d", &n, &m) != 2) {
+        return 1;
+    }
+    if (n <= 0 || m <= 0) {
+        return 1;
+    }
+    avail = (int*)malloc((size_t)m * sizeof(int));
+    max = (int*)calloc((size_t)n * m, sizeof(int));
+    alloc = (int*)calloc((size_t)n * m, sizeof(int));
+    if (avail == NULL || max == NULL || alloc == NULL) {
+        goto done;
+    }
+    if (binary) {
+        if (!readRow(f, 1, avail)) goto done;
+        for (i = 0; i < n; i++) {
+            if (!readRow(f, 1, max + (size_t)i * m)) goto done;
+        }
+        for (i = 0; i < n; i++) {
+            if (!readRow(f, 1, alloc + (size_t)i * m)) goto done;
+        }
+    }
+    else {
+        if (!readKeyword(f, word) || strcmp(word, "avail") != 0 || !readRow(f, 0, avail)) goto done;
+        for (rows = 0; rows < 2 * n; rows++) {
+            if (!readKeyword(f, word) || fscanf(f, "%d", &p) != 1 || p < 0 || p >= n) goto done;
+            if (strcmp(word, "max") == 0) {
+                if (!readRow(f, 0, max + (size_t)p * m)) goto done;
+            }
+            else if (strcmp(word, "alloc") == 0) {
+                if (!readRow(f, 0, alloc + (size_t)p * m)) goto done;
+            }
+            else {
+                goto done;
+            }
+        }
+    }
+    // Allocation  Max ָʱ bk_create  NULL
+    *out = bk_create(n, m, avail, max, alloc);
+    error = *out == NULL;
+
+done:
+    free(avail);
+    free(max);
+    free(alloc);
+    return error;
+}
+
+// һ¼û˷ 0ʽ󷵻 -1
+static int readTraceEvent(FILE* f, int binary, int* type, int* p, int* vec) {
+    char word[16];
+    if (binary) {
+        if (!readInt(f, 1, type)) return 0;
+    }
+    else {
+        if (!readKeyword(f, word)) return 0;
+        *type = strcmp(word, "req") == 0 ? TRACE_REQ : strcmp(word, "rel") == 0 ? TRACE_REL
+            : strcmp(word, "exit") == 0 ? TRACE_EXIT : 0;
+    }
+    if (*type < TRACE_REQ || *type > TRACE_EXIT || !readInt(f, binary, p)) return -1;
+    if (*type != TRACE_EXIT && !readRow(f, binary, vec)) return -1;
+    return 1;
+}
+
+static void writeTraceState(FILE* f, int binary, const int* avail, const int* max, const int* alloc) {
+    int i, j;
+    if (binary) {
+        fwrite("BKTR", 1, 4, f);
+        writeInt(f, 1, n);
+        writeInt(f, 1, m);
+    }
+    else {
+        fprintf(f, "# м㷨\nstate %d %d\navail", n, m);
+    }
+    for (j = 0; j < m; j++) writeInt(f, binary, avail[j]);
+    for (i = 0; i < n; i++) {
+        if (!binary) fprintf(f, "\nmax %d", i);
+        for (j = 0; j < m; j++) writeInt(f, binary, max[(size_t)i * m + j]);
+    }
+    for (i = 0; i < n; i++) {
+        if (!binary) fprintf(f, "\nalloc %d", i);
+        for (j = 0; j < m; j++) writeInt(f, binary, alloc[(size_t)i * m + j]);
+    }
+    if (!binary) fprintf(f, "\n");
+}
+
+static void writeTraceEvent(FILE* f, int binary, int type, int p, const int* vec) {
+    int j;
+    if (binary) {
+        writeInt(f, 1, type);
+        writeInt(f, 1, p);
+    }
+    else {
+        fprintf(f, "%s %d", type == TRACE_REQ ? "req" : type == TRACE_REL ? "rel" : "exit", p);
+    }
+    for (j = 0; type != TRACE_EXIT && j < m; j++) writeInt(f, binary, vec[j]);
+    if (!binary) fprintf(f, "\n");
+}
+
+static void recordLatency(ReplayStats* st, double sec) {
+    long long ns = (long long)(sec * 1e9);
+    int k = 0;
+    while (k < LAT_BUCKETS - 1 && ns >= (2LL << k)) k++;
+    st->latency[k]++;
+}
+
+// һ¼
+static void applyTraceEvent(Banker* b, int type, int p, const int* vec, ReplayStats* st) {
+    int j, r;
+    double t0;
+
+    st->events++;
+    if (p < 0 || p >= n) {
+        st->badEvents++;
+        return;
+    }
+    if (type == TRACE_EXIT) {
+        st->exits++;
+        bk_exit(b, p);
+        return;
+    }
+    if (type == TRACE_REL) {
+        st->releases++;
+        if (bk_release(b, p, vec) != 0) st->badEvents++;
+        return;
+    }
+
+    st->requests++;
+    for (j = 0; j < m; j++) {
+        if (vec[j] < 0) {
+            st->badEvents++;
+            return;
+        }
+    }
+    t0 = nowSec();
+    r = bk_submit(b, p, vec, NULL);
+    if (r == BK_GRANTED || r == BK_UNSAFE) {
+        recordLatency(st, nowSec() - t0);
+        st->checks++;
+    }
+    switch (r) {
+    case BK_GRANTED: st->admitted++; break;
+    case BK_INVALID: st->rejected++; break;
+    case BK_WAIT:    st->deferredDemand++; break;
+    case BK_UNSAFE:  st->deferredUnsafe++; break;
+    default:         st->badEvents++; break;
+    }
+}
+
+static double latencyPercentile(const ReplayStats* st, double q) {
+    long long target = (long long)(q * st->checks), seen = 0;
+    int k;
+    for (k = 0; k < LAT_BUCKETS; k++) {
+        seen += st->latency[k];
+        if (seen > target) return (double)(2LL << k);
+    }
+    return (double)(2LL << (LAT_BUCKETS - 1));
+}
+
+static void printReplayStats(Banker* b, const ReplayStats* st, double elapsed) {
+    long long requests = st->requests ? st->requests : 1, peak = 0;
+    int k, lo = LAT_BUCKETS, hi = -1;
+    BkStats es;
+
+    bk_get_stats(b, &es);
+    printf("\n¼ %lld  %lld黹 %lld %lldǷ %lldʱ %.3f s%.0f ¼/s\n",
+        st->events, st->requests, st->releases, st->exits, st->badEvents, elapsed, st->events / elapsed);
+    printf("׼ %lld%.1f%% Need ܾ %lld%.1f%%Դݻ %lld%.1f%%ȫݻ %lld%.1f%%\n",
+        st->admitted, 100.0 * st->admitted / requests, st->rejected, 100.0 * st->rejected / requests,
+        st->deferredDemand, 100.0 * st->deferredDemand / requests,
+        st->deferredUnsafe, 100.0 * st->deferredUnsafe / requests);
+    printf("ȴУѺ׼ %lldʱڵȴ %d\n", es.wake_granted, bk_pending(b));
+    printf("׼£%.0f /s\n", (st->admitted + es.wake_granted) / elapsed);
+    if (st->checks == 0) {
+        return;
+    }
+    printf("ȫԼ %lld Σp50 < %.1f usp90 < %.1f usp99 < %.1f us\n", st->checks,
+        latencyPercentile(st, 0.5) / 1e3, latencyPercentile(st, 0.9) / 1e3, latencyPercentile(st, 0.99) / 1e3);
+    for (k = 0; k < LAT_BUCKETS; k++) {
+        if (st->latency[k] == 0) continue;
+        if (k < lo) lo = k;
+        hi = k;
+        if (st->latency[k] > peak) peak = st->latency[k];
+    }
+    for (k = lo; k <= hi; k++) {
+        int bar = (int)(40 * st->latency[k] / peak);
+        printf("  [%9.1f, %9.1f) us %10lld ", (double)(k ? 1LL << k : 0) / 1e3, (double)(2LL << k) / 1e3,
+            st->latency[k]);
+        while (bar-- > 0) putchar('#');
+        putchar('\n');
+    }
+}
+
+// طһļ·Ϊ - ʱ׼룬ֻ֧ıʽ
+void replayTrace() {
+    char path[512];
+    FILE* f;
+    int binary = 0, c, type, p, r;
+    int* vec = NULL;
+    Banker* b = NULL;
+    ReplayStats st;
+    double t0;
+
+    printf("ļ·- ʾ׼룩");
+    if (scanf("%511s", path) != 1) {
+        return;
+    }
+    f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (f == NULL) {
+        printf("޷ %s\n", path);
+        return;
+    }
+    c = fgetc(f);
+    if (c == 'B') {
+        char magic[3];
+        binary = fread(magic, 1, 3, f) == 3 && memcmp(magic, "KTR", 3) == 0;
+        if (!binary) {
+            printf("ļʽ\n");
+            goto done;
+        }
+    }
+    else if (c != EOF) {
+        ungetc(c, f);
+    }
+    if (readTraceState(f, binary, &b) != 0) {
+        printf("ļĳʼ״̬ʽڴ治㡣\n");
+        goto done;
+    }
+    vec = (int*)malloc((size_t)m * sizeof(int));
+    if (vec == NULL) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+    printf("ʼ״̬%d ̣%d Դ%s\n", n, m, bk_is_safe(b, NULL) ? "ȫ" : "ȫ");
+
+    memset(&st, 0, sizeof(st));
+    t0 = nowSec();
+    while ((r = readTraceEvent(f, binary, &type, &p, vec)) > 0) {
+        applyTraceEvent(b, type, p, vec, &st);
+    }
+    printReplayStats(b, &st, nowSec() - t0);
+    if (r < 0) {
+        printf("ע⣺ %lld ¼֮ʽ󣬻طǰ\n", st.events);
+    }
+    printf("\n");
+
+done:
+    if (f != stdin) fclose(f);
+    free(vec);
+    bk_destroy(b);
+}
+
+// ɽ p һԴҪʣһ
+static void randomRequest(Banker* b, int p, int* vec) {
+    int i, j;
+    memset(vec, 0, (size_t)m * sizeof(int));
+    for (i = 0; i < 4; i++) {
+        j = (int)(nextRandom() % (unsigned int)m);
+        vec[j] = (int)(nextRandom() % (unsigned int)(bk_need(b, p, j) / 2 + 1));
+    }
+}
+
+/*
+ * ǰ״̬һ¼¼̺ͣд *p黹д vec
+ * Լռ 80% randomRequest黹Լռ 19%Դһ֣Լռ 1%
+ */
+static int randomTraceEvent(Banker* b, int* p, int* vec) {
+    int i, j, k, type;
+    *p = (int)(nextRandom() % (unsigned int)n);
+    k = (int)(nextRandom() % 100);
+    type = k < 80 ? TRACE_REQ : k < 99 ? TRACE_REL : TRACE_EXIT;
+    if (type == TRACE_REQ) {
+        randomRequest(b, *p, vec);
+        return type;
+    }
+    memset(vec, 0, (size_t)m * sizeof(int));
+    for (i = 0; type == TRACE_REL && i < 4; i++) {
+        j = (int)(nextRandom() % (unsigned int)m);
+        if (bk_allocation(b, *p, j) > 0) {
+            vec[j] = 1 + (int)(nextRandom() % (unsigned int)bk_allocation(b, *p, j));
+        }
+    }
+    return type;
+}
+
+/*
+ * ļʼ״̬ randomSafeState ɣ֤ȫAvailable ܽ
+ * ¼ randomTraceEvent ɲͬʱִУ֤黹ѷطŽʱһ
+ */
+void generateTrace() {
+    char path[512];
+    unsigned long long seed;
+    int events, binary, e, p, type;
+    int* vec = NULL;
+    int* avail = NULL;
+    int* max = NULL;
+    int* alloc = NULL;
+    Banker* b = NULL;
+    FILE* f;
+    ReplayStats st;
+    double t0;
+
+    printf(" ·  Դ  ¼ ʽ(0 ı / 1 )");
+    if (scanf("%511s %d %d %llu %d %d", path, &n, &m, &seed, &events, &binary) != 6 ||
+        n <= 0 || m <= 0 || events < 0 || binary < 0 || binary > 1) {
+        printf("Ƿ\n");
+        return;
+    }
+    f = fopen(path, binary ? "wb" : "w");
+    if (f == NULL) {
+        printf("޷д %s\n", path);
+        return;
+    }
+    vec = (int*)malloc((size_t)m * sizeof(int));
+    avail = (int*)malloc((size_t)m * sizeof(int));
+    max = (int*)malloc((size_t)n * m * sizeof(int));
+    alloc = (int*)malloc((size_t)n * m * sizeof(int));
+    if (vec == NULL || avail == NULL || max == NULL || alloc == NULL ||
+        randomSafeState(seed, 100, 0, avail, max, alloc) != 0 ||
+        (b = bk_create(n, m, avail, max, alloc)) == NULL) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+    writeTraceState(f, binary, avail, max, alloc);
+
+    memset(&st, 0, sizeof(st));
+    t0 = nowSec();
+    for (e = 0; e < events; e++) {
+        type = randomTraceEvent(b, &p, vec);
+        writeTraceEvent(f, binary, type, p, vec);
+        applyTraceEvent(b, type, p, vec, &st);
+    }
+    printf("д %sʱͬʱִһ飩", path);
+    printReplayStats(b, &st, nowSec() - t0);
+    printf("\n");
+
+done:
+    fclose(f);
+    free(vec);
+    free(avail);
+    free(max);
+    free(alloc);
+    bk_destroy(b);
+}
+
+/* ---------------- ѡ ---------------- */
+
+/*
+ * ڿжһѡڷ޸ʵʱ״̬Ҳʵʱ״̬
+ * ѡָ̳߳Ḷ́߳ÿ߳ԼĹ bk_evaluate
+ * ڼ߳̿Լʵʱ¼дʱƱ֤ղ䡣
+ */
+
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE CondVar;
+#define THREAD_RET              DWORD WINAPI
+#define THREAD_RET_VALUE        0
+#define mutexInit(x)            InitializeCriticalSection(x)
+#define mutexDestroy(x)         DeleteCriticalSection(x)
+#define mutexLock(x)            EnterCriticalSection(x)
+#define mutexUnlock(x)          LeaveCriticalSection(x)
+#define condInit(c)             InitializeConditionVariable(c)
+#define condDestroy(c)          ((void)0)
+#define condWait(c, x)          SleepConditionVariableCS((c), (x), INFINITE)
+#define condBroadcast(c)        WakeAllConditionVariable(c)
+#else
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t CondVar;
+#define THREAD_RET              void*
+#define THREAD_RET_VALUE        NULL
+#define mutexInit(x)            pthread_mutex_init((x), NULL)
+#define mutexDestroy(x)         pthread_mutex_destroy(x)
+#define mutexLock(x)            pthread_mutex_lock(x)
+#define mutexUnlock(x)          pthread_mutex_unlock(x)
+#define condInit(c)             pthread_cond_init((c), NULL)
+#define condDestroy(c)          pthread_cond_destroy(c)
+#define condWait(c, x)          pthread_cond_wait((c), (x))
+#define condBroadcast(c)        pthread_cond_broadcast(c)
+#endif
+
+static int threadStart(ThreadHandle* t, THREAD_RET (*fn)(void*), void* arg) {
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t == NULL;
+#else
+    return pthread_create(t, NULL, fn, arg) != 0;
+#endif
+}
+
+static void threadJoin(ThreadHandle t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+#define WHATIF_CHUNK 16     // ߳ÿȡĺѡ
+
+typedef struct {
+    int pid;
+    const int* vec;
+    int verdict;            // bk_evaluate ĽBK_GRANTED / BK_WAIT / BK_UNSAFE / BK_INVALID
+} WhatIf;
+
+typedef struct WhatIfPool WhatIfPool;
+
+typedef struct {
+    WhatIfPool* pool;
+    BkScratch* scratch;
+    ThreadHandle thread;
+} WhatIfWorker;
+
+/*
+ * ̳߳һδһѡ󣬹߳ÿ WHATIF_CHUNK 
+ * lock ֻȡͼ
+ */
+struct WhatIfPool {
+    Mutex lock;
+    CondVar wake;           // µһҪ˳
+    CondVar done;           // һ
+    const BkSnapshot* snap;
+    WhatIf* items;
+    int count;
+    int next;               // һȡ±
+    int finished;           // ĸ
+    int stop;
+    int threads;
+    WhatIfWorker* workers;
+};
+
+static THREAD_RET whatIfWorker(void* arg) {
+    WhatIfWorker* wk = (WhatIfWorker*)arg;
+    WhatIfPool* pool = wk->pool;
+    int begin, end, i;
+    mutexLock(&pool->lock);
+    while (1) {
+        while (!pool->stop && pool->next >= pool->count) {
+            condWait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) break;
+        begin = pool->next;
+        end = begin + WHATIF_CHUNK < pool->count ? begin + WHATIF_CHUNK : pool->count;
+        pool->next = end;
+        mutexUnlock(&pool->lock);
+        for (i = begin; i < end; i++) {
+            WhatIf* w = &pool->items[i];
+            w->verdict = bk_evaluate(pool->snap, w->pid, w->vec, wk->scratch);
+        }
+        mutexLock(&pool->lock);
+        pool->finished += end - begin;
+        if (pool->finished == pool->count) {
+            condBroadcast(&pool->done);
+        }
+    }
+    mutexUnlock(&pool->lock);
+    return THREAD_RET_VALUE;
+}
+
+static void destroyWhatIfPool(WhatIfPool* pool) {
+    int i;
+    mutexLock(&pool->lock);
+    pool->stop = 1;
+    condBroadcast(&pool->wake);
+    mutexUnlock(&pool->lock);
+    for (i = 0; i < pool->threads; i++) {
+        threadJoin(pool->workers[i].thread);
+    }
+    for (i = 0; i < pool->threads; i++) {
+        bk_scratch_destroy(pool->workers[i].scratch);
+    }
+    mutexDestroy(&pool->lock);
+    condDestroy(&pool->wake);
+    condDestroy(&pool->done);
+    free(pool->workers);
+    free(pool);
+}
+
+//  threads ̣߳ b Ĺģ䣩 NULL ʾʧ
+static WhatIfPool* createWhatIfPool(const Banker* b, int threads) {
+    WhatIfPool* pool = (WhatIfPool*)calloc(1, sizeof(WhatIfPool));
+    int i;
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->workers = (WhatIfWorker*)calloc((size_t)threads, sizeof(WhatIfWorker));
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+    mutexInit(&pool->lock);
+    condInit(&pool->wake);
+    condInit(&pool->done);
+    for (i = 0; i < threads; i++) {
+        WhatIfWorker* wk = &pool->workers[i];
+        wk->pool = pool;
+        wk->scratch = bk_scratch_create(b);
+        if (wk->scratch == NULL || threadStart(&wk->thread, whatIfWorker, wk) != 0) {
+            bk_scratch_destroy(wk->scratch);
+            break;
+        }
+        pool->threads++;
+    }
+    if (pool->threads < threads) {
+        destroyWhatIfPool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// ̳߳һѡأһûʱȵꡣ whatIfWait ֮ǰͷ
+static void whatIfSubmit(WhatIfPool* pool, const BkSnapshot* snap, WhatIf* items, int count) {
+    mutexLock(&pool->lock);
+    while (pool->finished < pool->count) {
+        condWait(&pool->done, &pool->lock);
+    }
+    pool->snap = snap;
+    pool->items = items;
+    pool->count = count;
+    pool->next = 0;
+    pool->finished = 0;
+    condBroadcast(&pool->wake);
+    mutexUnlock(&pool->lock);
+}
+
+static int whatIfDone(WhatIfPool* pool) {
+    int done;
+    mutexLock(&pool->lock);
+    done = pool->finished == pool->count;
+    mutexUnlock(&pool->lock);
+    return done;
+}
+
+static void whatIfWait(WhatIfPool* pool) {
+    mutexLock(&pool->lock);
+    while (pool->finished < pool->count) {
+        condWait(&pool->done, &pool->lock);
+    }
+    mutexUnlock(&pool->lock);
+}
+
+/*
+ * ԣȫ״̬һѡ
+ * ȴһ飬ʵʱ״̬ bk_request Ľգ׼ٹ黹
+ *  124  ̲߳ڼ̼߳ʵʱ¼
+ * ͬһϴһ飬鲢нûʵʱ޸Ӱ
+ */
+void benchmarkWhatIf() {
+    unsigned long long seed;
+    int count, maxThreads, t, i, p, type, mismatch, live, granted, waitAvail, waitUnsafe, rejected;
+    int* vecs = NULL;
+    int* vec = NULL;
+    int* avail = NULL;
+    int* max = NULL;
+    int* alloc = NULL;
+    WhatIf* items = NULL;
+    WhatIfPool* pool;
+    BkSnapshot* snap;
+    BkScratch* sc = NULL;
+    BkStats es;
+    ReplayStats st;
+    long long copies;
+    double t0, elapsed, base = 0;
+
+    printf("  Դ  ѡ ߳");
+    if (scanf("%d %d %llu %d %d", &n, &m, &seed, &count, &maxThreads) != 5 ||
+        n <= 0 || m <= 0 || count <= 0 || maxThreads <= 0) {
+        printf("Ƿ\n");
+        return;
+    }
+    vecs = (int*)malloc((size_t)count * m * sizeof(int));
+    vec = (int*)malloc((size_t)m * sizeof(int));
+    avail = (int*)malloc((size_t)m * sizeof(int));
+    max = (int*)malloc((size_t)n * m * sizeof(int));
+    alloc = (int*)malloc((size_t)n * m * sizeof(int));
+    items = (WhatIf*)malloc((size_t)count * sizeof(WhatIf));
+    if (vecs == NULL || vec == NULL || avail == NULL || max == NULL || alloc == NULL || items == NULL ||
+        randomSafeState(seed, 100, 0, avail, max, alloc) != 0 ||
+        (bk = bk_create(n, m, avail, max, alloc)) == NULL || (sc = bk_scratch_create(bk)) == NULL) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+    for (i = 0; i < count; i++) {
+        items[i].pid = (int)(nextRandom() % (unsigned int)n);
+        items[i].vec = vecs + (size_t)i * m;
+        randomRequest(bk, items[i].pid, vecs + (size_t)i * m);
+    }
+
+    // ʵʱ״̬
+    snap = bk_snapshot(bk);
+    if (snap == NULL) {
+        printf("ڴ治㡣\n");
+        goto done;
+    }
+    t0 = nowSec();
+    for (i = 0; i < count; i++) {
+        items[i].verdict = bk_evaluate(snap, items[i].pid, items[i].vec, sc);
+    }
+    elapsed = nowSec() - t0;
+    bk_drop_snapshot(bk, snap);
+    mismatch = granted = waitAvail = waitUnsafe = rejected = 0;
+    for (i = 0; i < count; i++) {
+        int verdict = bk_request(bk, items[i].pid, items[i].vec);
+        if (verdict == BK_GRANTED) {
+            bk_release(bk, items[i].pid, items[i].vec);
+        }
+        mismatch += verdict != items[i].verdict;
+        granted += verdict == BK_GRANTED;
+        waitAvail += verdict == BK_WAIT;
+        waitUnsafe += verdict == BK_UNSAFE;
+        rejected += verdict == BK_INVALID;
+    }
+    printf("\n%d ѡ󣺿׼ %dԴ %d󲻰ȫ %d Need %d\n",
+        count, granted, waitAvail, waitUnsafe, rejected);
+    printf(" %.0f /sʵʱ״̬Է + ȫԼĽһ %d \n", count / elapsed, mismatch);
+
+    printf("\n߳\t(/s)\tٱ\tڼʵʱ¼\tƵ\t봮нһ\n");
+    memset(&st, 0, sizeof(st));
+    // ߳ 124  һ maxThreads 
+    for (t = 1; t <= maxThreads; t = t < maxThreads && t * 2 > maxThreads ? maxThreads : t * 2) {
+        pool = createWhatIfPool(bk, t);
+        if (pool == NULL) {
+            printf("޷ %d ̡߳\n", t);
+            break;
+        }
+        snap = bk_snapshot(bk);
+        if (snap == NULL) {
+            destroyWhatIfPool(pool);
+            printf("ڴ治㡣\n");
+            break;
+        }
+        bk_get_stats(bk, &es);
+        copies = es.cow_copies;
+        live = 0;
+        t0 = nowSec();
+        whatIfSubmit(pool, snap, items, count);
+        while (!whatIfDone(pool)) {
+            type = randomTraceEvent(bk, &p, vec);
+            applyTraceEvent(bk, type, p, vec, &st);
+            live++;
+        }
+        whatIfWait(pool);
+        elapsed = nowSec() - t0;
+        mismatch = 0;
+        for (i = 0; i < count; i++) {
+            mismatch += bk_evaluate(snap, items[i].pid, items[i].vec, sc) != items[i].verdict;
+        }
+        bk_drop_snapshot(bk, snap);
+        destroyWhatIfPool(pool);
+        bk_get_stats(bk, &es);
+        if (t == 1) base = elapsed;
+        printf("%d\t%10.0f\t%6.2f\t%8d\t\t%8lld\t%8d\n", t, count / elapsed, base / elapsed, live,
+            es.cow_copies - copies, mismatch);
+    }
+    printf("\n");
+
+done:
+    bk_scratch_destroy(sc);
+    bk_destroy(bk);
+    bk = NULL;
+    free(vecs);
+    free(vec);
+    free(avail);
+    free(max);
+    free(alloc);
+    free(items);
 }
 
 int main() {
     int i, j;
+    int* avail;
+    int* max;
+    int* alloc;
 
     printf("=========== м㷨ģ ===========\n");
-    printf(" n<= %d", MAX_P);
+    printf(" n 0 дģȫԼԣ-1 Ա⣬-2 ط٣-3 ٣-4 ѡ󣩣");
     scanf("%d", &n);
-    if (n <= 0 || n > MAX_P) {
+    if (n == 0) {
+        benchmarkSafety();
+        return 0;
+    }
+    if (n == -1) {
+        compareDetection();
+        return 0;
+    }
+    if (n == -2) {
+        replayTrace();
+        return 0;
+    }
+    if (n == -3) {
+        generateTrace();
+        return 0;
+    }
+    if (n == -4) {
+        benchmarkWhatIf();
+        return 0;
+    }
+    if (n < 0) {
         printf("Ƿ\n");
         return 1;
     }
 
-    printf("Դ m<= %d", MAX_R);
+    printf("Դ m");
     scanf("%d", &m);
-    if (m <= 0 || m > MAX_R) {
+    if (m <= 0) {
         printf("ԴǷ\n");
         return 1;
     }
+    avail = (int*)malloc((size_t)m * sizeof(int));
+    max = (int*)malloc((size_t)n * m * sizeof(int));
+    alloc = (int*)malloc((size_t)n * m * sizeof(int));
+    if (avail == NULL || max == NULL || alloc == NULL) {
+        printf("ڴ治㡣\n");
+        free(avail);
+        free(max);
+        free(alloc);
+        return 1;
+    }
 
     //  Available
     printf("\nԴĳʼ Available %d Դ\n", m);
     for (j = 0; j < m; j++) {
         printf("Available[%d] = ", j);
-        scanf("%d", &Available[j]);
+        scanf("%d", &avail[j]);
     }
 
     //  Max
@@ -244,7 +1735,7 @@ int main() {
         printf(" P%d \n", i);
         for (j = 0; j < m; j++) {
             printf("Max[%d][%d] = ", i, j);
-            scanf("%d", &Max[i][j]);
+            scanf("%d", &max[(size_t)i * m + j]);
         }
     }
 
@@ -254,32 +1745,35 @@ int main() {
         printf(" P%d ѷԴ\n", i);
         for (j = 0; j < m; j++) {
             printf("Allocation[%d][%d] = ", i, j);
-            scanf("%d", &Allocation[i][j]);
+            scanf("%d", &alloc[(size_t)i * m + j]);
         }
     }
 
-    //  Max  Allocation  Need
-    calculateNeed();
+    //  Max  Allocation  Need
+    bk = bk_create(n, m, avail, max, alloc);
+    free(avail);
+    free(max);
+    free(alloc);
+    if (bk == NULL) {
+        printf("ʼ״̬Ƿָ Allocation  Maxڴ治㡣\n");
+        return 1;
+    }
+    bk_set_callback(bk, onBankerEvent, NULL);
 
     // ʼ״̬ӡһ
     printSystemState();
 
     // ʼ״̬Ƿȫ
     {
-        int safeSeq[MAX_P];
-        if (isSafe(safeSeq)) {
-            int k;
+        int* safeSeq = (int*)malloc((size_t)n * sizeof(int));
+        if (safeSeq != NULL && bk_is_safe(bk, safeSeq)) {
             printf("ʼϵͳ״̬ǰȫġ\n");
-            printf("һְȫΪ");
-            for (k = 0; k < n; k++) {
-                printf("P%d", safeSeq[k]);
-                if (k != n - 1) printf(" -> ");
-            }
-            printf("\n\n");
+            printSafeSeq(safeSeq);
         }
         else {
             printf("ע⣺ʼϵͳ״̬Ѿȫ\n\n");
         }
+        free(safeSeq);
     }
 
     // ѭ
@@ -288,6 +1782,10 @@ int main() {
         printf("========== ˵ ==========\n");
         printf("1. һԴ\n");
         printf("2. ӡǰϵͳ״̬\n");
+        printf("3. Դ\n");
+        printf("4. ͷԴ\n");
+        printf("5. ̽\n");
+        printf("6. 鿴ȴ\n");
         printf("0. ˳\n");
         printf("ѡ");
         scanf("%d", &choice);
@@ -298,6 +1796,18 @@ int main() {
         else if (choice == 2) {
             printSystemState();
         }
+        else if (choice == 3) {
+            handleBatch();
+        }
+        else if (choice == 4) {
+            handleRelease();
+        }
+        else if (choice == 5) {
+            handleExit();
+        }
+        else if (choice == 6) {
+            printWaitQueue();
+        }
         else if (choice == 0) {
             printf("ټ\n");
             break;
@@ -307,5 +1817,6 @@ int main() {
         }
     }
 
+    bk_destroy(bk);
     return 0;
 }
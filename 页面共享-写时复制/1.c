@@ -0,0 +1,624 @@
+/*
+ * ҳ湲ģ⣺fork дʱơҳҳͬҳϲKSM
+ * ̸һҳüԱҳͬʱӳ䣺
+ *   fork      ӽ̸Ƹ̵ҳдҳڸ߶ĳֻ + дʱƣü 1
+ *       ҳ 0 ~ LIB_VPAGES-1 ӳ乲ļҳͨҳ湲ͬһ
+ *             ˽ӳ䣺дʱҲҪƣ
+ *   ҳ      ҳһαʱӳ䵽ȫϵͳõҳдʱŷ䣻
+ *   KSM       ÿɴβɨһҳȫĲҳͬĲһֻ顣
+ * ͬһ̸ϱȽãfork ÿһҳдʱ +  + ҳ
+ * ټ KSMռõֵƽȲʡ٣Լдʱƴȱҳ
+ * ٿɣɱ浽ļҲԴļȡʽ read_trace
+ * ģ⻻ҳ鲻ޣֻͳ˶١ҳһ 64 λֵֵͬͬ
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PROCS   256     // ̺ 0 ~ MAX_PROCS-1
+#define VPAGES      64      // ÿ̵ҳ
+#define LIB_VPAGES  16      // ǰôҳӳ乲⣬ҳѡջ
+#define ZERO_FRAME  0       // ҳ̶ռ 0 
+
+// еĲ
+#define OP_FORK  0
+#define OP_READ  1
+#define OP_WRITE 2
+#define OP_EXIT  3
+
+// ҳҳûҳšЧλ޸λװʱ䣩ϼ˱λдʱƱ־
+typedef struct {
+    int frame_number;     // 
+    int valid;            // Чλ
+    int modified;         // ޸λ
+    int time_loaded;      // װʱ
+    int writable;         // дλΪ 0 ʱд𱣻쳣
+    int cow;              // дʱƣ쳣ʱһݣռʱֱӸΪд
+} PageTableEntry;
+
+// 
+typedef struct {
+    int ref_count;              // ӳҳ0 = 
+    int file_page;              // ļҳţ-1 = ҳ
+    unsigned long long content; // ҳݣ0 = ȫ㣩
+} Frame;
+
+typedef struct {
+    int alive;
+    PageTableEntry page_table[VPAGES];
+} Process;
+
+typedef struct {
+    int type;
+    int pid;
+    int arg;                    // forkӽ̺ţдҳ
+    unsigned long long value;   // д
+} TraceOp;
+
+// һģ
+typedef struct {
+    int share;                  // дʱ + ҳ + ҳ
+    int ksm;                    // KSM ɨ0 = ɨ
+    int peak_frames;
+    double avg_frames;
+    long long page_faults;      // Чҳ
+    long long cow_copies;       // дʱʱĸһҳ
+    long long cow_reuse;        // дʱʱѾռֱӸΪд
+    long long fork_copies;      // ʱ fork Ƶҳ
+    long long zero_merges;      // KSM ҳҳ
+    long long ksm_merges;       // KSM ϲͬҳ
+} SimResult;
+
+Process procs[MAX_PROCS];
+Frame* frames;                  // 
+int frame_cap;
+int* free_frames;               // ţջ
+int free_count;
+int frames_used;                // ü 0 
+int lib_cache[LIB_VPAGES];      // ҳ棺ļҳ -> 飬-1 = ڴ
+int current_time;
+SimResult* result;              // ǰģͳ
+
+// KSM ɨõɢб -> 
+unsigned long long* ksm_keys;
+int* ksm_frames;
+int ksm_cap;
+
+// ļҳݣҳһֵ
+static unsigned long long lib_content(int file_page) {
+    return 0x9E3779B97F4A7C15ULL * (unsigned long long)(file_page + 1);
+}
+
+// ȫ̺飻 0 = ɹ
+int reset_memory() {
+    memset(procs, 0, sizeof(procs));
+    free(frames);
+    free(free_frames);
+    frame_cap = 1024;
+    frames = (Frame*)calloc((size_t)frame_cap, sizeof(Frame));
+    free_frames = (int*)malloc((size_t)frame_cap * sizeof(int));
+    if (frames == NULL || free_frames == NULL) {
+        return 1;
+    }
+    // 0 ſҳջఴŴС
+    free_count = 0;
+    for (int f = frame_cap - 1; f > ZERO_FRAME; f--) {
+        free_frames[free_count++] = f;
+    }
+    frames[ZERO_FRAME].file_page = -1;
+    frames_used = 0;
+    for (int i = 0; i < LIB_VPAGES; i++) {
+        lib_cache[i] = -1;
+    }
+    current_time = 0;
+    return 0;
+}
+
+// һ鲢װݣؿţ-1 = ڴ治
+int alloc_frame(unsigned long long content, int file_page) {
+    if (free_count == 0) {
+        int cap = frame_cap * 2;
+        Frame* nf = (Frame*)realloc(frames, (size_t)cap * sizeof(Frame));
+        if (nf == NULL) return -1;
+        frames = nf;
+        int* nl = (int*)realloc(free_frames, (size_t)cap * sizeof(int));
+        if (nl == NULL) return -1;
+        free_frames = nl;
+        for (int f = cap - 1; f >= frame_cap; f--) {
+            free_frames[free_count++] = f;
+        }
+        frame_cap = cap;
+    }
+    int f = free_frames[--free_count];
+    frames[f].ref_count = 1;
+    frames[f].file_page = file_page;
+    frames[f].content = content;
+    frames_used++;
+    return f;
+}
+
+//  f һӳ
+void get_frame(int f) {
+    if (frames[f].ref_count++ == 0) {
+        frames_used++;
+    }
+}
+
+//  f һӳ䣻ûӳ˾ͷţҳͷţֻǲټռã
+void put_frame(int f) {
+    if (--frames[f].ref_count > 0) {
+        return;
+    }
+    frames_used--;
+    if (f == ZERO_FRAME) {
+        return;
+    }
+    if (frames[f].file_page >= 0 && lib_cache[frames[f].file_page] == f) {
+        lib_cache[frames[f].file_page] = -1;
+    }
+    free_frames[free_count++] = f;
+}
+
+// ҳָ ff üѾһ
+void map_page(PageTableEntry* pte, int f, int writable, int cow) {
+    pte->frame_number = f;
+    pte->valid = 1;
+    pte->modified = 0;
+    pte->time_loaded = current_time;
+    pte->writable = writable;
+    pte->cow = cow;
+}
+
+/*
+ * ȱҳ̷ʵҳ v ûӳ
+ * ҳʱҳȡ򵥶װһݣ˽ӳ䣬ֻ + дʱ
+ * ҳʱӳ䵽ҳֻ + дʱƣд¿飻ʱµȫ
+ */
+int page_fault(PageTableEntry* pte, int v, int write) {
+    int f;
+    result->page_faults++;
+    if (v < LIB_VPAGES) {
+        if (result->share && lib_cache[v] != -1) {
+            f = lib_cache[v];
+            get_frame(f);
+        }
+        else {
+            f = alloc_frame(lib_content(v), v);
+            if (f == -1) return 1;
+            if (result->share) lib_cache[v] = f;
+        }
+        map_page(pte, f, 0, 1);
+    }
+    else if (result->share && !write) {
+        get_frame(ZERO_FRAME);
+        map_page(pte, ZERO_FRAME, 0, 1);
+    }
+    else {
+        f = alloc_frame(0, -1);
+        if (f == -1) return 1;
+        map_page(pte, f, 1, 0);
+    }
+    return 0;
+}
+
+// д쳣дʱơֻʣԼõֱӸΪдһ
+int cow_fault(PageTableEntry* pte) {
+    int f = pte->frame_number;
+    if (frames[f].ref_count == 1 && f != ZERO_FRAME && frames[f].file_page == -1) {
+        result->cow_reuse++;
+    }
+    else {
+        int g = alloc_frame(frames[f].content, -1);
+        if (g == -1) return 1;
+        put_frame(f);
+        pte->frame_number = g;
+        result->cow_copies++;
+    }
+    pte->writable = 1;
+    pte->cow = 0;
+    return 0;
+}
+
+//  pid ҳ vдʱݱΪ value 0 = ɹ
+int access_page(int pid, int v, int write, unsigned long long value) {
+    PageTableEntry* pte = &procs[pid].page_table[v];
+    if (!pte->valid && page_fault(pte, v, write) != 0) {
+        return 1;
+    }
+    if (write) {
+        if (!pte->writable && cow_fault(pte) != 0) {
+            return 1;
+        }
+        frames[pte->frame_number].content = value;
+        pte->modified = 1;
+    }
+    return 0;
+}
+
+// forkʱӹ飬дҳ߶ĳдʱƣʱÿһҳ
+int fork_process(int parent, int child) {
+    Process* p = &procs[parent];
+    Process* c = &procs[child];
+    c->alive = 1;
+    for (int v = 0; v < VPAGES; v++) {
+        PageTableEntry* pte = &p->page_table[v];
+        c->page_table[v] = *pte;
+        if (!pte->valid) {
+            continue;
+        }
+        if (result->share) {
+            get_frame(pte->frame_number);
+            if (pte->writable) {
+                pte->writable = 0;
+                pte->cow = 1;
+                c->page_table[v].writable = 0;
+                c->page_table[v].cow = 1;
+            }
+        }
+        else {
+            int f = alloc_frame(frames[pte->frame_number].content, frames[pte->frame_number].file_page);
+            if (f == -1) return 1;
+            c->page_table[v].frame_number = f;
+            c->page_table[v].time_loaded = current_time;
+            result->fork_copies++;
+        }
+    }
+    return 0;
+}
+
+void exit_process(int pid) {
+    for (int v = 0; v < VPAGES; v++) {
+        if (procs[pid].page_table[v].valid) {
+            put_frame(procs[pid].page_table[v].frame_number);
+        }
+    }
+    memset(&procs[pid], 0, sizeof(Process));
+}
+
+/*
+ * KSM ɨ裺ȫҳҳͬҳһμһ飻
+ * ֮󱻶ҳõĿڸҳﶼĳֻ + дʱơ
+ * ʵ KSM Ҫҳɨ֮ûźϲʡԣ
+ */
+int ksm_scan() {
+    int need = 1;
+    while (need < 2 * frame_cap) need *= 2;
+    if (need > ksm_cap) {
+        free(ksm_keys);
+        free(ksm_frames);
+        ksm_keys = (unsigned long long*)malloc((size_t)need * sizeof(unsigned long long));
+        ksm_frames = (int*)malloc((size_t)need * sizeof(int));
+        if (ksm_keys == NULL || ksm_frames == NULL) {
+            ksm_cap = 0;
+            return 1;
+        }
+        ksm_cap = need;
+    }
+    for (int k = 0; k < ksm_cap; k++) {
+        ksm_frames[k] = -1;
+    }
+
+    for (int pid = 0; pid < MAX_PROCS; pid++) {
+        if (!procs[pid].alive) continue;
+        for (int v = LIB_VPAGES; v < VPAGES; v++) {
+            PageTableEntry* pte = &procs[pid].page_table[v];
+            int f = pte->frame_number, target;
+            if (!pte->valid || f == ZERO_FRAME) continue;
+            if (frames[f].content == 0) {
+                target = ZERO_FRAME;
+                result->zero_merges++;
+            }
+            else {
+                unsigned long long c = frames[f].content;
+                int k = (int)((c * 0x9E3779B97F4A7C15ULL) >> 40) & (ksm_cap - 1);
+                while (ksm_frames[k] != -1 && ksm_keys[k] != c) {
+                    k = (k + 1) & (ksm_cap - 1);
+                }
+                if (ksm_frames[k] == -1) {
+                    ksm_keys[k] = c;
+                    ksm_frames[k] = f;
+                    continue;
+                }
+                target = ksm_frames[k];
+                if (target == f) continue;
+                result->ksm_merges++;
+            }
+            get_frame(target);
+            put_frame(f);
+            pte->frame_number = target;
+            pte->writable = 0;
+            pte->cow = 1;
+        }
+    }
+    for (int pid = 0; pid < MAX_PROCS; pid++) {
+        if (!procs[pid].alive) continue;
+        for (int v = LIB_VPAGES; v < VPAGES; v++) {
+            PageTableEntry* pte = &procs[pid].page_table[v];
+            if (pte->valid && pte->writable && frames[pte->frame_number].ref_count > 1) {
+                pte->writable = 0;
+                pte->cow = 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// ڸһã 0 = ɹ
+int simulate(const TraceOp* ops, int count, SimResult* res) {
+    double sum = 0;
+    result = res;
+    res->peak_frames = 0;
+    if (reset_memory() != 0) {
+        return 1;
+    }
+    procs[0].alive = 1;
+    for (int i = 0; i < count; i++) {
+        const TraceOp* op = &ops[i];
+        int error = 0;
+        current_time = i + 1;
+        switch (op->type) {
+        case OP_FORK:  error = fork_process(op->pid, op->arg); break;
+        case OP_READ:  error = access_page(op->pid, op->arg, 0, 0); break;
+        case OP_WRITE: error = access_page(op->pid, op->arg, 1, op->value); break;
+        default:       exit_process(op->pid); break;
+        }
+        if (error == 0 && res->ksm > 0 && current_time % res->ksm == 0) {
+            error = ksm_scan();
+        }
+        if (error != 0) {
+            return 1;
+        }
+        sum += frames_used;
+        if (frames_used > res->peak_frames) {
+            res->peak_frames = frames_used;
+        }
+    }
+    res->avg_frames = count > 0 ? sum / count : 0;
+    return 0;
+}
+
+/* ---------------- ٵȡ ---------------- */
+
+static unsigned long long rng_state;
+
+// splitmix64
+static unsigned int next_random() {
+    unsigned long long z = (rng_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+/*
+ * һ̸٣ 0 һʼڣÿһŵĽ
+ * fork4% max_live ̣˳3% 0 ˳һҳ
+ * ҳֻҳ 40% дд 10% Ϊȫ㡢30% ȡ 16 ֵͬ
+ */
+int generate_trace(TraceOp* ops, int count, int max_live, unsigned long long seed) {
+    int live[MAX_PROCS], nlive = 1, used[MAX_PROCS] = { 0 };
+    rng_state = seed;
+    live[0] = 0;
+    used[0] = 1;
+    for (int i = 0; i < count; i++) {
+        TraceOp* op = &ops[i];
+        int r = (int)(next_random() % 100);
+        int k = (int)(next_random() % (unsigned int)nlive);
+        op->pid = live[k];
+        op->value = 0;
+        if (r < 4 && nlive < max_live) {
+            int child = 0;
+            while (used[child]) child++;
+            used[child] = 1;
+            live[nlive++] = child;
+            op->type = OP_FORK;
+            op->arg = child;
+        }
+        else if (r < 7 && nlive > 1 && live[k] != 0) {
+            used[live[k]] = 0;
+            live[k] = live[--nlive];
+            op->type = OP_EXIT;
+            op->arg = 0;
+        }
+        else {
+            int lib = next_random() % 100 < 30;
+            op->arg = lib ? (int)(next_random() % LIB_VPAGES)
+                          : LIB_VPAGES + (int)(next_random() % (VPAGES - LIB_VPAGES));
+            op->type = next_random() % 100 < (lib ? 2u : 40u) ? OP_WRITE : OP_READ;
+            if (op->type == OP_WRITE) {
+                int v = (int)(next_random() % 100);
+                op->value = v < 10 ? 0 : v < 40 ? 1 + next_random() % 16
+                    : ((unsigned long long)next_random() << 32 | next_random()) | 0x100;
+            }
+        }
+    }
+    return count;
+}
+
+/*
+ * ļı# ͷעͣÿһ
+ *   fork  ӽ / read  ҳ / write  ҳ  / exit 
+ *  0 һʼʹڡضĲ-1 = ʽ*line Ϊкţ
+ */
+int read_trace(FILE* f, TraceOp** out, int* line) {
+    char buf[256], word[16];
+    int alive[MAX_PROCS] = { 0 }, count = 0, cap = 1024;
+    TraceOp* ops = (TraceOp*)malloc((size_t)cap * sizeof(TraceOp));
+    alive[0] = 1;
+    *line = 0;
+    while (ops != NULL && fgets(buf, sizeof(buf), f) != NULL) {
+        TraceOp op;
+        int a, b, ok;
+        (*line)++;
+        if (sscanf(buf, "%15s", word) != 1 || word[0] == '#') continue;
+        memset(&op, 0, sizeof(op));
+        if (strcmp(word, "fork") == 0) {
+            ok = sscanf(buf, "%*s %d %d", &a, &b) == 2 && a >= 0 && a < MAX_PROCS && b >= 0 && b < MAX_PROCS &&
+                alive[a] && !alive[b];
+            op.type = OP_FORK;
+            if (ok) alive[b] = 1;
+        }
+        else if (strcmp(word, "read") == 0) {
+            ok = sscanf(buf, "%*s %d %d", &a, &b) == 2;
+            op.type = OP_READ;
+        }
+        else if (strcmp(word, "write") == 0) {
+            ok = sscanf(buf, "%*s %d %d %llu", &a, &b, &op.value) == 3;
+            op.type = OP_WRITE;
+        }
+        else if (strcmp(word, "exit") == 0) {
+            ok = sscanf(buf, "%*s %d", &a) == 1 && a > 0 && a < MAX_PROCS && alive[a];
+            b = 0;
+            op.type = OP_EXIT;
+            if (ok) alive[a] = 0;
+        }
+        else {
+            ok = 0;
+        }
+        if (ok && (op.type == OP_READ || op.type == OP_WRITE)) {
+            ok = a >= 0 && a < MAX_PROCS && alive[a] && b >= 0 && b < VPAGES;
+        }
+        if (!ok) {
+            free(ops);
+            return -1;
+        }
+        op.pid = a;
+        op.arg = b;
+        if (count == cap) {
+            TraceOp* p = (TraceOp*)realloc(ops, (size_t)cap * 2 * sizeof(TraceOp));
+            if (p == NULL) break;
+            ops = p;
+            cap *= 2;
+        }
+        ops[count++] = op;
+    }
+    if (ops == NULL || !feof(f)) {
+        free(ops);
+        *line = 0;
+        return -1;
+    }
+    *out = ops;
+    return count;
+}
+
+void write_trace(FILE* f, const TraceOp* ops, int count) {
+    fprintf(f, "# page sharing trace: %d ops\n", count);
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_FORK:  fprintf(f, "fork %d %d\n", ops[i].pid, ops[i].arg); break;
+        case OP_READ:  fprintf(f, "read %d %d\n", ops[i].pid, ops[i].arg); break;
+        case OP_WRITE: fprintf(f, "write %d %d %llu\n", ops[i].pid, ops[i].arg, ops[i].value); break;
+        default:       fprintf(f, "exit %d\n", ops[i].pid); break;
+        }
+    }
+}
+
+int main() {
+    int choice, count, ksm_interval;
+    TraceOp* ops = NULL;
+    char path[256];
+
+    printf("========== ҳ湲ģ⣺дʱơ⡢ҳ KSM ==========\n");
+    printf("ÿ %d ҳǰ %d ҳӳ乲\n", VPAGES, LIB_VPAGES);
+    printf("ѡ1 = ɸ  2 = ļȡ٣");
+    if (scanf("%d", &choice) != 1 || (choice != 1 && choice != 2)) {
+        printf("\n");
+        return 1;
+    }
+    if (choice == 1) {
+        int max_live;
+        unsigned long long seed;
+        printf("  ͬʱڵĽ(<= %d) ӣ", MAX_PROCS);
+        if (scanf("%d %d %llu", &count, &max_live, &seed) != 3 || count <= 0 || max_live <= 0 ||
+            max_live > MAX_PROCS) {
+            printf("\n");
+            return 1;
+        }
+        ops = (TraceOp*)malloc((size_t)count * sizeof(TraceOp));
+        if (ops == NULL) {
+            printf("ڴ治\n");
+            return 1;
+        }
+        generate_trace(ops, count, max_live, seed);
+        printf("Ѹٱ浽ļ- ʾ棩");
+        if (scanf("%255s", path) == 1 && strcmp(path, "-") != 0) {
+            FILE* f = fopen(path, "w");
+            if (f == NULL) {
+                printf("޷д %s\n", path);
+            }
+            else {
+                write_trace(f, ops, count);
+                fclose(f);
+            }
+        }
+    }
+    else {
+        int line;
+        printf("ļ");
+        if (scanf("%255s", path) != 1) {
+            printf("\n");
+            return 1;
+        }
+        FILE* f = fopen(path, "r");
+        if (f == NULL) {
+            printf("޷ %s\n", path);
+            return 1;
+        }
+        count = read_trace(f, &ops, &line);
+        fclose(f);
+        if (count < 0) {
+            if (line > 0) printf(" %d иʽ\n", line);
+            else printf("ڴ治\n");
+            return 1;
+        }
+    }
+    printf("KSM ɨÿٴβɨһ飩");
+    if (scanf("%d", &ksm_interval) != 1 || ksm_interval <= 0) {
+        printf("\n");
+        free(ops);
+        return 1;
+    }
+
+    long long n_op[4] = { 0 };
+    for (int i = 0; i < count; i++) {
+        n_op[ops[i].type]++;
+    }
+    printf("\n٣%d fork %lld Σ˳ %lld Σ %lld Σд %lld \n",
+        count, n_op[OP_FORK], n_op[OP_EXIT], n_op[OP_READ], n_op[OP_WRITE]);
+
+    static const char* const NAMES[3] = { "fork ƣ", "дʱ +  + ҳ", "ټ KSM ϲ" };
+    SimResult res[3];
+    memset(res, 0, sizeof(res));
+    res[1].share = 1;
+    res[2].share = 1;
+    res[2].ksm = ksm_interval;
+    for (int k = 0; k < 3; k++) {
+        if (simulate(ops, count, &res[k]) != 0) {
+            printf("ڴ治\n");
+            free(ops);
+            return 1;
+        }
+    }
+
+    printf("\n\t\t\t\tֵ\tƽ\tʡ(ƽ)\tȱҳ\tfork\tCOW\tCOWֱд\tҳ\tͬҳϲ\n");
+    for (int k = 0; k < 3; k++) {
+        const SimResult* r = &res[k];
+        printf("%-28s\t%d\t\t%.1f\t\t%5.1f%%\t\t%lld\t%lld\t\t%lld\t%lld\t\t%lld\t\t%lld\n", NAMES[k],
+            r->peak_frames, r->avg_frames,
+            res[0].avg_frames > 0 ? 100.0 * (1 - r->avg_frames / res[0].avg_frames) : 0.0,
+            r->page_faults, r->fork_copies, r->cow_copies, r->cow_reuse, r->zero_merges, r->ksm_merges);
+    }
+    printf("\nʡ飺дʱ +  + ҳ ƽ %.1f 顢ֵ %d 飻ټ KSM ƽ %.1f 顢ֵ %d \n",
+        res[0].avg_frames - res[1].avg_frames, res[0].peak_frames - res[1].peak_frames,
+        res[0].avg_frames - res[2].avg_frames, res[0].peak_frames - res[2].peak_frames);
+    printf("дʱư fork ʱ %lld θƳٵд룬ʵֻ %lld ҳ %lld дʱѶռøƣ\n",
+        res[0].fork_copies, res[1].cow_copies, res[1].cow_reuse);
+    printf("KSM ֶ %lld дʱ\n", res[2].cow_copies - res[1].cow_copies);
+
+    free(ops);
+    free(frames);
+    free(free_frames);
+    free(ksm_keys);
+    free(ksm_frames);
+    return 0;
+}
@@ -1,25 +1,21 @@
+/*
+ * OPT ҳûģ
+ * ûģ paging.c ɣPG_OPTֻ롢ʾ͵ַתʾ
+ * 룺gcc -O2 -I ../ģ 001.c ../ģ/paging.c -o opt
+ */
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
+#include "paging.h"
 
 #define MAX_REF_LEN   100     // ҳô󳤶
 #define MAX_FRAMES    10      // 
 #define MAX_VPAGES    100     // ҳҳС
 
-/* ҳṹ */
+/* ʾõģframes Ľֻͬڴӡ */
 typedef struct {
-    int frame_no;   // 
-    int valid;      // Чλ1=ڴУ0=
-} PageTableEntry;
-
-/* вĳҳҵ֡±꣬ûҵ -1 */
-int findInFrames(int frames[], int frame_count, int page) {
-    for (int i = 0; i < frame_count; i++) {
-        if (frames[i] == page) {
-            return i;
-        }
-    }
-    return -1;
-}
+    int frames[MAX_FRAMES];     // еҳ
+    int frame_count;            // 
+} Display;
 
 /* ӡǰ */
 void printFrames(int frames[], int frame_count) {
@@ -33,57 +29,33 @@ void printFrames(int frames[], int frame_count) {
     printf("\n");
 }
 
-/*
- * OPT Ԥ⺯
- * ref_str     ҳô
- * ref_len     ôܳ
- * frames      ǰдҳ
- * frame_count 
- * current_idx ǰʵô±
- *
- * أӦñ滻±
- */
-int predictOPT(int ref_str[], int ref_len,
-    int frames[], int frame_count,
-    int current_idx) {
-    int farthest = current_idx;   // ¼Զ´ʹλá±
-    int victim_index = -1;        // ҪûĿ±
+/* صӡһηʵḶ́ʾõ */
+void onAccess(void* user, const PgEvent* ev) {
+    Display* d = (Display*)user;
 
-    for (int i = 0; i < frame_count; i++) {
-        int page = frames[i];
-        int j;
-        int found_in_future = 0;
-
-        // δвҸҳ
-        for (j = current_idx + 1; j < ref_len; j++) {
-            if (ref_str[j] == page) {
-                found_in_future = 1;
-                // ԽԶԽáΪƷ
-                if (j > farthest) {
-                    farthest = j;
-                    victim_index = i;
-                }
-                break;
-            }
+    printf("ʵ %lld Σҳ %d\n", ev->time, ev->page);
+    if (!ev->fault) {
+        printf("-> ҳ %d  %d УС\n", ev->page, ev->frame);
+    }
+    else {
+        printf("-> ҳ %d ڴ棬ȱҳ\n", ev->page);
+        if (ev->victim == -1) {
+            printf("   ʹÿ %d װҳ %d\n", ev->frame, ev->page);
         }
-
-        // ҳԺҲᱻʣõƷ
-        if (!found_in_future) {
-            return i;
+        else {
+            printf("   ʹ OPT 㷨ѡҳҳ %d %d\n",
+                ev->victim, ev->frame);
+            printf("   滻 %d װҳ %d\n", ev->frame, ev->page);
         }
+        d->frames[ev->frame] = ev->page;
     }
 
-    // ҳᱻʣ victim_index Ȼû£
-    // Ǿѡһѡ 0ϼٳ֣
-    if (victim_index == -1) {
-        victim_index = 0;
-    }
-
-    return victim_index;
+    printFrames(d->frames, d->frame_count);
+    printf("----------------------------------------\n");
 }
 
 /* ģ߼ַַת */
-void translateAddress(PageTableEntry page_table[], int page_size) {
+void translateAddress(const PagingSim* pg, int page_size) {
     int logical_addr;
 
     printf("\n===== ַתʾ =====\n");
@@ -98,11 +70,11 @@ void translateAddress(PageTableEntry page_table[], int page_size) {
         if (page < 0 || page >= MAX_VPAGES) {
             printf("ҳųҳΧ޷ת\n");
         }
-        else if (!page_table[page].valid) {
+        else if (pg_frame_of(pg, page) == -1) {
             printf("ҳ %d ڴУҳЧλ=0ȱҳ\n", page);
         }
         else {
-            int frame_no = page_table[page].frame_no;
+            int frame_no = pg_frame_of(pg, page);
             int physical_addr = frame_no * page_size + offset;
             printf("ҳpage %d -> frame %d\n", page, frame_no);
             printf("ַ = ֡ * ҳС + ƫ = %d * %d + %d = %d\n",
@@ -118,17 +90,9 @@ void translateAddress(PageTableEntry page_table[], int page_size) {
 int main() {
     int ref_len;                   // ҳô
     int ref_str[MAX_REF_LEN];      // ҳô
-    int frame_count;               // 
-    int frames[MAX_FRAMES];        // еҳ
-    PageTableEntry page_table[MAX_VPAGES]; // ҳ
+    Display d;                     // ʾ
     int page_size = 1024;          // ҳСֽڣɸҪ޸
 
-    // ʼҳ
-    for (int i = 0; i < MAX_VPAGES; i++) {
-        page_table[i].valid = 0;
-        page_table[i].frame_no = -1;
-    }
-
     // 
     printf("===== OPT ҳû㷨ģ =====\n");
     printf("ҳôȣ<=%d", MAX_REF_LEN);
@@ -150,80 +114,43 @@ int main() {
     }
 
     printf("<=%d", MAX_FRAMES);
-    scanf("%d", &frame_count);
+    scanf("%d", &d.frame_count);
 
-    if (frame_count <= 0 || frame_count > MAX_FRAMES) {
+    if (d.frame_count <= 0 || d.frame_count > MAX_FRAMES) {
         printf("Ƿ\n");
         return 1;
     }
 
     // ʼΪ
-    for (int i = 0; i < frame_count; i++) {
-        frames[i] = -1;  // -1 ʾ֡Ϊ
+    for (int i = 0; i < d.frame_count; i++) {
+        d.frames[i] = -1;  // -1 ʾ֡Ϊ
     }
 
-    int page_faults = 0;  // ȱҳ
-    int used_frames = 0;  // Ѿռõ
+    // ûģɣҳҲ
+    PagingSim* pg = pg_create(PG_OPT, d.frame_count, MAX_VPAGES, 0);
+    if (pg == NULL) {
+        printf("ڴ治㡣\n");
+        return 1;
+    }
+    pg_set_callback(pg, onAccess, &d);
 
     printf("\nʼģ OPT ҳû...\n\n");
 
-    for (int i = 0; i < ref_len; i++) {
-        int page = ref_str[i];
-        printf("ʵ %d Σҳ %d\n", i + 1, page);
-
-        // 1. ҸҳǷѾ
-        int frame_index = findInFrames(frames, frame_count, page);
-
-        if (frame_index != -1) {
-            // 
-            printf("-> ҳ %d  %d УС\n", page, frame_index);
-        }
-        else {
-            // ȱҳ
-            page_faults++;
-            printf("-> ҳ %d ڴ棬ȱҳ\n", page);
-
-            // 2. п飬ֱװ
-            if (used_frames < frame_count) {
-                frames[used_frames] = page;
-                page_table[page].valid = 1;
-                page_table[page].frame_no = used_frames;
-
-                printf("   ʹÿ %d װҳ %d\n", used_frames, page);
-                used_frames++;
-            }
-            else {
-                // 3. ûп飬ʹ OPT 㷨ѡһҳ
-                int victim = predictOPT(ref_str, ref_len, frames, frame_count, i);
-                int victim_page = frames[victim];
-
-                printf("   ʹ OPT 㷨ѡҳҳ %d %d\n",
-                    victim_page, victim);
-
-                // ҳԭҳʧЧ
-                page_table[victim_page].valid = 0;
-                page_table[victim_page].frame_no = -1;
-
-                // ҳװ
-                frames[victim] = page;
-                page_table[page].valid = 1;
-                page_table[page].frame_no = victim;
-
-                printf("   滻 %d װҳ %d\n", victim, page);
-            }
-        }
-
-        printFrames(frames, frame_count);
-        printf("----------------------------------------\n");
+    long long page_faults = pg_run(pg, ref_str, ref_len);  // ȱҳ
+    if (page_faults < 0) {
+        printf("ڴ治㡣\n");
+        pg_destroy(pg);
+        return 1;
     }
 
     printf("\n===== ģ =====\n");
     printf("ܷʴ%d\n", ref_len);
-    printf("ȱҳ  %d\n", page_faults);
+    printf("ȱҳ  %lld\n", page_faults);
     printf("ȱҳ    %.2f%%\n", (page_faults * 100.0) / ref_len);
 
     // ַתʾ
-    translateAddress(page_table, page_size);
+    translateAddress(pg, page_size);
 
+    pg_destroy(pg);
     return 0;
 }
@@ -1,5 +1,12 @@
+/*
+ * FIFO ҳûģ
+ * ûģ paging.c ɣPG_FIFOҳڴֻʾ
+ * صﰴÿηʵĽͬ
+ * 룺gcc -O2 -I ../ģ 1.c ../ģ/paging.c -o fifo
+ */
 #include <stdio.h>
 #include <stdlib.h>
+#include "paging.h"
 
 #define MAX_PAGES 20      // ҳ
 #define MAX_FRAMES 10     // 
@@ -26,26 +33,30 @@ typedef struct {
 } Frame;
 
 // ȫֱ
-PageTableEntry page_table[MAX_PAGES];  // ҳ
-Frame physical_memory[MAX_FRAMES];     // ڴ
+PagingSim* pager;                      // û
+PageTableEntry page_table[MAX_PAGES];  // ҳʾã
+Frame physical_memory[MAX_FRAMES];     // ڴ棨ʾã
 int page_fault_count = 0;              // ȱҳ
 int memory_access_count = 0;           // ڴʴ
 int current_time = 0;                  // ǰʱ
 
 // 
-void initialize_system();
+int initialize_system();
 void print_page_table();
 void print_physical_memory();
 int logical_to_physical(int logical_address);
-void handle_page_fault(int page_number);
-int find_victim_page();
+void on_page_event(void* user, const PgEvent* ev);
+void handle_page_fault(const PgEvent* ev);
 void simulate_memory_access();
 
 int main() {
     printf("========== FIFOҳû㷨ģϵͳ ==========\n\n");
 
     // ʼϵͳ
-    initialize_system();
+    if (!initialize_system()) {
+        printf("ڴ治!\n");
+        return 1;
+    }
 
     // ʾʼ״̬
     printf("ϵͳʼ:\n");
@@ -56,15 +67,23 @@ int main() {
     // ģڴ
     simulate_memory_access();
 
+    pg_destroy(pager);
+
     printf("˳...");
     getchar();
     return 0;
 }
 
-// ʼϵͳ
-void initialize_system() {
+// ʼϵͳɹ TRUE
+int initialize_system() {
     int i;
 
+    pager = pg_create(PG_FIFO, MAX_FRAMES, MAX_PAGES, 0);
+    if (pager == NULL) {
+        return FALSE;
+    }
+    pg_set_callback(pager, on_page_event, NULL);
+
     // ʼҳ
     for (i = 0; i < MAX_PAGES; i++) {
         page_table[i].frame_number = -1;  // δ
@@ -79,6 +98,7 @@ void initialize_system() {
         physical_memory[i].occupied = FALSE;  // δռ
         physical_memory[i].load_time = -1;    // δװ
     }
+    return TRUE;
 }
 
 // ӡҳ
@@ -143,16 +163,8 @@ int logical_to_physical(int logical_address) {
         return -1;
     }
 
-    // ҳǷڴ
-    if (!page_table[page_number].valid) {
-        printf("ȱҳж! ҳ %d ڴ\n", page_number);
-        handle_page_fault(page_number);
-        page_fault_count++;
-    }
-    else {
-        printf("ҳ! ҳ %d  %d \n",
-            page_number, page_table[page_number].frame_number);
-    }
+    // ʣлȱҳĴ on_page_event дӡ
+    pg_access(pager, page_number);
 
     // ַ
     frame_number = page_table[page_number].frame_number;
@@ -164,32 +176,33 @@ int logical_to_physical(int logical_address) {
     return physical_address;
 }
 
-// ȱҳж
-void handle_page_fault(int page_number) {
-    int free_frame = -1;
-    int i;
-    int victim_page;
+// صӡʽȱҳʱͬҳڴ
+void on_page_event(void* user, const PgEvent* ev) {
+    (void)user;
+    if (ev->fault) {
+        printf("ȱҳж! ҳ %d ڴ\n", ev->page);
+        handle_page_fault(ev);
+        page_fault_count++;
+    }
+    else {
+        printf("ҳ! ҳ %d  %d \n", ev->page, ev->frame);
+    }
+}
 
-    printf("ڴҳ %d ȱҳ...\n", page_number);
+// ȱҳжϣѡ飬ӡ̲ҳڴ
+void handle_page_fault(const PgEvent* ev) {
+    int page_number = ev->page;
+    int free_frame = ev->frame;
+    int victim_page = ev->victim;
 
-    // ҿ
-    free_frame = -1;
-    for (i = 0; i < MAX_FRAMES; i++) {
-        if (!physical_memory[i].occupied) {
-            free_frame = i;
-            break;
-        }
-    }
+    printf("ڴҳ %d ȱҳ...\n", page_number);
 
-    if (free_frame != -1) {
+    if (victim_page == -1) {
         // пп飬ֱӷ
         printf("ҵ %dҳ %d\n", free_frame, page_number);
     }
     else {
-        // ûпп飬ʹFIFOѡûҳ
-        free_frame = find_victim_page();
-        victim_page = physical_memory[free_frame].page_number;
-
+        // ûпп飬水FIFOûװҳ
         printf("ʹFIFO㷨û: ҳ %d ( %d) -> ҳ %d\n",
             victim_page, free_frame, page_number);
 
@@ -215,24 +228,6 @@ void handle_page_fault(int page_number) {
     printf("ҳ %d װ %d\n", page_number, free_frame);
 }
 
-// ʹFIFO㷨ѡûҳ
-int find_victim_page() {
-    int oldest_time = current_time + 1;
-    int victim_frame = -1;
-    int i;
-
-    // װҳ
-    for (i = 0; i < MAX_FRAMES; i++) {
-        if (physical_memory[i].occupied &&
-            physical_memory[i].load_time < oldest_time) {
-            oldest_time = physical_memory[i].load_time;
-            victim_frame = i;
-        }
-    }
-
-    return victim_frame;
-}
-
 // ģڴ
 void simulate_memory_access() {
     int access_sequence[] = {
@@ -1,48 +1,80 @@
+/*
+ * LRU ҳû / פģ
+ * ûפģ paging.c ɣֻ롢ʾͳ
+ * иļʱlru trace.jsonģд Chrome trace trace.h
+ *  k ηʵʱΪ kÿ֡һʾȺװЩҳһȱҳͻ
+ * 룺gcc -O2 -pthread -I ../ģ 0.c ../ģ/paging.c ../ģ/trace.c -o lru
+ */
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
 #include <stdlib.h>
+#include "paging.h"
+#include "trace.h"
 
 #define MAX_PAGES   1024   // ҳҪɵ
 #define MAX_FRAMES  32     // ֡
 #define MAX_REF     1000   // ʴ
 
+// ٹ0 Ϊȱҳͻ֡ f Ϊ f + 1
+#define TRACE_PID   1
+#define TRACK_FAULT 0
+
+// פ
+#define POLICY_LRU  1      // ̶֡ + LRU û
+#define POLICY_WS   2      //  ӣ
+#define POLICY_PFF  3      // ȱҳƵʣֵ T
+
+// һģͳƽ
 typedef struct {
-    int frame;      // ҳڵ֡
-    int valid;      // Чλ1=ڴ棬0=
-    int last_used;  // һηʵʱ
-} PageTableEntry;
+    int hits;
+    int page_faults;
+    long long resident_sum;   // ÿηʺפС֮ͣƽ
+    int resident_peak;        // פֵ
+} SimStats;
 
-PageTableEntry page_table[MAX_PAGES];
-int phys_mem[MAX_FRAMES];      // phys_mem[frame] = page_no-1 ʾ֡У
+// ˵ -> 
+static const int ENGINE_POLICY[] = { 0, PG_LRU, PG_WS, PG_PFF };
 
-int frame_count;               // ʵʹõ֡
+int phys_mem[MAX_FRAMES];      // phys_mem[frame] = page_no-1 ʾ֡Уֻʾÿηʺͬ
+int loaded_at[MAX_FRAMES];     // ֡ҳǵڼηʱװģֻڸ
+TrRing* trace_ring;            // Ϊ NULL ʱģд
+
+int frame_count;               // ʵʹõ֡WS/PFF Ϊפޣ
 int page_size;                 // ҳСֽڣ
-int time_counter = 0;          // ȫ֡ʱ䡱ÿη+1
 
-// ҿ֡֡ţ޿֡ -1
-int find_free_frame() {
-    for (int i = 0; i < frame_count; i++) {
-        if (phys_mem[i] == -1) {
-            return i;
-        }
-    }
-    return -1;
+// صһηʵĽ
+void on_access(void* user, const PgEvent* ev) {
+    *(PgEvent*)user = *ev;
 }
 
-// LRU valid==1 ҳУ last_used Сҳ
-int find_victim_lru(int max_page_index) {
-    int victim_page = -1;
-    int min_time = 0x7fffffff;
-
-    for (int p = 0; p <= max_page_index && p < MAX_PAGES; p++) {
-        if (page_table[p].valid == 1) {
-            if (page_table[p].last_used < min_time) {
-                min_time = page_table[p].last_used;
-                victim_page = p;
+/*
+ * ״̬ͬ phys_memstep Ϊǵڼη
+ * ֡ԭҳѲڸ֡˱û ev->victimפƳģ
+ * ֡˳ trimmed[]Ƴҳ
+ */
+int sync_frames(const PagingSim* pg, const PgEvent* ev, int trimmed[], int step) {
+    int n = 0;
+    for (int i = 0; i < frame_count; i++) {
+        int p = phys_mem[i];
+        if (p != -1 && pg_frame_of(pg, p) != i) {
+            if (p != ev->victim) {
+                trimmed[n++] = p;
+            }
+            if (trace_ring != NULL) {
+                tr_slice(trace_ring, TRACE_PID, i + 1, loaded_at[i], step - loaded_at[i], "P", p);
+                tr_instant(trace_ring, TRACE_PID, TRACK_FAULT, step, "evict P", p, "frame", i);
             }
+            phys_mem[i] = -1;
+        }
+    }
+    if (ev->fault) {
+        phys_mem[ev->frame] = ev->page;
+        loaded_at[ev->frame] = step;
+        if (trace_ring != NULL) {
+            tr_instant(trace_ring, TRACE_PID, TRACK_FAULT, step, "fault P", ev->page, "frame", ev->frame);
         }
     }
-    return victim_page;
+    return n;
 }
 
 // ӡǰڴи֡
@@ -59,20 +91,185 @@ void print_frames() {
     printf("\n");
 }
 
-int main() {
-    int ref_count;
-    int logical_addrs[MAX_REF];
+/*
+ * Էʴһģ⣬ûפģ paging.c 
+ * policyPOLICY_LRU / POLICY_WS / POLICY_PFF
+ * param WS Ĵ ӣ PFF ȱҳֵ TLRU ԣ
+ * verbose1=δӡʹ̣0=ֻͳ
+ * ֵ0=1=
+ */
+int simulate(int logical_addrs[], int ref_count, int policy, int param,
+    int verbose, SimStats* st) {
+    int trimmed[MAX_FRAMES];
+    PgEvent ev;
+    PgStats ps;
+    PagingSim* pg = pg_create(ENGINE_POLICY[policy], frame_count, MAX_PAGES,
+        policy == POLICY_LRU ? 0 : param);
 
-    // ʼҳڴ
-    for (int i = 0; i < MAX_PAGES; i++) {
-        page_table[i].frame = -1;
-        page_table[i].valid = 0;
-        page_table[i].last_used = 0;
+    if (pg == NULL) {
+        printf("ڴ治㣡\n");
+        return 1;
     }
-    for (int i = 0; i < MAX_FRAMES; i++) {
-        phys_mem[i] = -1;   // -1 ʾ֡Ϊ
+    if (verbose) {
+        pg_set_callback(pg, on_access, &ev);
+        for (int i = 0; i < MAX_FRAMES; i++) {
+            phys_mem[i] = -1;   // -1 ʾ֡Ϊ
+        }
+        printf("\n===== ʼģ =====\n\n");
+        printf(" | ߼ַ | ҳ | ƫ |     | ̭ҳ | ַ   | פ\n");
+        printf("-------------------------------------------------------------------------\n");
     }
 
+    for (int i = 0; i < ref_count; i++) {
+        int logical_addr = logical_addrs[i];
+        int page = logical_addr / page_size;
+        int offset = logical_addr % page_size;
+
+        if (page >= MAX_PAGES) {
+            printf("ʵҳ %d  MAX_PAGES=%dֹ\n", page, MAX_PAGES);
+            pg_destroy(pg);
+            return 1;
+        }
+        pg_access(pg, page);
+
+        if (!verbose) {
+            continue;
+        }
+
+        int n_trimmed = sync_frames(pg, &ev, trimmed, i);
+        int phys_addr = ev.frame * page_size + offset;
+
+        // ηϢ
+        printf("%3d  | %8d | %3d | %6d | ", i + 1, logical_addr, page, offset);
+        if (!ev.fault) {
+            printf("   |   --    | %10d", phys_addr);
+        }
+        else {
+            if (ev.victim == -1) {
+                printf("ȱҳ   |  ֡ | %10d", phys_addr);
+            }
+            else {
+                printf("ȱҳ   | %7d | %10d", ev.victim, phys_addr);
+            }
+        }
+        printf(" | %4d\n", ev.resident);
+
+        if (n_trimmed > 0) {
+            printf("  פƳҳ: ");
+            for (int k = 0; k < n_trimmed; k++) {
+                printf("%d ", trimmed[k]);
+            }
+            printf("\n");
+        }
+
+        // ӡǰڴ֡
+        print_frames();
+        printf("\n");
+    }
+
+    if (verbose && trace_ring != NULL) {
+        // ʱ֡ҳ
+        for (int i = 0; i < frame_count; i++) {
+            if (phys_mem[i] != -1) {
+                tr_slice(trace_ring, TRACE_PID, i + 1, loaded_at[i], ref_count - loaded_at[i], "P", phys_mem[i]);
+            }
+        }
+    }
+    pg_get_stats(pg, &ps);
+    st->hits = (int)(ps.accesses - ps.faults);
+    st->page_faults = (int)ps.faults;
+    st->resident_sum = ps.resident_sum;
+    st->resident_peak = ps.resident_peak;
+    pg_destroy(pg);
+    return 0;
+}
+
+// һģͳƽ
+void print_stats(int ref_count, const SimStats* st) {
+    printf("===== ģ =====\n");
+    printf("ܷʴ: %d\n", ref_count);
+    printf("д  : %d\n", st->hits);
+    printf("ȱҳ  : %d\n", st->page_faults);
+    double hit_rate = ref_count > 0 ? (double)st->hits / ref_count : 0.0;
+    double miss_rate = ref_count > 0 ? (double)st->page_faults / ref_count : 0.0;
+    double avg_resident = ref_count > 0 ? (double)st->resident_sum / ref_count : 0.0;
+    printf("    : %.4f\n", hit_rate);
+    printf("ȱҳ    : %.4f\n", miss_rate);
+    printf("ƽפ: %.2f ҳ\n", avg_resident);
+    printf("פֵ: %d ҳ\n", st->resident_peak);
+}
+
+/*
+ * ɨ裺 WS    PFF  T ȡ 1..max_param
+ * ȱҳƽפ۲ﵽĿȱҳڴ
+ */
+int sweep_params(int logical_addrs[], int ref_count, int max_param) {
+    SimStats ws, pff;
+
+    printf("\n===== ɨ裨פ = %d ֡=====\n", frame_count);
+    printf(" | WS ȱҳ | WS ƽפ | PFF ȱҳ | PFF ƽפ\n");
+    printf("--------------------------------------------------------------\n");
+    for (int param = 1; param <= max_param; param++) {
+        if (simulate(logical_addrs, ref_count, POLICY_WS, param, 0, &ws) != 0 ||
+            simulate(logical_addrs, ref_count, POLICY_PFF, param, 0, &pff) != 0) {
+            return 1;
+        }
+        printf("%4d | %9.4f | %13.2f | %10.4f | %14.2f\n", param,
+            (double)ws.page_faults / ref_count,
+            (double)ws.resident_sum / ref_count,
+            (double)pff.page_faults / ref_count,
+            (double)pff.resident_sum / ref_count);
+    }
+    return 0;
+}
+
+// ģһβͳƣtracer Ϊ NULL ʱʱдļ path
+int run_traced(Tracer* tracer, const char* path, int logical_addrs[], int ref_count,
+    int policy, int param) {
+    static const char* const NAMES[] = { "", "LRU", "WS", "PFF" };
+    SimStats st;
+    TrStats ts;
+    char name[64];
+
+    if (tracer != NULL) {
+        trace_ring = tr_ring(tracer);
+        if (trace_ring == NULL) {
+            printf("ڴ治㣡\n");
+            tr_close(tracer, &ts);
+            return 1;
+        }
+        sprintf(name, "%s frames=%d param=%d", NAMES[policy], frame_count, param);
+        tr_name(tracer, TRACE_PID, -1, name);
+        tr_name(tracer, TRACE_PID, TRACK_FAULT, "faults");
+        for (int i = 0; i < frame_count; i++) {
+            sprintf(name, "frame %d", i);
+            tr_name(tracer, TRACE_PID, i + 1, name);
+        }
+    }
+    int error = simulate(logical_addrs, ref_count, policy, param, 1, &st);
+    if (!error) {
+        print_stats(ref_count, &st);
+    }
+    if (tracer != NULL) {
+        if (tr_close(tracer, &ts) != 0) {
+            printf("дļ %s \n", path);
+            return 1;
+        }
+        if (!error) {
+            printf("ʱд %s%lld ¼ chrome://tracing  ui.perfetto.dev 򿪣\n",
+                path, ts.events);
+        }
+    }
+    return error;
+}
+
+int main(int argc, char* argv[]) {
+    int ref_count;
+    int logical_addrs[MAX_REF];
+    int policy;
+    int param = 0;
+    Tracer* tracer = NULL;
+
     printf("===== LRU ҳû㷨ģ =====\n");
     printf("ҳСֽڣ");
     if (scanf("%d", &page_size) != 1 || page_size <= 0) {
@@ -80,7 +277,7 @@ int main() {
         return 1;
     }
 
-    printf("֡<= %d", MAX_FRAMES);
+    printf("֡<= %dWS/PFF Ϊפޣ", MAX_FRAMES);
     if (scanf("%d", &frame_count) != 1 || frame_count <= 0 || frame_count > MAX_FRAMES) {
         printf("֡\n");
         return 1;
@@ -104,98 +301,43 @@ int main() {
         }
     }
 
-    int page_faults = 0;
-    int hits = 0;
-    int max_page_index_seen = 0;  // ¼ʹҳţڼ LRU 
-
-    printf("\n===== ʼģ =====\n\n");
-    printf(" | ߼ַ | ҳ | ƫ |     | ̭ҳ | ַ\n");
-    printf("---------------------------------------------------------------\n");
-
-    for (int i = 0; i < ref_count; i++) {
-        int logical_addr = logical_addrs[i];
-        int page = logical_addr / page_size;
-        int offset = logical_addr % page_size;
-
-        if (page >= MAX_PAGES) {
-            printf("ʵҳ %d  MAX_PAGES=%dֹ\n", page, MAX_PAGES);
-            break;
-        }
-        if (page > max_page_index_seen) {
-            max_page_index_seen = page;
-        }
-
-        time_counter++;  // ģʱ
-        int frame = -1;
-        int victim_page = -1;
-        int is_hit = 0;
-
-        if (page_table[page].valid == 1) {
-            // 
-            is_hit = 1;
-            hits++;
-            frame = page_table[page].frame;
-            page_table[page].last_used = time_counter;
-        }
-        else {
-            // ȱҳ
-            page_faults++;
-            int free_frame = find_free_frame();
-            if (free_frame != -1) {
-                // пֱ֡װ
-                frame = free_frame;
-                victim_page = -1; // ûб̭ҳ
-            }
-            else {
-                // ûп֡Ҫû
-                victim_page = find_victim_lru(max_page_index_seen);
-                if (victim_page == -1) {
-                    printf("ڲδҵûҳ\n");
-                    return 1;
-                }
-                frame = page_table[victim_page].frame;
-                // ̭ victim_page
-                page_table[victim_page].valid = 0;
-                page_table[victim_page].frame = -1;
-                page_table[victim_page].last_used = 0;
-            }
+    printf("\nѡפԣ\n");
+    printf("1. LRU̶֡\n");
+    printf("2.  WS ӣ\n");
+    printf("3. ȱҳƵ PFFֵ T\n");
+    printf("4. ɨ裺Ա WS  PFF ȱҳʺƽפ\n");
+    printf("ѡ");
+    if (scanf("%d", &policy) != 1 || policy < 1 || policy > 4) {
+        printf("ѡ\n");
+        return 1;
+    }
 
-            // װҳ
-            page_table[page].valid = 1;
-            page_table[page].frame = frame;
-            page_table[page].last_used = time_counter;
-            phys_mem[frame] = page;
+    if (policy == POLICY_WS) {
+        printf("빤 ӣʴ> 0");
+    }
+    else if (policy == POLICY_PFF) {
+        printf("ȱҳֵ Tʴ> 0");
+    }
+    else if (policy == 4) {
+        printf("ɨֵ> 0");
+    }
+    if (policy != POLICY_LRU) {
+        if (scanf("%d", &param) != 1 || param <= 0) {
+            printf("\n");
+            return 1;
         }
+    }
 
-        int phys_addr = frame * page_size + offset;
+    if (policy == 4) {
+        return sweep_params(logical_addrs, ref_count, param);
+    }
 
-        // ηϢ
-        printf("%3d  | %8d | %3d | %6d | ", i + 1, logical_addr, page, offset);
-        if (is_hit) {
-            printf("   |   --    | %10d\n", phys_addr);
-        }
-        else {
-            if (victim_page == -1) {
-                printf("ȱҳ   |  ֡ | %10d\n", phys_addr);
-            }
-            else {
-                printf("ȱҳ   | %7d | %10d\n", victim_page, phys_addr);
-            }
+    if (argc > 1) {
+        tracer = tr_open(argv[1], 1 << 12);
+        if (tracer == NULL) {
+            printf("޷ļ %s\n", argv[1]);
+            return 1;
         }
-
-        // ӡǰڴ֡
-        print_frames();
-        printf("\n");
     }
-
-    printf("===== ģ =====\n");
-    printf("ܷʴ: %d\n", ref_count);
-    printf("д  : %d\n", hits);
-    printf("ȱҳ  : %d\n", page_faults);
-    double hit_rate = ref_count > 0 ? (double)hits / ref_count : 0.0;
-    double miss_rate = ref_count > 0 ? (double)page_faults / ref_count : 0.0;
-    printf("    : %.4f\n", hit_rate);
-    printf("ȱҳ    : %.4f\n", miss_rate);
-
-    return 0;
+    return run_traced(tracer, argc > 1 ? argv[1] : NULL, logical_addrs, ref_count, policy, param);
 }